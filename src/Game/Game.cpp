@@ -1,19 +1,33 @@
 #include "Game.h"
 
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <initializer_list>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <string_view>
+
 #include "AssetHandlerCommon.h"
+#include "BinaryMap.h"
 #include "Constants.h"
 #include "ConveyorComponent.h"
 #include "ConveyorDefinition.h"
 #include "ConveyorRegistry.h"
+#include "DefinitionCache.h"
 #include "DescriptionComponent.h"
 #include "DirectionComponent.h"
 #include "FactoryComponent.h"
+#include "FactoryDefinition.h"
 #include "FactoryRegistry.h"
 #include "GameMapLoadInterstitialScene.h"
 #include "InserterDefinition.h"
 #include "InserterRegistry.h"
+#include "ItemInputStaging.h"
 #include "ItemDefinition.h"
 #include "ItemRegistry.h"
+#include "LoadGraph.h"
 #include "MapLoadHandler.h"
 #include "ModelComponent.h"
 #include "NameComponent.h"
@@ -23,6 +37,7 @@
 #include "SequenceComponent.h"
 #include "SolarBodyComponent.h"
 #include "StorageComponent.h"
+#include "UIControllerSystem.h"
 #include "WorldEntityInformationComponent.h"
 #include "AtlasGame/GameHost.h"
 #include "AtlasGame/Scene/Components/PositionComponent.h"
@@ -39,6 +54,12 @@
 
 using namespace cpp_conv::resources;
 
+namespace
+{
+    // Set by --load-save, to start from a save game instead of the default map.
+    std::filesystem::path g_SaveGamePath;
+}
+
 void registerComponents()
 {
     using namespace atlas::resource;
@@ -63,6 +84,7 @@ void registerComponents()
     ComponentRegistry::RegisterComponent<ModelComponent>();
     ComponentRegistry::RegisterComponent<WorldEntityInformationComponent>();
     ComponentRegistry::RegisterComponent<StorageComponent>();
+    ComponentRegistry::RegisterComponent<ItemInputStaging>();
     ComponentRegistry::RegisterComponent<DirectionalLightComponent>();
 }
 
@@ -97,15 +119,132 @@ void registerTypeHandlers()
     ResourceLoader::RegisterTypeHandler<atlas::render::TextureAsset>(atlas::render::textureLoadHandler);
     ResourceLoader::RegisterTypeHandler<atlas::render::ModelAsset>(atlas::render::modelLoadHandler);
     ResourceLoader::RegisterTypeHandler<atlas::render::MeshAsset>(atlas::render::meshLoadHandler);
+
+    cpp_conv::registerUiTypeHandlers();
 }
 
-void loadDataAssets()
+// Loads assets from the core bundle one at a time, each under the resource loader's lock so that the other steps'
+// loads can interleave with them.
+template<typename TAsset>
+void loadCoreAssets(
+    const std::initializer_list<atlas::resource::RegistryId> assets,
+    std::vector<atlas::resource::AssetPtr<atlas::resource::ResourceAsset>>& vOutAssets)
 {
-    loadConveyors();
-    loadFactories();
-    loadInserters();
-    loadItems();
-    loadRecipes();
+    using atlas::resource::ResourceLoader;
+    for (const atlas::resource::RegistryId asset : assets)
+    {
+        std::scoped_lock lock{getResourceLoaderMutex()};
+        if (auto pAsset = ResourceLoader::LoadAsset<registry::CoreBundle, TAsset>(asset))
+        {
+            vOutAssets.push_back(std::move(pAsset));
+        }
+    }
+}
+
+// Loads the definitions, the models they refer to, and the shaders, textures and fonts that the scenes use, so that
+// they are not loaded on first use. The assets are returned to keep them alive.
+std::vector<atlas::resource::AssetPtr<atlas::resource::ResourceAsset>> loadStartupAssets()
+{
+    using atlas::render::ModelAsset;
+    using atlas::render::ShaderProgram;
+    using atlas::render::TextureAsset;
+    using atlas::resource::ResourceLoader;
+    namespace core_bundle = registry::core_bundle;
+
+    DefinitionCache& cache = getDefinitionCache();
+    cache.Open(cpp_conv::constants::definition_cache::c_szPath);
+
+    // Only the main thread's steps add to vAssets. The fonts are loaded on a worker, and added once the graph has run.
+    std::vector<atlas::resource::AssetPtr<atlas::resource::ResourceAsset>> vAssets;
+    std::vector<atlas::resource::AssetPtr<atlas::resource::ResourceAsset>> vFonts;
+    LoadGraph graph;
+    graph.Add("conveyor definitions", loadConveyors);
+    const LoadGraph::StepId factories = graph.Add("factory definitions", loadFactories);
+    graph.Add("inserter definitions", loadInserters);
+    const LoadGraph::StepId items = graph.Add("item definitions", loadItems);
+    // Recipes are compiled against the item indices.
+    graph.Add("recipe definitions", loadRecipes, {items});
+    graph.Add(
+        "fonts",
+        [&vFonts]
+        {
+            std::scoped_lock lock{getResourceLoaderMutex()};
+            vFonts = cpp_conv::loadUiFonts();
+        });
+
+    // Shaders, textures and models create GPU resources, so they are loaded on the main thread. The definition steps
+    // only hold the resource loader's lock while they read their sources, so these run alongside their parsing.
+    graph.Add(
+        "shaders",
+        [&vAssets]
+        {
+            loadCoreAssets<ShaderProgram>(
+                {
+                    core_bundle::shaders::c_planet,
+                    core_bundle::shaders::c_shadowMapBasic,
+                    core_bundle::shaders::postprocess::c_copy,
+                    core_bundle::shaders::postprocess::c_fxaa,
+                    core_bundle::shaders::postprocess::c_vignette,
+                    core_bundle::shaders::ui::c_rmlui_basic_textured,
+                    core_bundle::shaders::ui::c_rmlui_basic_untextured
+                },
+                vAssets);
+        },
+        {},
+        LoadGraph::Affinity::MainThread);
+    graph.Add(
+        "textures",
+        [&vAssets]
+        {
+            loadCoreAssets<TextureAsset>(
+                {
+                    core_bundle::assets::textures::planets::c_Asteroid_Diffuse,
+                    core_bundle::assets::textures::planets::c_Asteroid_Normal
+                },
+                vAssets);
+        },
+        {},
+        LoadGraph::Affinity::MainThread);
+    graph.Add(
+        "factory models",
+        [&vAssets]
+        {
+            for (const cpp_conv::FactoryDefinition* pFactory : getFactoryDefinitions())
+            {
+                std::unique_lock lock{getResourceLoaderMutex()};
+                atlas::resource::AssetPtr<ModelAsset> pModel = pFactory->GetModel();
+                lock.unlock();
+                if (pModel)
+                {
+                    vAssets.push_back(std::move(pModel));
+                }
+            }
+        },
+        {factories},
+        LoadGraph::Affinity::MainThread);
+    graph.Add(
+        "item models",
+        [&vAssets]
+        {
+            for (uint32_t uiIndex = 1; uiIndex < getItemIndexCount(); ++uiIndex)
+            {
+                const cpp_conv::ItemDefinition* pItem =
+                    getItemDefinition(cpp_conv::ItemIndex{static_cast<uint16_t>(uiIndex)});
+                if (pItem && pItem->GetAssetId().IsValid())
+                {
+                    std::scoped_lock lock{getResourceLoaderMutex()};
+                    vAssets.push_back(ResourceLoader::LoadAsset<ModelAsset>(pItem->GetAssetId()));
+                }
+            }
+        },
+        {items},
+        LoadGraph::Affinity::MainThread);
+
+    graph.Run();
+    graph.Report(std::cout);
+    cache.Close();
+    vAssets.insert(vAssets.end(), vFonts.begin(), vFonts.end());
+    return vAssets;
 }
 
 void setBgfxSettings()
@@ -125,16 +264,65 @@ public:
         registerComponents();
         registerTypeHandlers();
         registerAssetBundles();
-        loadDataAssets();
+        m_vStartupAssets = loadStartupAssets();
         setBgfxSettings();
 
+        if (!g_SaveGamePath.empty())
+        {
+            m_SceneManager.TransitionTo<cpp_conv::GameMapLoadInterstitialScene>(g_SaveGamePath);
+            return;
+        }
+
         m_SceneManager.TransitionTo<cpp_conv::GameMapLoadInterstitialScene>(
             ResourceLoader::CreateBundleRegistryId<registry::CoreBundle>(registry::core_bundle::maps::c_simple));
     }
+
+private:
+    std::vector<atlas::resource::AssetPtr<atlas::resource::ResourceAsset>> m_vStartupAssets;
 };
 
+// Converts a text map to the binary map format: --convert-map <input.txt> <output>
+int convertMap(const char* szInputPath, const char* szOutputPath)
+{
+    // This runs instead of the game, so the factory definitions that size the factory glyphs are loaded here.
+    registerTypeHandlers();
+    registerAssetBundles();
+    loadFactories();
+
+    std::ifstream input(szInputPath, std::ios::binary);
+    if (!input)
+    {
+        std::cerr << std::format("Could not open {}\n", szInputPath);
+        return 1;
+    }
+
+    const std::vector<uint8_t> vText{std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+
+    std::string errors;
+    const std::optional<std::vector<uint8_t>> binary = convertTextMap(vText, &errors);
+    if (!binary)
+    {
+        std::cerr << errors;
+        return 1;
+    }
+
+    std::ofstream output(szOutputPath, std::ios::binary);
+    output.write(reinterpret_cast<const char*>(binary->data()), static_cast<std::streamsize>(binary->size()));
+    return output ? 0 : 1;
+}
+
 int gameMain(int argc, char* argv[])
 {
+    if (argc == 4 && std::string_view(argv[1]) == "--convert-map")
+    {
+        return convertMap(argv[2], argv[3]);
+    }
+
+    if (argc == 3 && std::string_view(argv[1]) == "--load-save")
+    {
+        g_SaveGamePath = argv[2];
+    }
+
     atlas::game::GameHost<CppConveyor> game{{"Transportadoras", 30}};
     return game.Run();
 }
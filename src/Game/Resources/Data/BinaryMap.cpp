@@ -0,0 +1,407 @@
+#include "BinaryMap.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <format>
+#include <map>
+#include <string_view>
+
+#include "EntityLookupGrid.h"
+#include "Factory.h"
+#include "Inserter.h"
+#include "Map.h"
+#include "MapLoadHandler.h"
+#include "Stairs.h"
+#include "Storage.h"
+#include "Tunnel.h"
+
+namespace
+{
+    using namespace cpp_conv::resources::binary_map;
+    using cpp_conv::resources::BinaryMapEntity;
+
+    struct EntityRow
+    {
+        int32_t m_iChunkX;
+        int32_t m_iChunkY;
+        BinaryMapEntity m_Entity;
+    };
+
+    // Inserters report themselves as conveyors.
+    EntityKind getEntityKind(const cpp_conv::Entity& entity)
+    {
+        return dynamic_cast<const cpp_conv::Inserter*>(&entity) ? EntityKind::Inserter : entity.m_eEntityKind;
+    }
+
+    BinaryMapEntity makeRow(const cpp_conv::Entity& entity, const EntityKind kind)
+    {
+        using namespace cpp_conv;
+
+        // Several entity types keep their facing outside Entity.
+        BinaryMapEntity row{};
+        row.m_Kind = kind;
+        row.m_Position = entity.m_position;
+        row.m_Size = entity.m_size;
+        row.m_uiDirection = static_cast<uint8_t>(entity.m_Direction);
+
+        switch (kind)
+        {
+        case EntityKind::Inserter:
+            {
+                const auto& inserter = static_cast<const Inserter&>(entity);
+                row.m_uiDirection = static_cast<uint8_t>(inserter.GetDirection());
+                row.m_uiDefinition = inserter.GetInserterId().m_uiItemId;
+                break;
+            }
+        case EntityKind::Producer:
+            row.m_uiDefinition = static_cast<const Factory&>(entity).GetDefinitionId().m_uiItemId;
+            break;
+        case EntityKind::Storage:
+            {
+                const auto& container = static_cast<const Storage&>(entity).GetContainer();
+                row.m_uiCapacity = container.GetMaxCapacity();
+                row.m_uiStackSize = container.GetMaxStackSize();
+                break;
+            }
+        case EntityKind::Tunnel:
+            row.m_uiDirection = static_cast<uint8_t>(static_cast<const Tunnel&>(entity).GetDirection());
+            break;
+        case EntityKind::Stairs:
+            row.m_uiDirection = static_cast<uint8_t>(static_cast<const Stairs&>(entity).GetDirection());
+            break;
+        default:
+            break;
+        }
+
+        return row;
+    }
+
+    bool hasColumn(const EntityKind kind, const Column column)
+    {
+        switch (column)
+        {
+        case Column::Definition: return kind == EntityKind::Producer || kind == EntityKind::Inserter;
+        case Column::Capacity:
+        case Column::StackSize: return kind == EntityKind::Storage;
+        default: return true;
+        }
+    }
+
+    uint64_t alignOffset(const uint64_t uiOffset)
+    {
+        return (uiOffset + c_uiColumnAlignment - 1) & ~static_cast<uint64_t>(c_uiColumnAlignment - 1);
+    }
+
+    template <typename TValue>
+    void writeAt(std::vector<uint8_t>& vData, const uint64_t uiOffset, const TValue& value)
+    {
+        std::memcpy(vData.data() + uiOffset, &value, sizeof(TValue));
+    }
+
+    template <typename TValue>
+    bool tryGetSpan(
+        const std::span<const uint8_t> data,
+        const uint64_t uiOffset,
+        const uint64_t uiCount,
+        std::span<const TValue>& outSpan)
+    {
+        if (uiOffset % alignof(TValue) != 0 ||
+            uiOffset > data.size() ||
+            uiCount > (data.size() - uiOffset) / sizeof(TValue))
+        {
+            return false;
+        }
+
+        outSpan = {reinterpret_cast<const TValue*>(data.data() + uiOffset), static_cast<size_t>(uiCount)};
+        return true;
+    }
+}
+
+bool cpp_conv::resources::BinaryMapView::IsBinaryMap(const std::span<const uint8_t> data)
+{
+    return data.size() >= c_Magic.size() && std::memcmp(data.data(), c_Magic.data(), c_Magic.size()) == 0;
+}
+
+std::optional<cpp_conv::resources::BinaryMapView> cpp_conv::resources::BinaryMapView::Create(
+    const std::span<const uint8_t> data,
+    std::string* pErrors)
+{
+    const auto fail = [pErrors](const std::string_view reason) -> std::optional<BinaryMapView>
+    {
+        if (pErrors)
+        {
+            *pErrors += std::format("Invalid binary map: {}\n", reason);
+        }
+
+        return {};
+    };
+
+    std::span<const FileHeader> header;
+    if (!IsBinaryMap(data) || !tryGetSpan(data, 0, 1, header))
+    {
+        return fail("missing header");
+    }
+
+    if (header[0].m_uiVersion != c_uiVersion)
+    {
+        return fail(std::format("unsupported version {}", header[0].m_uiVersion));
+    }
+
+    BinaryMapView view;
+    std::span<const SectionHeader> sections;
+    if (!tryGetSpan(data, header[0].m_uiSectionTableOffset, header[0].m_uiSectionCount, sections) ||
+        !tryGetSpan(data, header[0].m_uiChunkTableOffset, header[0].m_uiChunkCount, view.m_Chunks))
+    {
+        return fail("table out of range");
+    }
+
+    view.m_vSections.reserve(sections.size());
+    for (const SectionHeader& sectionHeader : sections)
+    {
+        if (sectionHeader.m_uiEntityKind >= static_cast<uint32_t>(EntityKind::MAX))
+        {
+            return fail(std::format("unknown entity kind {}", sectionHeader.m_uiEntityKind));
+        }
+
+        BinaryMapSection& section = view.m_vSections.emplace_back();
+        section.m_Kind = static_cast<EntityKind>(sectionHeader.m_uiEntityKind);
+        section.m_uiCount = static_cast<size_t>(sectionHeader.m_uiEntityCount);
+
+        const auto readColumn = [&]<typename TValue>(const Column column, std::span<const TValue>& outSpan, const bool bRequired)
+        {
+            const uint64_t uiOffset = sectionHeader.m_ColumnOffsets[static_cast<uint32_t>(column)];
+            if (uiOffset == 0)
+            {
+                return !bRequired;
+            }
+
+            return tryGetSpan(data, uiOffset, sectionHeader.m_uiEntityCount, outSpan);
+        };
+
+        if (!readColumn(Column::PositionX, section.m_PositionX, true) ||
+            !readColumn(Column::PositionY, section.m_PositionY, true) ||
+            !readColumn(Column::PositionZ, section.m_PositionZ, true) ||
+            !readColumn(Column::SizeX, section.m_SizeX, false) ||
+            !readColumn(Column::SizeY, section.m_SizeY, false) ||
+            !readColumn(Column::SizeZ, section.m_SizeZ, false) ||
+            !readColumn(Column::Direction, section.m_Direction, false) ||
+            !readColumn(Column::Definition, section.m_Definition, false) ||
+            !readColumn(Column::Capacity, section.m_Capacity, false) ||
+            !readColumn(Column::StackSize, section.m_StackSize, false))
+        {
+            return fail("column out of range");
+        }
+
+        // Directions are cast straight back to the enum, so anything that is not one of its single bits is rejected.
+        const auto itDirection = std::ranges::find_if(section.m_Direction, [](const uint8_t uiDirection)
+        {
+            return !std::has_single_bit(uiDirection) || uiDirection > static_cast<uint8_t>(Direction::Right);
+        });
+        if (itDirection != section.m_Direction.end())
+        {
+            return fail(std::format("invalid direction {}", *itDirection));
+        }
+    }
+
+    for (const ChunkRecord& chunk : view.m_Chunks)
+    {
+        if (chunk.m_uiSection >= view.m_vSections.size() ||
+            chunk.m_uiFirstEntity > view.m_vSections[chunk.m_uiSection].m_uiCount ||
+            chunk.m_uiEntityCount > view.m_vSections[chunk.m_uiSection].m_uiCount - chunk.m_uiFirstEntity)
+        {
+            return fail("chunk range out of range");
+        }
+    }
+
+    return view;
+}
+
+size_t cpp_conv::resources::BinaryMapView::GetEntityCount() const
+{
+    size_t uiCount = 0;
+    for (const BinaryMapSection& section : m_vSections)
+    {
+        uiCount += section.m_uiCount;
+    }
+
+    return uiCount;
+}
+
+std::vector<uint8_t> cpp_conv::resources::writeBinaryMap(const Map& map)
+{
+    std::vector<BinaryMapEntity> vEntities;
+    vEntities.reserve(map.GetConveyors().size() + map.GetOtherEntities().size());
+    const auto addEntity = [&vEntities](const Entity& entity)
+    {
+        vEntities.push_back(makeRow(entity, getEntityKind(entity)));
+    };
+
+    std::ranges::for_each(map.GetConveyors(), [&](const Conveyor* pEntity) { addEntity(*pEntity); });
+    std::ranges::for_each(map.GetOtherEntities(), [&](const Entity* pEntity) { addEntity(*pEntity); });
+    return writeBinaryMap(vEntities);
+}
+
+std::vector<uint8_t> cpp_conv::resources::writeBinaryMap(const std::span<const BinaryMapEntity> entities)
+{
+    // Ordered by kind, so the section order is stable between runs.
+    std::map<EntityKind, std::vector<EntityRow>> rowsByKind;
+    for (const BinaryMapEntity& entity : entities)
+    {
+        rowsByKind[entity.m_Kind].push_back({
+            entity.m_Position.x() >> EntityLookupGrid::c_iChunkShift,
+            entity.m_Position.z() >> EntityLookupGrid::c_iChunkShift,
+            entity});
+    }
+
+    std::vector<ChunkRecord> vChunks;
+    uint32_t uiSection = 0;
+    for (auto& [kind, vRows] : rowsByKind)
+    {
+        std::ranges::stable_sort(vRows, [](const EntityRow& lhs, const EntityRow& rhs)
+        {
+            const Eigen::Vector3i& lhsPosition = lhs.m_Entity.m_Position;
+            const Eigen::Vector3i& rhsPosition = rhs.m_Entity.m_Position;
+            return std::tuple{lhsPosition.y(), lhs.m_iChunkY, lhs.m_iChunkX, lhsPosition.z(), lhsPosition.x()} <
+                std::tuple{rhsPosition.y(), rhs.m_iChunkY, rhs.m_iChunkX, rhsPosition.z(), rhsPosition.x()};
+        });
+
+        for (size_t i = 0; i < vRows.size(); ++i)
+        {
+            const EntityRow& row = vRows[i];
+            if (vChunks.empty() ||
+                vChunks.back().m_uiSection != uiSection ||
+                vChunks.back().m_iChunkX != row.m_iChunkX ||
+                vChunks.back().m_iChunkY != row.m_iChunkY ||
+                vChunks.back().m_iFloor != row.m_Entity.m_Position.y())
+            {
+                vChunks.push_back({row.m_iChunkX, row.m_iChunkY, row.m_Entity.m_Position.y(), uiSection, i, 0});
+            }
+
+            vChunks.back().m_uiEntityCount++;
+        }
+
+        uiSection++;
+    }
+
+    FileHeader header{};
+    header.m_Magic = c_Magic;
+    header.m_uiVersion = c_uiVersion;
+    header.m_uiSectionCount = static_cast<uint32_t>(rowsByKind.size());
+    header.m_uiChunkCount = static_cast<uint32_t>(vChunks.size());
+    header.m_uiSectionTableOffset = sizeof(FileHeader);
+    header.m_uiChunkTableOffset = header.m_uiSectionTableOffset + header.m_uiSectionCount * sizeof(SectionHeader);
+
+    // Lay out the columns after the tables.
+    uint64_t uiOffset = header.m_uiChunkTableOffset + header.m_uiChunkCount * sizeof(ChunkRecord);
+    std::vector<SectionHeader> vSections;
+    for (const auto& [kind, vRows] : rowsByKind)
+    {
+        SectionHeader& section = vSections.emplace_back();
+        section.m_uiEntityKind = static_cast<uint32_t>(kind);
+        section.m_uiEntityCount = vRows.size();
+        for (uint32_t uiColumn = 0; uiColumn < c_uiColumnCount; ++uiColumn)
+        {
+            const auto column = static_cast<Column>(uiColumn);
+            if (!hasColumn(kind, column))
+            {
+                continue;
+            }
+
+            uiOffset = alignOffset(uiOffset);
+            section.m_ColumnOffsets[uiColumn] = uiOffset;
+            uiOffset += vRows.size() * getColumnElementSize(column);
+        }
+    }
+
+    std::vector<uint8_t> vData(alignOffset(uiOffset), 0);
+    writeAt(vData, 0, header);
+    for (size_t i = 0; i < vSections.size(); ++i)
+    {
+        writeAt(vData, header.m_uiSectionTableOffset + i * sizeof(SectionHeader), vSections[i]);
+    }
+
+    for (size_t i = 0; i < vChunks.size(); ++i)
+    {
+        writeAt(vData, header.m_uiChunkTableOffset + i * sizeof(ChunkRecord), vChunks[i]);
+    }
+
+    uiSection = 0;
+    for (const auto& [kind, vRows] : rowsByKind)
+    {
+        const SectionHeader& section = vSections[uiSection++];
+        const auto writeColumn = [&](const Column column, auto getValue)
+        {
+            const uint64_t uiColumnOffset = section.m_ColumnOffsets[static_cast<uint32_t>(column)];
+            if (uiColumnOffset == 0)
+            {
+                return;
+            }
+
+            for (size_t i = 0; i < vRows.size(); ++i)
+            {
+                const auto value = getValue(vRows[i]);
+                writeAt(vData, uiColumnOffset + i * sizeof(value), value);
+            }
+        };
+
+        writeColumn(Column::PositionX, [](const EntityRow& row) { return row.m_Entity.m_Position.x(); });
+        writeColumn(Column::PositionY, [](const EntityRow& row) { return row.m_Entity.m_Position.y(); });
+        writeColumn(Column::PositionZ, [](const EntityRow& row) { return row.m_Entity.m_Position.z(); });
+        writeColumn(Column::SizeX, [](const EntityRow& row) { return row.m_Entity.m_Size.x(); });
+        writeColumn(Column::SizeY, [](const EntityRow& row) { return row.m_Entity.m_Size.y(); });
+        writeColumn(Column::SizeZ, [](const EntityRow& row) { return row.m_Entity.m_Size.z(); });
+        writeColumn(Column::Direction, [](const EntityRow& row) { return row.m_Entity.m_uiDirection; });
+        writeColumn(Column::Definition, [](const EntityRow& row) { return row.m_Entity.m_uiDefinition; });
+        writeColumn(Column::Capacity, [](const EntityRow& row) { return row.m_Entity.m_uiCapacity; });
+        writeColumn(Column::StackSize, [](const EntityRow& row) { return row.m_Entity.m_uiStackSize; });
+    }
+
+    return vData;
+}
+
+void cpp_conv::resources::readBinaryMap(const BinaryMapView& view, std::vector<BinaryMapEntity>& vOutEntities)
+{
+    const auto getValue = []<typename TValue>(const std::span<const TValue> column, const size_t uiIndex)
+    {
+        return column.empty() ? TValue{} : column[uiIndex];
+    };
+
+    vOutEntities.reserve(vOutEntities.size() + view.GetEntityCount());
+    for (const BinaryMapSection& section : view.GetSections())
+    {
+        for (size_t i = 0; i < section.m_uiCount; ++i)
+        {
+            BinaryMapEntity& entity = vOutEntities.emplace_back();
+            entity.m_Kind = section.m_Kind;
+            entity.m_Position = {section.m_PositionX[i], section.m_PositionY[i], section.m_PositionZ[i]};
+            entity.m_Size = {getValue(section.m_SizeX, i), getValue(section.m_SizeY, i), getValue(section.m_SizeZ, i)};
+            entity.m_uiDirection = getValue(section.m_Direction, i);
+            entity.m_uiDefinition = getValue(section.m_Definition, i);
+            entity.m_uiCapacity = getValue(section.m_Capacity, i);
+            entity.m_uiStackSize = getValue(section.m_StackSize, i);
+        }
+    }
+}
+
+std::optional<std::vector<uint8_t>> cpp_conv::resources::convertTextMap(const std::span<const uint8_t> textData,
+                                                                        std::string* pErrors)
+{
+    if (BinaryMapView::IsBinaryMap(textData))
+    {
+        if (pErrors)
+        {
+            *pErrors += "Map is already in the binary format\n";
+        }
+
+        return {};
+    }
+
+    Map map;
+    if (!parseTextMap(std::string_view(reinterpret_cast<const char*>(textData.data()), textData.size()), map, pErrors))
+    {
+        return {};
+    }
+
+    return writeBinaryMap(map);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "BinaryMapFormat.h"
+#include "Enums.h"
+#include "Eigen/Core"
+
+namespace cpp_conv::resources
+{
+    class Map;
+
+    // One entity kind's columns, read in place from the file. Optional columns are empty when absent.
+    struct BinaryMapSection
+    {
+        EntityKind m_Kind;
+        size_t m_uiCount;
+
+        std::span<const int32_t> m_PositionX;
+        std::span<const int32_t> m_PositionY;
+        std::span<const int32_t> m_PositionZ;
+        std::span<const int32_t> m_SizeX;
+        std::span<const int32_t> m_SizeY;
+        std::span<const int32_t> m_SizeZ;
+        std::span<const uint8_t> m_Direction;
+        std::span<const uint64_t> m_Definition;
+        std::span<const uint32_t> m_Capacity;
+        std::span<const uint32_t> m_StackSize;
+    };
+
+    // Validated view over a binary map held in memory. It does not own the data, which must outlive it.
+    class BinaryMapView
+    {
+    public:
+        [[nodiscard]] static bool IsBinaryMap(std::span<const uint8_t> data);
+        [[nodiscard]] static std::optional<BinaryMapView> Create(std::span<const uint8_t> data, std::string* pErrors);
+
+        [[nodiscard]] const std::vector<BinaryMapSection>& GetSections() const { return m_vSections; }
+        [[nodiscard]] std::span<const binary_map::ChunkRecord> GetChunks() const { return m_Chunks; }
+        [[nodiscard]] size_t GetEntityCount() const;
+
+    private:
+        std::vector<BinaryMapSection> m_vSections;
+        std::span<const binary_map::ChunkRecord> m_Chunks;
+    };
+
+    // One entity as the writer takes it. Columns the entity's kind does not carry are ignored.
+    struct BinaryMapEntity
+    {
+        EntityKind m_Kind;
+        Eigen::Vector3i m_Position;
+        Eigen::Vector3i m_Size;
+        uint8_t m_uiDirection;
+        uint64_t m_uiDefinition;
+        uint32_t m_uiCapacity;
+        uint32_t m_uiStackSize;
+    };
+
+    // Serialises the entities of a map into the binary format.
+    std::vector<uint8_t> writeBinaryMap(const Map& map);
+    std::vector<uint8_t> writeBinaryMap(std::span<const BinaryMapEntity> entities);
+
+    // Appends a binary map's entities, as the writer takes them. Columns the map leaves out read as zero, so this is
+    // meant for maps that writeBinaryMap wrote, which leave out none that an entity's kind carries.
+    void readBinaryMap(const BinaryMapView& view, std::vector<BinaryMapEntity>& vOutEntities);
+
+    // Converts a text glyph map into the binary format.
+    std::optional<std::vector<uint8_t>> convertTextMap(std::span<const uint8_t> textData, std::string* pErrors);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace cpp_conv::resources::binary_map
+{
+    // On-disk layout of a binary map. Everything is little endian, offsets are bytes from the start of the file and
+    // every column starts on an 8 byte boundary so that it can be read in place.
+    //
+    //   FileHeader
+    //   SectionHeader[m_uiSectionCount]   one per entity kind, each pointing at that kind's columns
+    //   ChunkRecord[m_uiChunkCount]       the entity ranges of each section that fall in each grid chunk
+    //   column data
+    //
+    // Within a section, entities are ordered by chunk, so each chunk's entities are one contiguous range.
+
+    inline constexpr std::array<char, 4> c_Magic = {'C', 'P', 'M', 'B'};
+    inline constexpr uint32_t c_uiVersion = 2;
+    inline constexpr uint32_t c_uiColumnAlignment = 8;
+
+    enum class Column : uint32_t
+    {
+        PositionX,  // int32_t
+        PositionY,  // int32_t, the floor
+        PositionZ,  // int32_t
+        SizeX,      // int32_t
+        SizeY,      // int32_t
+        SizeZ,      // int32_t
+        Direction,  // uint8_t, a Direction
+        Definition, // uint64_t, the factory/inserter id for kinds that have one
+        Capacity,   // uint32_t
+        StackSize,  // uint32_t
+        Count
+    };
+
+    inline constexpr uint32_t c_uiColumnCount = static_cast<uint32_t>(Column::Count);
+
+    constexpr uint32_t getColumnElementSize(const Column column)
+    {
+        switch (column)
+        {
+        case Column::Direction: return sizeof(uint8_t);
+        case Column::Definition: return sizeof(uint64_t);
+        default: return sizeof(int32_t);
+        }
+    }
+
+    struct FileHeader
+    {
+        std::array<char, 4> m_Magic;
+        uint32_t m_uiVersion;
+        uint32_t m_uiSectionCount;
+        uint32_t m_uiChunkCount;
+        uint64_t m_uiSectionTableOffset;
+        uint64_t m_uiChunkTableOffset;
+    };
+
+    struct SectionHeader
+    {
+        uint32_t m_uiEntityKind;
+        uint32_t m_uiPadding;
+        uint64_t m_uiEntityCount;
+        // Zero for columns the section does not carry. Positions are always present.
+        std::array<uint64_t, c_uiColumnCount> m_ColumnOffsets;
+    };
+
+    struct ChunkRecord
+    {
+        int32_t m_iChunkX;
+        int32_t m_iChunkY;
+        int32_t m_iFloor;
+        uint32_t m_uiSection;
+        uint64_t m_uiFirstEntity;
+        uint64_t m_uiEntityCount;
+    };
+
+    static_assert(sizeof(FileHeader) % c_uiColumnAlignment == 0);
+    static_assert(sizeof(SectionHeader) % c_uiColumnAlignment == 0);
+    static_assert(sizeof(ChunkRecord) % c_uiColumnAlignment == 0);
+}
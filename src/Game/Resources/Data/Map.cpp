@@ -7,6 +7,7 @@ using cpp_conv::Conveyor;
 using cpp_conv::resources::Map;
 
 Map::Map()
+    : m_EntityArena{64 * 1024}
 {
 }
 
@@ -30,16 +31,40 @@ std::vector<Conveyor*>& Map::GetConveyors()
     return m_vConveyors;
 }
 
+std::pmr::memory_resource& Map::CreateArena()
+{
+    return *m_vArenas.emplace_back(std::make_unique<std::pmr::monotonic_buffer_resource>(64 * 1024));
+}
+
+bool Map::AdoptBinaryData(std::vector<uint8_t> vData, std::string* pErrors)
+{
+    m_vBinaryData = std::move(vData);
+    m_pBinaryFile.reset();
+    m_BinaryData = m_vBinaryData;
+    m_BinaryView = cpp_conv::resources::BinaryMapView::Create(m_BinaryData, pErrors);
+    return m_BinaryView.has_value();
+}
+
+bool Map::AdoptBinaryData(std::unique_ptr<uint8_t[]> pData, const size_t uiSize, std::string* pErrors)
+{
+    m_pBinaryFile = std::move(pData);
+    m_vBinaryData.clear();
+    m_BinaryData = {m_pBinaryFile.get(), uiSize};
+    m_BinaryView = cpp_conv::resources::BinaryMapView::Create(m_BinaryData, pErrors);
+    return m_BinaryView.has_value();
+}
+
 Map::~Map()
 {
+    // The arena only releases memory, so run the destructors first.
     for (const Conveyor* pConveyor : m_vConveyors)
     {
-        delete pConveyor;
+        pConveyor->~Conveyor();
     }
 
     for (const Entity* pEntity : m_vOtherEntities)
     {
-        delete pEntity;
+        pEntity->~Entity();
     }
 
     m_vConveyors.clear();
@@ -1,8 +1,14 @@
 #pragma once
 
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
 #include <vector>
 
 #include <AtlasResource/ResourceAsset.h>
+#include "BinaryMap.h"
 #include "Conveyor.h"
 
 namespace cpp_conv::resources
@@ -13,14 +19,47 @@ namespace cpp_conv::resources
         Map();
         ~Map() override;
 
+        // Constructs an entity in the map's arena. The map owns it and destroys it along with the arena.
+        template <typename TEntity, typename... TArgs>
+        TEntity* CreateEntity(TArgs&&... args)
+        {
+            return CreateEntityIn<TEntity>(m_EntityArena, std::forward<TArgs>(args)...);
+        }
+
+        // Further arenas owned by the map, so that several threads can construct entities at once, one arena each.
+        std::pmr::memory_resource& CreateArena();
+
+        template <typename TEntity, typename... TArgs>
+        static TEntity* CreateEntityIn(std::pmr::memory_resource& arena, TArgs&&... args)
+        {
+            std::pmr::polymorphic_allocator<> allocator{&arena};
+            return allocator.new_object<TEntity>(std::forward<TArgs>(args)...);
+        }
+
         std::vector<Conveyor*>& GetConveyors();
         std::vector<Entity*>& GetOtherEntities();
 
         [[nodiscard]] const std::vector<Conveyor*>& GetConveyors() const;
         [[nodiscard]] const std::vector<Entity*>& GetOtherEntities() const;
 
+        // Binary maps keep their file image and are read in place through the view, rather than being expanded into
+        // entity objects.
+        bool AdoptBinaryData(std::vector<uint8_t> vData, std::string* pErrors);
+        bool AdoptBinaryData(std::unique_ptr<uint8_t[]> pData, size_t uiSize, std::string* pErrors);
+        [[nodiscard]] const BinaryMapView* GetBinaryView() const { return m_BinaryView ? &*m_BinaryView : nullptr; }
+        [[nodiscard]] std::span<const uint8_t> GetBinaryData() const { return m_BinaryData; }
+
     private:
+        std::pmr::monotonic_buffer_resource m_EntityArena;
+        std::vector<std::unique_ptr<std::pmr::monotonic_buffer_resource>> m_vArenas;
+
         std::vector<Conveyor*> m_vConveyors;
         std::vector<Entity*> m_vOtherEntities;
+
+        // Whichever of the two was adopted owns the data m_BinaryData points at.
+        std::vector<uint8_t> m_vBinaryData;
+        std::unique_ptr<uint8_t[]> m_pBinaryFile;
+        std::span<const uint8_t> m_BinaryData;
+        std::optional<BinaryMapView> m_BinaryView;
     };
 }
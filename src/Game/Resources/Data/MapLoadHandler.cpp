@@ -1,123 +1,446 @@
 #include "MapLoadHandler.h"
 
-#include <cassert>
+#include <algorithm>
+#include <array>
+#include <execution>
+#include <format>
+#include <iostream>
+#include <memory_resource>
+#include <span>
+#include <string_view>
+#include <vector>
 
+#include "BinaryMap.h"
 #include "Conveyor.h"
 #include "Entity.h"
 #include "Factory.h"
+#include "FactoryRegistry.h"
 #include "ItemRegistry.h"
 #include "Junction.h"
 #include "Map.h"
 #include "Storage.h"
 #include "Tunnel.h"
 
-#include <iostream>
-#include <sstream>
 #include "Inserter.h"
 #include "LaunchPad.h"
 #include "Stairs.h"
 #include "AtlasResource/FileData.h"
 
-atlas::resource::AssetPtr<atlas::resource::ResourceAsset> cpp_conv::resources::mapAssetHandler(const atlas::resource::FileData& rData)
+namespace
 {
-    const auto pStrData = reinterpret_cast<const char*>(rData.m_pData.get());
+    enum class GlyphKind : uint8_t
+    {
+        None,
+        Conveyor,
+        Inserter,
+        Factory,
+        Junction,
+        Storage,
+        Stairs,
+        Tunnel,
+        LaunchPad,
+    };
+
+    enum class GlyphFactory : uint8_t
+    {
+        CopperMine,
+        CopperSmelter,
+    };
 
-    const auto pTruncatedData = std::string_view(pStrData, static_cast<uint32_t>(rData.m_Size));
-    auto ss = std::istringstream(std::string(pTruncatedData));
+    struct Glyph
+    {
+        GlyphKind m_Kind = GlyphKind::None;
+        Direction m_Direction = Direction::Right;
+        GlyphFactory m_Factory = GlyphFactory::CopperMine;
+    };
 
-    std::vector<std::string> grid;
+    constexpr std::array<Glyph, 256> c_Glyphs = []
+    {
+        std::array<Glyph, 256> glyphs{};
+        const auto set = [&glyphs](const char cGlyph, const GlyphKind kind, const Direction direction = Direction::Right,
+                                   const GlyphFactory factory = GlyphFactory::CopperMine)
+        {
+            glyphs[static_cast<unsigned char>(cGlyph)] = {kind, direction, factory};
+        };
 
-    atlas::resource::AssetPtr<Map> pMap {new Map()};
+        set('>', GlyphKind::Conveyor, Direction::Right);
+        set('<', GlyphKind::Conveyor, Direction::Left);
+        set('^', GlyphKind::Conveyor, Direction::Down);
+        set('v', GlyphKind::Conveyor, Direction::Up);
+        set('I', GlyphKind::Inserter, Direction::Down);
+        set('U', GlyphKind::Inserter, Direction::Up);
+        set('T', GlyphKind::Inserter, Direction::Left);
+        set('Y', GlyphKind::Inserter, Direction::Right);
+        set('A', GlyphKind::Factory, Direction::Right, GlyphFactory::CopperMine);
+        set('D', GlyphKind::Factory, Direction::Left, GlyphFactory::CopperMine);
+        set('F', GlyphKind::Factory, Direction::Down, GlyphFactory::CopperMine);
+        set('G', GlyphKind::Factory, Direction::Up, GlyphFactory::CopperMine);
+        set('C', GlyphKind::Factory, Direction::Right, GlyphFactory::CopperSmelter);
+        set('J', GlyphKind::Junction);
+        set('S', GlyphKind::Storage);
+        set('@', GlyphKind::Stairs, Direction::Right);
+        set('u', GlyphKind::Tunnel, Direction::Down);
+        set('y', GlyphKind::Tunnel, Direction::Up);
+        set('i', GlyphKind::Tunnel, Direction::Left);
+        set('o', GlyphKind::Tunnel, Direction::Right);
+        set('L', GlyphKind::LaunchPad, Direction::Right);
+        return glyphs;
+    }();
 
-    const Eigen::Vector3i size1X1 = {1, 1, 1};
-    std::string strLine;
-    while (std::getline(ss, strLine))
+    struct GlyphDefinitions
     {
-        grid.push_back(strLine);
+        cpp_conv::FactoryId m_CopperMine = cpp_conv::FactoryId::FromStringId("FACTORY_COPPER_MINE");
+        cpp_conv::FactoryId m_CopperSmelter = cpp_conv::FactoryId::FromStringId("FACTORY_COPPER_SMELTER");
+        cpp_conv::InserterId m_BasicInserter = cpp_conv::InserterId::FromStringId("INSERTER_BASIC");
+    };
+
+    cpp_conv::Entity* createEntity(
+        std::pmr::memory_resource& arena,
+        const GlyphDefinitions& definitions,
+        const Glyph& glyph,
+        const int32_t iRow,
+        const int32_t iColumn)
+    {
+        using namespace cpp_conv;
+        using resources::Map;
+        const Eigen::Vector3i size1X1 = {1, 1, 1};
+        const Eigen::Vector3i position = {iColumn, 0, iRow};
+
+        switch (glyph.m_Kind)
+        {
+        case GlyphKind::Conveyor: return Map::CreateEntityIn<Conveyor>(arena, position, size1X1, glyph.m_Direction);
+        case GlyphKind::Inserter: return Map::CreateEntityIn<Inserter>(arena, position, size1X1, glyph.m_Direction, definitions.m_BasicInserter);
+        case GlyphKind::Factory:
+            return Map::CreateEntityIn<Factory>(
+                arena,
+                Eigen::Vector3i{iColumn + 1, 0, iRow + 1},
+                glyph.m_Direction,
+                glyph.m_Factory == GlyphFactory::CopperMine ? definitions.m_CopperMine : definitions.m_CopperSmelter);
+        case GlyphKind::Junction: return Map::CreateEntityIn<Junction>(arena, position, size1X1);
+        case GlyphKind::Storage: return Map::CreateEntityIn<Storage>(arena, position, size1X1, 16, 256);
+        case GlyphKind::Stairs: return Map::CreateEntityIn<Stairs>(arena, position, Eigen::Vector3i{1, 1, 2}, glyph.m_Direction, true);
+        case GlyphKind::Tunnel: return Map::CreateEntityIn<Tunnel>(arena, position, size1X1, glyph.m_Direction);
+        case GlyphKind::LaunchPad: return Map::CreateEntityIn<LaunchPad>(arena, Eigen::Vector3i{iColumn + 5, 0, iRow + 5}, glyph.m_Direction);
+        case GlyphKind::None: break;
+        }
+
+        return nullptr;
     }
 
-    for(int32_t iRow = 0; iRow < grid.size(); iRow++)
+    // The rows (size x) and columns (size z) of text an entity covers, matching the size its constructor settles on.
+    struct GlyphFootprint
     {
-        for (size_t iCol = 0; iCol < grid[iRow].size(); iCol++)
+        int32_t m_iRows = 1;
+        int32_t m_iColumns = 1;
+
+        [[nodiscard]] bool IsSingleTile() const { return m_iRows == 1 && m_iColumns == 1; }
+    };
+
+    std::array<GlyphFootprint, 256> getGlyphFootprints(const GlyphDefinitions& definitions)
+    {
+        std::array<GlyphFootprint, 256> footprints{};
+        for (size_t i = 0; i < footprints.size(); ++i)
         {
-            Entity* pEntity = nullptr;
-            switch (grid[iRow][iCol])
+            const Glyph& glyph = c_Glyphs[i];
+            Eigen::Vector3i size = {1, 1, 1};
+            switch (glyph.m_Kind)
             {
-            case '>': pEntity = new
-                    Conveyor({static_cast<int32_t>(iCol), 0, iRow}, size1X1, Direction::Right);
-                break;
-            case '<': pEntity = new Conveyor({static_cast<int32_t>(iCol), 0, iRow}, size1X1, Direction::Left);
-                break;
-            case '^': pEntity = new Conveyor({static_cast<int32_t>(iCol), 0, iRow}, size1X1, Direction::Down);
-                break;
-            case 'v': pEntity = new Conveyor({static_cast<int32_t>(iCol), 0, iRow}, size1X1, Direction::Up);
-                break;
-            case 'I': pEntity = new Inserter({static_cast<int32_t>(iCol), 0, iRow}, size1X1, Direction::Down,
-                                             InserterId::FromStringId("INSERTER_BASIC"));
-                break;
-            case 'U': pEntity = new Inserter({static_cast<int32_t>(iCol), 0, iRow}, size1X1, Direction::Up,
-                                             InserterId::FromStringId("INSERTER_BASIC"));
-                break;
-            case 'T': pEntity = new Inserter({static_cast<int32_t>(iCol), 0, iRow}, size1X1, Direction::Left,
-                                             InserterId::FromStringId("INSERTER_BASIC"));
-                break;
-            case 'Y': pEntity = new Inserter({static_cast<int32_t>(iCol), 0, iRow}, size1X1, Direction::Right,
-                                             InserterId::FromStringId("INSERTER_BASIC"));
-                break;
-            case 'A': pEntity = new Factory({static_cast<int32_t>(iCol + 1), 0, iRow + 1}, Direction::Right,
-                                            FactoryId::FromStringId("FACTORY_COPPER_MINE"));
-                break;
-            case 'D': pEntity = new Factory({static_cast<int32_t>(iCol + 1), 0, iRow + 1}, Direction::Left,
-                                            FactoryId::FromStringId("FACTORY_COPPER_MINE"));
-                break;
-            case 'F': pEntity = new Factory({static_cast<int32_t>(iCol + 1), 0, iRow + 1}, Direction::Down,
-                                            FactoryId::FromStringId("FACTORY_COPPER_MINE"));
-                break;
-            case 'G': pEntity = new Factory({static_cast<int32_t>(iCol + 1), 0, iRow + 1}, Direction::Up,
-                                            FactoryId::FromStringId("FACTORY_COPPER_MINE"));
-                break;
-            case 'C': pEntity = new Factory({static_cast<int32_t>(iCol + 1), 0, iRow + 1}, Direction::Right,
-                                            FactoryId::FromStringId("FACTORY_COPPER_SMELTER"));
-                break;
-            case 'J': pEntity = new Junction({static_cast<int32_t>(iCol), 0, iRow}, size1X1);
-                break;
-            case 'S': pEntity = new Storage({static_cast<int32_t>(iCol), 0, iRow}, size1X1, 16, 256);
-                break;
-            case '@': pEntity = new Stairs({static_cast<int32_t>(iCol), 0, iRow}, {1, 1, 2}, Direction::Right,
-                                           true);
-                break;
-            case 'u': pEntity = new Tunnel({static_cast<int32_t>(iCol), 0, iRow}, size1X1, Direction::Down);
-                break;
-            case 'y': pEntity = new Tunnel({static_cast<int32_t>(iCol), 0, iRow}, size1X1, Direction::Up);
+            case GlyphKind::Factory:
+                {
+                    const auto factoryId =
+                        glyph.m_Factory == GlyphFactory::CopperMine ? definitions.m_CopperMine : definitions.m_CopperSmelter;
+                    if (const auto definition = cpp_conv::resources::getFactoryDefinition(factoryId))
+                    {
+                        size = definition->GetSize();
+                    }
+                    break;
+                }
+            case GlyphKind::Stairs: size = {1, 1, 2};
                 break;
-            case 'i': pEntity = new Tunnel({static_cast<int32_t>(iCol), 0, iRow}, size1X1, Direction::Left);
+            case GlyphKind::LaunchPad: size = {10, 4, 10};
                 break;
-            case 'o': pEntity = new Tunnel({static_cast<int32_t>(iCol), 0, iRow}, size1X1, Direction::Right);
+            default:
                 break;
-            case 'L': pEntity = new LaunchPad({static_cast<int32_t>(iCol + 5), 0, iRow + 5}, Direction::Right);
-            default: ; // Ignored
             }
 
-            if (pEntity)
+            footprints[i] = {size.x(), size.z()};
+        }
+
+        return footprints;
+    }
+
+    // The factory glyphs whose definitions are missing, which parseTextMap refuses rather than guess their footprint.
+    std::string getUndefinedFactoryGlyphs(const GlyphDefinitions& definitions)
+    {
+        std::string glyphs;
+        for (size_t i = 0; i < c_Glyphs.size(); ++i)
+        {
+            const Glyph& glyph = c_Glyphs[i];
+            const auto factoryId =
+                glyph.m_Factory == GlyphFactory::CopperMine ? definitions.m_CopperMine : definitions.m_CopperSmelter;
+            if (glyph.m_Kind == GlyphKind::Factory && !cpp_conv::resources::getFactoryDefinition(factoryId))
+            {
+                glyphs.push_back(static_cast<char>(i));
+            }
+        }
+
+        return glyphs;
+    }
+
+    // Bands are parsed in parallel; smaller inputs stay on one thread.
+    constexpr size_t c_uiMinBandSize = 256 * 1024;
+
+    struct Candidate
+    {
+        int32_t m_iRow;
+        int32_t m_iColumn;
+        uint8_t m_uiGlyph;
+    };
+
+    struct Rectangle
+    {
+        int32_t m_iFirstRow;
+        int32_t m_iEndRow;
+        int32_t m_iFirstColumn;
+        int32_t m_iEndColumn;
+    };
+
+    struct Band
+    {
+        std::string_view m_Data;
+        int32_t m_iFirstRow = 0;
+        int32_t m_iRowCount = 0;
+
+        // Rows are relative to the band until the bands have been stitched together.
+        std::vector<Candidate> m_vSingleTiles;
+        std::vector<Candidate> m_vMultiTiles;
+        std::vector<Candidate> m_vAcceptedMultiTiles;
+
+        std::pmr::memory_resource* m_pArena = nullptr;
+        std::vector<cpp_conv::Conveyor*> m_vConveyors;
+        std::vector<cpp_conv::Entity*> m_vOtherEntities;
+    };
+
+    std::vector<Band> splitIntoBands(const std::string_view data)
+    {
+        std::vector<Band> vBands;
+        size_t uiStart = 0;
+        while (uiStart < data.size())
+        {
+            size_t uiEnd = std::min(data.size(), uiStart + c_uiMinBandSize);
+            const size_t uiLineEnd = data.find('\n', uiEnd == 0 ? 0 : uiEnd - 1);
+            uiEnd = uiLineEnd == std::string_view::npos ? data.size() : uiLineEnd + 1;
+
+            vBands.emplace_back().m_Data = data.substr(uiStart, uiEnd - uiStart);
+            uiStart = uiEnd;
+        }
+
+        return vBands;
+    }
+
+    void scanBand(Band& band, const std::array<GlyphFootprint, 256>& footprints)
+    {
+        int32_t iRow = 0;
+        int32_t iColumn = 0;
+        for (const char cGlyph : band.m_Data)
+        {
+            if (cGlyph == '\n')
+            {
+                iRow++;
+                iColumn = 0;
+                continue;
+            }
+
+            const int32_t iCurrentColumn = iColumn++;
+            const auto uiGlyph = static_cast<unsigned char>(cGlyph);
+            if (c_Glyphs[uiGlyph].m_Kind == GlyphKind::None)
+            {
+                continue;
+            }
+
+            auto& vCandidates = footprints[uiGlyph].IsSingleTile() ? band.m_vSingleTiles : band.m_vMultiTiles;
+            vCandidates.push_back({iRow, iCurrentColumn, uiGlyph});
+        }
+
+        // A band always ends on a line break unless it is the last, which still holds a (possibly empty) final row.
+        band.m_iRowCount = iRow + 1;
+    }
+
+    // Single tile entities only ever cover their own glyph, so the only overlaps to resolve are those of multi tile
+    // entities, which must be visited in reading order: an entity covered by an earlier one is dropped.
+    std::vector<Rectangle> resolveMultiTileEntities(std::vector<Band>& vBands, const std::array<GlyphFootprint, 256>& footprints)
+    {
+        std::vector<Rectangle> vAccepted;
+        std::vector<int32_t> vCoveredUntilRow;
+        for (Band& band : vBands)
+        {
+            for (Candidate candidate : band.m_vMultiTiles)
             {
-                for(size_t i = iRow; i < iRow + pEntity->m_size.x(); i++)
+                candidate.m_iRow += band.m_iFirstRow;
+                const int32_t iColumn = candidate.m_iColumn;
+                if (iColumn < static_cast<int32_t>(vCoveredUntilRow.size()) && vCoveredUntilRow[iColumn] > candidate.m_iRow)
                 {
-                    for(size_t j = iCol; j < iCol + pEntity->m_size.z(); j++)
-                    {
-                        grid[i][j] = ' ';
-                    }
+                    continue;
                 }
 
-                if (pEntity->m_eEntityKind == EntityKind::Conveyor)
+                const GlyphFootprint& footprint = footprints[candidate.m_uiGlyph];
+                const Rectangle rectangle{
+                    candidate.m_iRow, candidate.m_iRow + footprint.m_iRows, iColumn, iColumn + footprint.m_iColumns};
+                if (static_cast<int32_t>(vCoveredUntilRow.size()) < rectangle.m_iEndColumn)
                 {
-                    pMap->GetConveyors().push_back(static_cast<Conveyor*>(pEntity));
+                    vCoveredUntilRow.resize(rectangle.m_iEndColumn, 0);
                 }
-                else
+
+                for (int32_t i = rectangle.m_iFirstColumn; i < rectangle.m_iEndColumn; i++)
                 {
-                    pMap->GetOtherEntities().push_back(pEntity);
+                    vCoveredUntilRow[i] = std::max(vCoveredUntilRow[i], rectangle.m_iEndRow);
                 }
+
+                vAccepted.push_back(rectangle);
+                band.m_vAcceptedMultiTiles.push_back(candidate);
+            }
+        }
+
+        return vAccepted;
+    }
+
+    void buildBand(
+        Band& band,
+        const std::vector<Rectangle>& vCovered,
+        const GlyphDefinitions& definitions)
+    {
+        const int32_t iEndRow = band.m_iFirstRow + band.m_iRowCount;
+
+        // Covered column ranges of each of the band's rows.
+        std::vector<std::vector<std::pair<int32_t, int32_t>>> vCoveredRows(band.m_iRowCount);
+        for (const Rectangle& rectangle : vCovered)
+        {
+            const int32_t iFirstRow = std::max(rectangle.m_iFirstRow, band.m_iFirstRow);
+            const int32_t iLastRow = std::min(rectangle.m_iEndRow, iEndRow);
+            for (int32_t iRow = iFirstRow; iRow < iLastRow; ++iRow)
+            {
+                vCoveredRows[iRow - band.m_iFirstRow].emplace_back(rectangle.m_iFirstColumn, rectangle.m_iEndColumn);
             }
         }
+
+        const auto isCovered = [&vCoveredRows](const Candidate& candidate)
+        {
+            return std::ranges::any_of(vCoveredRows[candidate.m_iRow], [&candidate](const std::pair<int32_t, int32_t>& range)
+            {
+                return candidate.m_iColumn >= range.first && candidate.m_iColumn < range.second;
+            });
+        };
+
+        const auto addEntity = [&](const Candidate& candidate, const int32_t iAbsoluteRow)
+        {
+            const Glyph& glyph = c_Glyphs[candidate.m_uiGlyph];
+            cpp_conv::Entity* pEntity = createEntity(*band.m_pArena, definitions, glyph, iAbsoluteRow, candidate.m_iColumn);
+
+            // Inserters also report themselves as conveyors, so file by glyph rather than by entity kind.
+            if (glyph.m_Kind == GlyphKind::Conveyor)
+            {
+                band.m_vConveyors.push_back(static_cast<cpp_conv::Conveyor*>(pEntity));
+            }
+            else
+            {
+                band.m_vOtherEntities.push_back(pEntity);
+            }
+        };
+
+        // Merge single and multi tile entities back into reading order.
+        auto multiIt = band.m_vAcceptedMultiTiles.begin();
+        for (const Candidate& candidate : band.m_vSingleTiles)
+        {
+            const int32_t iAbsoluteRow = band.m_iFirstRow + candidate.m_iRow;
+            for (; multiIt != band.m_vAcceptedMultiTiles.end() &&
+                   std::tie(multiIt->m_iRow, multiIt->m_iColumn) < std::tie(iAbsoluteRow, candidate.m_iColumn); ++multiIt)
+            {
+                addEntity(*multiIt, multiIt->m_iRow);
+            }
+
+            if (!isCovered(candidate))
+            {
+                addEntity(candidate, iAbsoluteRow);
+            }
+        }
+
+        for (; multiIt != band.m_vAcceptedMultiTiles.end(); ++multiIt)
+        {
+            addEntity(*multiIt, multiIt->m_iRow);
+        }
+    }
+
+}
+
+bool cpp_conv::resources::parseTextMap(const std::string_view data, Map& map, std::string* pErrors)
+{
+    const GlyphDefinitions definitions;
+    const size_t uiUndefined = data.find_first_of(getUndefinedFactoryGlyphs(definitions));
+    if (uiUndefined != std::string_view::npos)
+    {
+        if (pErrors)
+        {
+            *pErrors += std::format("Map uses factory glyph '{}' but its definition is not loaded\n", data[uiUndefined]);
+        }
+
+        return false;
+    }
+
+    const std::array<GlyphFootprint, 256> footprints = getGlyphFootprints(definitions);
+
+    std::vector<Band> vBands = splitIntoBands(data);
+    std::for_each(std::execution::par, vBands.begin(), vBands.end(), [&footprints](Band& band)
+    {
+        scanBand(band, footprints);
+    });
+
+    int32_t iRow = 0;
+    for (Band& band : vBands)
+    {
+        band.m_iFirstRow = iRow;
+        band.m_pArena = &map.CreateArena();
+        iRow += band.m_iRowCount - 1;
+    }
+
+    const std::vector<Rectangle> vCovered = resolveMultiTileEntities(vBands, footprints);
+
+    std::for_each(std::execution::par, vBands.begin(), vBands.end(), [&vCovered, &definitions](Band& band)
+    {
+        buildBand(band, vCovered, definitions);
+    });
+
+    for (Band& band : vBands)
+    {
+        map.GetConveyors().insert(map.GetConveyors().end(), band.m_vConveyors.begin(), band.m_vConveyors.end());
+        map.GetOtherEntities().insert(map.GetOtherEntities().end(), band.m_vOtherEntities.begin(), band.m_vOtherEntities.end());
+    }
+
+    return true;
+}
+
+atlas::resource::AssetPtr<atlas::resource::ResourceAsset> cpp_conv::resources::mapAssetHandler(atlas::resource::FileData& rData)
+{
+    const std::span<const uint8_t> data{rData.m_pData.get(), static_cast<size_t>(rData.m_Size)};
+    atlas::resource::AssetPtr<Map> pMap {new Map()};
+
+    if (BinaryMapView::IsBinaryMap(data))
+    {
+        std::string errors;
+        // The map is read in place, so it keeps the file buffer rather than a copy of it.
+        if (!pMap->AdoptBinaryData(std::move(rData.m_pData), data.size(), &errors))
+        {
+            std::cerr << errors;
+            return nullptr;
+        }
+
+        return pMap;
+    }
+
+    std::string errors;
+    if (!parseTextMap(std::string_view(reinterpret_cast<const char*>(data.data()), data.size()), *pMap, &errors))
+    {
+        std::cerr << errors;
+        return nullptr;
     }
 
     return pMap;
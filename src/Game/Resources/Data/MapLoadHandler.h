@@ -1,9 +1,19 @@
 #pragma once
+#include <string>
+#include <string_view>
+
 #include "AtlasResource/AssetPtr.h"
 #include "AtlasResource/FileData.h"
 #include "AtlasResource/ResourceAsset.h"
 
 namespace cpp_conv::resources
 {
-    atlas::resource::AssetPtr<atlas::resource::ResourceAsset> mapAssetHandler(const atlas::resource::FileData& rData);
+    class Map;
+
+    // Fills the map with the entities of a text glyph map. Fails if the map uses a factory glyph whose definition has
+    // not been loaded, as its footprint would be unknown.
+    bool parseTextMap(std::string_view data, Map& map, std::string* pErrors);
+
+    // Accepts both text glyph maps and binary maps.
+    atlas::resource::AssetPtr<atlas::resource::ResourceAsset> mapAssetHandler(atlas::resource::FileData& rData);
 }
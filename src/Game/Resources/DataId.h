@@ -58,6 +58,30 @@ namespace cpp_conv
 
     DEFINE_UNIQUE_DATA_TYPE(Item);
 
+    // Dense index of an ItemId, interned by the item registry at load time. Simulation state stores these rather than
+    // the 64-bit ItemId so that per-item tables can be plain array lookups.
+    // Index 0 is reserved for "no item", so a value-initialised ItemIndex is always empty.
+    struct ItemIndex
+    {
+        uint16_t m_uiIndex = 0;
+        static ItemIndex Empty() { return {0}; }
+        [[nodiscard]] bool IsValid() const { return m_uiIndex != 0; }
+        [[nodiscard]] bool IsEmpty() const { return m_uiIndex == 0; }
+        bool operator==(const ItemIndex other) const
+        {
+            return m_uiIndex == other.m_uiIndex;
+        }
+        bool operator<(const ItemIndex other) const
+        {
+            return m_uiIndex < other.m_uiIndex;
+        }
+    };
+
+    namespace ItemIndices
+    {
+        constexpr ItemIndex None = { 0 };
+    }
+
     DEFINE_UNIQUE_DATA_TYPE(Factory);
 
     DEFINE_UNIQUE_DATA_TYPE(Conveyor);
@@ -65,4 +89,22 @@ namespace cpp_conv
     DEFINE_UNIQUE_DATA_TYPE(Inserter);
 
     DEFINE_UNIQUE_DATA_TYPE(Recipe);
+
+    // Dense index into the compiled recipe table, following the same conventions as ItemIndex.
+    struct RecipeIndex
+    {
+        uint16_t m_uiIndex = 0;
+        static RecipeIndex Empty() { return {0}; }
+        [[nodiscard]] bool IsValid() const { return m_uiIndex != 0; }
+        [[nodiscard]] bool IsEmpty() const { return m_uiIndex == 0; }
+        bool operator==(const RecipeIndex other) const
+        {
+            return m_uiIndex == other.m_uiIndex;
+        }
+    };
+
+    namespace RecipeIndices
+    {
+        constexpr RecipeIndex None = { 0 };
+    }
 }
@@ -0,0 +1,128 @@
+#include "LoadGraph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <deque>
+#include <format>
+#include <mutex>
+#include <thread>
+
+cpp_conv::resources::LoadGraph::StepId cpp_conv::resources::LoadGraph::Add(
+    std::string name,
+    std::function<void()> fnStep,
+    const std::initializer_list<StepId> dependencies,
+    const Affinity affinity)
+{
+    const StepId id = m_vSteps.size();
+    for (const StepId dependency : dependencies)
+    {
+        assert(dependency < id);
+        m_vSteps[dependency].m_vDependents.push_back(id);
+    }
+
+    Step& step = m_vSteps.emplace_back();
+    step.m_Name = std::move(name);
+    step.m_fnRun = std::move(fnStep);
+    step.m_Affinity = affinity;
+    step.m_uiPendingDependencies = dependencies.size();
+    return id;
+}
+
+void cpp_conv::resources::LoadGraph::Run()
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    std::mutex mutex;
+    std::condition_variable stepReady;
+    std::deque<StepId> workerQueue;
+    std::deque<StepId> mainThreadQueue;
+    size_t uiFinishedSteps = 0;
+
+    // Must be called with the mutex held.
+    const auto enqueue = [&](const StepId id)
+    {
+        (m_vSteps[id].m_Affinity == Affinity::MainThread ? mainThreadQueue : workerQueue).push_back(id);
+    };
+
+    for (StepId id = 0; id < m_vSteps.size(); ++id)
+    {
+        if (m_vSteps[id].m_uiPendingDependencies == 0)
+        {
+            enqueue(id);
+        }
+    }
+
+    // Takes ready steps from the given queue until every step has finished.
+    const auto drain = [&](std::deque<StepId>& queue)
+    {
+        std::unique_lock lock{mutex};
+        while (true)
+        {
+            stepReady.wait(lock, [&] { return !queue.empty() || uiFinishedSteps == m_vSteps.size(); });
+            if (queue.empty())
+            {
+                return;
+            }
+
+            const StepId id = queue.front();
+            queue.pop_front();
+            lock.unlock();
+
+            Step& step = m_vSteps[id];
+            const auto stepStart = std::chrono::steady_clock::now();
+            step.m_fnRun();
+            step.m_Duration = std::chrono::steady_clock::now() - stepStart;
+
+            lock.lock();
+            for (const StepId dependent : step.m_vDependents)
+            {
+                if (--m_vSteps[dependent].m_uiPendingDependencies == 0)
+                {
+                    enqueue(dependent);
+                }
+            }
+
+            uiFinishedSteps++;
+            stepReady.notify_all();
+        }
+    };
+
+    const size_t uiWorkerSteps = std::ranges::count(m_vSteps, Affinity::Worker, &Step::m_Affinity);
+    const size_t uiWorkerCount = std::min<size_t>(uiWorkerSteps, std::max(1u, std::thread::hardware_concurrency()));
+    {
+        std::vector<std::jthread> vWorkers;
+        vWorkers.reserve(uiWorkerCount);
+        for (size_t i = 0; i < uiWorkerCount; ++i)
+        {
+            vWorkers.emplace_back([&] { drain(workerQueue); });
+        }
+
+        drain(mainThreadQueue);
+    }
+
+    m_Duration = std::chrono::steady_clock::now() - start;
+}
+
+void cpp_conv::resources::LoadGraph::Report(std::ostream& output) const
+{
+    using Milliseconds = std::chrono::duration<double, std::milli>;
+
+    std::chrono::nanoseconds totalStepDuration{};
+    for (const Step& step : m_vSteps)
+    {
+        output << std::format("Loaded {} in {:.1f} ms\n", step.m_Name, Milliseconds{step.m_Duration}.count());
+        totalStepDuration += step.m_Duration;
+    }
+
+    output << std::format(
+        "Startup loading took {:.1f} ms for {:.1f} ms of work\n",
+        Milliseconds{m_Duration}.count(),
+        Milliseconds{totalStepDuration}.count());
+}
+
+std::recursive_mutex& cpp_conv::resources::getResourceLoaderMutex()
+{
+    static std::recursive_mutex s_Mutex;
+    return s_Mutex;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace cpp_conv::resources
+{
+    // Runs startup loading steps on a pool of worker threads, each one once the steps it depends on have finished, and
+    // times them. Steps that must stay on the main thread, such as those that create GPU resources, are run by the
+    // thread that calls Run while it waits for the others.
+    class LoadGraph
+    {
+    public:
+        using StepId = size_t;
+
+        enum class Affinity
+        {
+            Worker,
+            MainThread
+        };
+
+        // Dependencies must have been added before the step that depends on them.
+        StepId Add(
+            std::string name,
+            std::function<void()> fnStep,
+            std::initializer_list<StepId> dependencies = {},
+            Affinity affinity = Affinity::Worker);
+
+        // Returns once every step has run.
+        void Run();
+
+        // How long each step took, and how much of the work overlapped.
+        void Report(std::ostream& output) const;
+
+    private:
+        struct Step
+        {
+            std::string m_Name;
+            std::function<void()> m_fnRun;
+            Affinity m_Affinity;
+            std::vector<StepId> m_vDependents;
+            size_t m_uiPendingDependencies = 0;
+            std::chrono::nanoseconds m_Duration{};
+        };
+
+        std::vector<Step> m_vSteps;
+        std::chrono::nanoseconds m_Duration{};
+    };
+
+    // Atlas's ResourceLoader makes no promise of being thread safe, so anything that calls into it while the graph runs
+    // holds this, down to the id lookups made while deserializing definitions. It is recursive, as asset handlers run
+    // under their caller's lock and may look ids up themselves.
+    std::recursive_mutex& getResourceLoaderMutex();
+}
@@ -1,8 +1,18 @@
 #pragma once
 
+#include <format>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
 
 #include "AssetRegistry.h"
+#include "DefinitionCache.h"
+#include "LoadGraph.h"
 #include "Profiler.h"
 #include "AtlasResource/AssetPtr.h"
 #include "AtlasResource/FileData.h"
@@ -11,51 +21,198 @@
 
 namespace cpp_conv::resources::asset_handler_common
 {
+    // While a thread has this set, deserializingAssetHandler copies the source into it instead of deserializing it, so
+    // that loadDefinitions can read sources under the resource loader's lock and deserialize them once it is released.
+    inline thread_local std::vector<uint8_t>* t_pCapturedSource = nullptr;
+
+    template<typename TAssetDefinition>
+    std::unique_ptr<TAssetDefinition> deserializeDefinition(const std::span<const uint8_t> source)
+    {
+        PROFILE_FUNC();
+        static const uint64_t s_uiSchemaHash = TAssetDefinition::GetSchemaHash();
+        const uint64_t uiCacheKey = DefinitionCache::GetKey(s_uiSchemaHash, source);
+
+        // The source is only parsed if it has changed since it was last cooked.
+        DefinitionCache& cache = getDefinitionCache();
+        if (const std::optional<DefinitionCache::CachedDefinition> cached = cache.Find(uiCacheKey))
+        {
+            if (cached->m_bIsRejected)
+            {
+                std::cerr << std::string_view{reinterpret_cast<const char*>(cached->m_Data.data()), cached->m_Data.size()};
+                return nullptr;
+            }
+
+            if (auto pCooked = TAssetDefinition::DeserializeCooked(cached->m_Data))
+            {
+                return pCooked;
+            }
+        }
+
+        const std::string copy(reinterpret_cast<const char*>(source.data()), source.size());
+
+        std::string errors;
+        auto pDefinition = TAssetDefinition::Deserialize(copy, &errors);
+        if (!pDefinition)
+        {
+            std::cerr << errors;
+            cache.StoreRejected(uiCacheKey, errors);
+            return nullptr;
+        }
+
+        cache.StoreCooked(uiCacheKey, pDefinition->Cook());
+        return pDefinition;
+    }
+
     template<typename TAssetDefinition>
     void loadDefinitions(std::vector<atlas::resource::AssetPtr<TAssetDefinition>>& assets)
     {
         PROFILE_FUNC();
+        std::vector<uint8_t> vSource;
         for (const atlas::resource::RegistryId asset : registry::core_bundle::data::recipes::c_AllAssets)
         {
-            auto pAsset = atlas::resource::ResourceLoader::LoadAsset<registry::CoreBundle, TAssetDefinition>(asset);
-            if (!pAsset)
+            // Only the read holds the lock, so that the other steps' reads interleave with these and the parsing
+            // runs in parallel with theirs. The loader is handed nothing back, so the store owns the definitions.
+            vSource.clear();
+            {
+                std::scoped_lock lock{getResourceLoaderMutex()};
+                t_pCapturedSource = &vSource;
+                atlas::resource::ResourceLoader::LoadAsset<registry::CoreBundle, TAssetDefinition>(asset);
+                t_pCapturedSource = nullptr;
+            }
+
+            if (vSource.empty())
             {
                 continue;
             }
 
-            assets.push_back(pAsset);
+            if (auto pDefinition = deserializeDefinition<TAssetDefinition>(vSource))
+            {
+                assets.push_back(atlas::resource::AssetPtr<TAssetDefinition>{pDefinition.release()});
+            }
         }
     }
 
+    // Flat id -> definition table, built once when the definitions have been loaded. Ids are already FNV hashes, so a
+    // power-of-two open-addressed table indexed by their low bits gives O(1) lookups with no allocation. The store owns
+    // the AssetPtrs, so hot paths get plain pointers and never touch the asset refcount.
     template<typename TAssetDefinition, typename TIdContainer>
-    atlas::resource::AssetPtr<TAssetDefinition> getDefinition(std::vector<atlas::resource::AssetPtr<TAssetDefinition>>& assets, const TIdContainer id)
+    class DefinitionStore
     {
-        PROFILE_FUNC();
-        for (auto item : assets)
+    public:
+        static constexpr uint32_t c_uiInvalidIndex = std::numeric_limits<uint32_t>::max();
+
+        void Load()
         {
-            if (item->GetInternalId() == id)
+            PROFILE_FUNC();
+            std::vector<atlas::resource::AssetPtr<TAssetDefinition>> vAssets;
+            loadDefinitions<TAssetDefinition>(vAssets);
+            Build(std::move(vAssets));
+        }
+
+        void Build(std::vector<atlas::resource::AssetPtr<TAssetDefinition>> vAssets)
+        {
+            PROFILE_FUNC();
+            m_vAssets.clear();
+            m_vDefinitions.clear();
+            m_vSlots.clear();
+
+            uint32_t uiCapacity = 1;
+            while (uiCapacity < vAssets.size() * 2)
             {
-                return item;
+                uiCapacity <<= 1;
+            }
+
+            m_uiMask = uiCapacity - 1;
+            m_vSlots.resize(uiCapacity);
+            m_vAssets.reserve(vAssets.size());
+            m_vDefinitions.reserve(vAssets.size());
+
+            for (auto& pAsset : vAssets)
+            {
+                const TIdContainer id = pAsset->GetInternalId();
+                if (id.IsEmpty() || FindIndex(id) != c_uiInvalidIndex)
+                {
+                    std::cerr << std::format("Skipping definition {} with an empty or duplicate id\n", pAsset->GetName());
+                    continue;
+                }
+
+                uint64_t uiSlot = id.m_uiItemId & m_uiMask;
+                while (m_vSlots[uiSlot].m_uiId != 0)
+                {
+                    uiSlot = (uiSlot + 1) & m_uiMask;
+                }
+
+                m_vSlots[uiSlot] = {id.m_uiItemId, static_cast<uint32_t>(m_vDefinitions.size())};
+                m_vDefinitions.push_back(&*pAsset);
+                m_vAssets.push_back(std::move(pAsset));
             }
         }
 
-        return nullptr;
-    }
+        [[nodiscard]] uint32_t FindIndex(const TIdContainer id) const
+        {
+            if (id.IsEmpty() || m_vSlots.empty())
+            {
+                return c_uiInvalidIndex;
+            }
+
+            uint64_t uiSlot = id.m_uiItemId & m_uiMask;
+            while (true)
+            {
+                const Slot& slot = m_vSlots[uiSlot];
+                if (slot.m_uiId == id.m_uiItemId)
+                {
+                    return slot.m_uiIndex;
+                }
+
+                if (slot.m_uiId == 0)
+                {
+                    return c_uiInvalidIndex;
+                }
+
+                uiSlot = (uiSlot + 1) & m_uiMask;
+            }
+        }
+
+        [[nodiscard]] const TAssetDefinition* Find(const TIdContainer id) const
+        {
+            const uint32_t uiIndex = FindIndex(id);
+            return uiIndex == c_uiInvalidIndex ? nullptr : m_vDefinitions[uiIndex];
+        }
+
+        [[nodiscard]] const TAssetDefinition* Get(const uint32_t uiIndex) const
+        {
+            return uiIndex < m_vDefinitions.size() ? m_vDefinitions[uiIndex] : nullptr;
+        }
+
+        [[nodiscard]] uint32_t GetCount() const { return static_cast<uint32_t>(m_vDefinitions.size()); }
+        [[nodiscard]] const std::vector<const TAssetDefinition*>& GetDefinitions() const { return m_vDefinitions; }
+
+    private:
+        struct Slot
+        {
+            uint64_t m_uiId = 0;
+            uint32_t m_uiIndex = c_uiInvalidIndex;
+        };
+
+        std::vector<atlas::resource::AssetPtr<TAssetDefinition>> m_vAssets;
+        std::vector<const TAssetDefinition*> m_vDefinitions;
+        std::vector<Slot> m_vSlots;
+        uint64_t m_uiMask = 0;
+    };
 
     template<typename TAssetDefinition>
     atlas::resource::AssetPtr<atlas::resource::ResourceAsset> deserializingAssetHandler(const atlas::resource::FileData& rData)
     {
-        PROFILE_FUNC();
-        const auto pStrData = reinterpret_cast<const char*>(rData.m_pData.get());
-
-        // ReSharper disable once CppRedundantCastExpression
-        const std::string copy(pStrData, (int)(rData.m_Size / sizeof(char)));
+        const std::span<const uint8_t> source{reinterpret_cast<const uint8_t*>(rData.m_pData.get()), rData.m_Size};
+        if (t_pCapturedSource)
+        {
+            t_pCapturedSource->assign(source.begin(), source.end());
+            return nullptr;
+        }
 
-        std::string errors;
-        auto pDefinition = TAssetDefinition::Deserialize(copy, &errors);
+        auto pDefinition = deserializeDefinition<TAssetDefinition>(source);
         if (!pDefinition)
         {
-            std::cerr << errors;
             return nullptr;
         }
 
@@ -15,15 +15,9 @@ namespace cpp_conv
 {
     class ConveyorDefinition final : public Serializable<ConveyorDefinition, TomlSerializer, atlas::resource::ResourceAsset>
     {
-        inline static TomlSerializer::Config ms_ConveyorConfig = {"conveyor"};
+        friend Serializable;
+        inline static TomlSerializer::Config ms_Config = {"conveyor"};
     public:
-        ConveyorDefinition()
-            : Serializable(
-                ms_ConveyorConfig,
-                {&m_InternalId, &m_Name, &m_TickDelay})
-        {
-        }
-
         [[nodiscard]] ConveyorId GetInternalId() const { return m_InternalId.m_Value; }
 
         [[nodiscard]] const std::string& GetName() const { return m_Name.m_Value; }
@@ -34,5 +28,14 @@ namespace cpp_conv
         DataField<std::string, "name", true> m_Name{};
 
         DataField<int32_t, "tickDelay", true> m_TickDelay{};
+
+        // Read and cooked in this order.
+        static constexpr auto GetFields()
+        {
+            return std::tuple{
+                &ConveyorDefinition::m_InternalId,
+                &ConveyorDefinition::m_Name,
+                &ConveyorDefinition::m_TickDelay};
+        }
     };
 }
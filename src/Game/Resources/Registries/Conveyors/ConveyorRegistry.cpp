@@ -12,14 +12,14 @@
 #include "Profiler.h"
 #include "AtlasResource/ResourceLoader.h"
 
-static std::vector<atlas::resource::AssetPtr<cpp_conv::ConveyorDefinition>> g_vConveyors;
+static cpp_conv::resources::asset_handler_common::DefinitionStore<cpp_conv::ConveyorDefinition, cpp_conv::ConveyorId> g_Conveyors;
 
 void cpp_conv::resources::loadConveyors()
 {
-    asset_handler_common::loadDefinitions<ConveyorDefinition>(g_vConveyors);
+    g_Conveyors.Load();
 }
 
-atlas::resource::AssetPtr<cpp_conv::ConveyorDefinition> cpp_conv::resources::getConveyorDefinition(const ConveyorId id)
+const cpp_conv::ConveyorDefinition* cpp_conv::resources::getConveyorDefinition(const ConveyorId id)
 {
-    return asset_handler_common::getDefinition(g_vConveyors, id);
+    return g_Conveyors.Find(id);
 }
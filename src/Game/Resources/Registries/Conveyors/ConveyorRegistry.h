@@ -14,5 +14,5 @@ namespace cpp_conv::resources
 {
     void loadConveyors();
 
-    atlas::resource::AssetPtr<ConveyorDefinition> getConveyorDefinition(ConveyorId id);
+    const ConveyorDefinition* getConveyorDefinition(ConveyorId id);
 }
@@ -0,0 +1,169 @@
+#include "DefinitionCache.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <system_error>
+
+#include "DefinitionCacheFormat.h"
+#include "Hashing.h"
+#include "Profiler.h"
+
+static cpp_conv::resources::DefinitionCache g_DefinitionCache;
+
+namespace
+{
+    using namespace cpp_conv::resources::definition_cache;
+}
+
+void cpp_conv::resources::DefinitionCache::Open(const std::filesystem::path& path)
+{
+    PROFILE_FUNC();
+    m_Path = path;
+    m_vData.clear();
+    m_Entries.clear();
+    m_bIsDirty = false;
+
+    std::ifstream input(path, std::ios::binary);
+    if (!input)
+    {
+        return;
+    }
+
+    m_vData.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+
+    FileHeader header{};
+    if (m_vData.size() < sizeof(FileHeader))
+    {
+        m_vData.clear();
+        return;
+    }
+
+    std::memcpy(&header, m_vData.data(), sizeof(FileHeader));
+    if (header.m_Magic != c_Magic ||
+        header.m_uiVersion != c_uiVersion ||
+        header.m_uiBuildStamp != cpp_conv::hashing::getBuildStamp())
+    {
+        m_vData.clear();
+        return;
+    }
+
+    const std::span<const uint8_t> data{m_vData};
+    size_t uiOffset = sizeof(FileHeader);
+    for (uint32_t i = 0; i < header.m_uiEntryCount; ++i)
+    {
+        EntryHeader entry;
+        if (data.size() - uiOffset < sizeof(EntryHeader))
+        {
+            break;
+        }
+
+        std::memcpy(&entry, data.data() + uiOffset, sizeof(EntryHeader));
+        uiOffset += sizeof(EntryHeader);
+        if (entry.m_uiSize > data.size() - uiOffset)
+        {
+            break;
+        }
+
+        Entry& cached = m_Entries[entry.m_uiKey];
+        cached.m_bIsRejected = entry.m_Kind == EntryKind::Rejected;
+        cached.m_Data = data.subspan(uiOffset, entry.m_uiSize);
+        uiOffset += entry.m_uiSize;
+    }
+}
+
+bool cpp_conv::resources::DefinitionCache::Close()
+{
+    PROFILE_FUNC();
+    bool bHasUnusedEntries = false;
+    for (const auto& [uiKey, entry] : m_Entries)
+    {
+        bHasUnusedEntries |= !entry.m_bIsUsed;
+    }
+
+    bool bSucceeded = true;
+    if (m_bIsDirty || bHasUnusedEntries)
+    {
+        FileHeader header{};
+        header.m_Magic = c_Magic;
+        header.m_uiVersion = c_uiVersion;
+        header.m_uiBuildStamp = cpp_conv::hashing::getBuildStamp();
+
+        std::vector<uint8_t> vData(sizeof(FileHeader));
+        for (const auto& [uiKey, entry] : m_Entries)
+        {
+            if (!entry.m_bIsUsed)
+            {
+                continue;
+            }
+
+            EntryHeader entryHeader{};
+            entryHeader.m_uiKey = uiKey;
+            entryHeader.m_uiSize = entry.m_Data.size();
+            entryHeader.m_Kind = entry.m_bIsRejected ? EntryKind::Rejected : EntryKind::Cooked;
+            const auto pEntryHeader = reinterpret_cast<const uint8_t*>(&entryHeader);
+            vData.insert(vData.end(), pEntryHeader, pEntryHeader + sizeof(EntryHeader));
+            vData.insert(vData.end(), entry.m_Data.begin(), entry.m_Data.end());
+            header.m_uiEntryCount++;
+        }
+
+        std::memcpy(vData.data(), &header, sizeof(FileHeader));
+
+        // A cache that cannot be written costs the next startup some time, and nothing more.
+        std::error_code error;
+        std::filesystem::create_directories(m_Path.parent_path(), error);
+        std::ofstream output(m_Path, std::ios::binary);
+        output.write(reinterpret_cast<const char*>(vData.data()), static_cast<std::streamsize>(vData.size()));
+        bSucceeded = static_cast<bool>(output);
+    }
+
+    m_vData.clear();
+    m_Entries.clear();
+    m_bIsDirty = false;
+    return bSucceeded;
+}
+
+uint64_t cpp_conv::resources::DefinitionCache::GetKey(const uint64_t uiSchemaHash, const std::span<const uint8_t> source)
+{
+    return hashing::fnv1a(source, hashing::fnv1aValue(uiSchemaHash));
+}
+
+std::optional<cpp_conv::resources::DefinitionCache::CachedDefinition> cpp_conv::resources::DefinitionCache::Find(
+    const uint64_t uiKey)
+{
+    std::scoped_lock lock{m_Mutex};
+    const auto it = m_Entries.find(uiKey);
+    if (it == m_Entries.end())
+    {
+        return {};
+    }
+
+    it->second.m_bIsUsed = true;
+    return CachedDefinition{it->second.m_bIsRejected, it->second.m_Data};
+}
+
+void cpp_conv::resources::DefinitionCache::StoreCooked(const uint64_t uiKey, std::vector<uint8_t> vCooked)
+{
+    Store(uiKey, false, std::move(vCooked));
+}
+
+void cpp_conv::resources::DefinitionCache::StoreRejected(const uint64_t uiKey, const std::string_view errors)
+{
+    Store(uiKey, true, {errors.begin(), errors.end()});
+}
+
+void cpp_conv::resources::DefinitionCache::Store(const uint64_t uiKey, const bool bIsRejected, std::vector<uint8_t> vData)
+{
+    std::scoped_lock lock{m_Mutex};
+    Entry& entry = m_Entries[uiKey];
+    entry.m_bIsRejected = bIsRejected;
+    entry.m_vStored = std::move(vData);
+    entry.m_Data = entry.m_vStored;
+    entry.m_bIsUsed = true;
+    m_bIsDirty = true;
+}
+
+cpp_conv::resources::DefinitionCache& cpp_conv::resources::getDefinitionCache()
+{
+    return g_DefinitionCache;
+}
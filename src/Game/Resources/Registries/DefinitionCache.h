@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace cpp_conv::resources
+{
+    // Cooked definitions from previous runs, so that a definition whose source has not changed is read back from a flat
+    // binary record rather than parsed from TOML again. The cache is read in one go when opened, and written back on
+    // close with only the entries that this run asked for. Definitions may be loaded from several threads at once
+    // between the two.
+    class DefinitionCache
+    {
+    public:
+        struct CachedDefinition
+        {
+            // Set if the source did not deserialize as this definition type, in which case m_Data holds the errors.
+            bool m_bIsRejected;
+            std::span<const uint8_t> m_Data;
+        };
+
+        // A missing or unusable cache is treated as empty.
+        void Open(const std::filesystem::path& path);
+        bool Close();
+
+        // Keys an entry by the definition type's schema hash and the source it was deserialized from.
+        [[nodiscard]] static uint64_t GetKey(uint64_t uiSchemaHash, std::span<const uint8_t> source);
+
+        std::optional<CachedDefinition> Find(uint64_t uiKey);
+        void StoreCooked(uint64_t uiKey, std::vector<uint8_t> vCooked);
+        void StoreRejected(uint64_t uiKey, std::string_view errors);
+
+    private:
+        struct Entry
+        {
+            bool m_bIsRejected = false;
+            // Points into m_vData, or into m_vStored for an entry stored during this run.
+            std::span<const uint8_t> m_Data;
+            std::vector<uint8_t> m_vStored;
+            bool m_bIsUsed = false;
+        };
+
+        void Store(uint64_t uiKey, bool bIsRejected, std::vector<uint8_t> vData);
+
+        std::filesystem::path m_Path;
+        std::vector<uint8_t> m_vData;
+        std::mutex m_Mutex;
+        std::unordered_map<uint64_t, Entry> m_Entries;
+        bool m_bIsDirty = false;
+    };
+
+    DefinitionCache& getDefinitionCache();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace cpp_conv::resources::definition_cache
+{
+    // On-disk layout of the cooked definition cache. Everything is little endian.
+    //
+    //   FileHeader
+    //   per entry: EntryHeader, then uint8_t[m_uiSize] of the definition's cooked fields, or of the errors it was
+    //              rejected with
+    //
+    // Entries are keyed by the hash of the source file they were cooked from, seeded with the definition type's schema,
+    // so an edited source simply misses. Every asset is offered to every definition type, so rejections are kept too.
+    // Assets are cooked by path rather than registry id, so the cache outlives changes to the asset registry. The whole
+    // cache is dropped when it was written by a build from another compiler or for another target, as cooked values are
+    // laid out as they are in memory.
+
+    inline constexpr std::array<char, 4> c_Magic = {'C', 'P', 'D', 'C'};
+    inline constexpr uint32_t c_uiVersion = 3;
+
+    struct FileHeader
+    {
+        std::array<char, 4> m_Magic;
+        uint32_t m_uiVersion;
+        uint64_t m_uiBuildStamp;
+        uint32_t m_uiEntryCount;
+        uint32_t m_uiPadding;
+    };
+
+    enum class EntryKind : uint32_t
+    {
+        Cooked,
+        Rejected
+    };
+
+    struct EntryHeader
+    {
+        uint64_t m_uiKey;
+        uint64_t m_uiSize;
+        EntryKind m_Kind;
+        uint32_t m_uiPadding;
+    };
+
+    static_assert(sizeof(FileHeader) == 24);
+    static_assert(sizeof(EntryHeader) == 24);
+}
@@ -4,10 +4,10 @@
 
 atlas::resource::AssetPtr<atlas::render::ModelAsset> cpp_conv::FactoryDefinition::GetModel() const
 {
-    if (!m_AssetId.m_Value.IsValid())
+    if (!m_AssetId.m_Value.m_Id.IsValid())
     {
         return nullptr;
     }
 
-    return atlas::resource::ResourceLoader::LoadAsset<atlas::render::ModelAsset>(m_AssetId.m_Value);
+    return atlas::resource::ResourceLoader::LoadAsset<atlas::render::ModelAsset>(m_AssetId.m_Value.m_Id);
 }
@@ -22,23 +22,9 @@ namespace cpp_conv
 {
     class FactoryDefinition : public Serializable<FactoryDefinition, TomlSerializer, atlas::resource::ResourceAsset>
     {
-        inline static TomlSerializer::Config ms_ConveyorConfig = {"factory"};
+        friend Serializable;
+        inline static TomlSerializer::Config ms_Config = {"factory"};
     public:
-        FactoryDefinition()
-            : Serializable(
-                ms_ConveyorConfig,
-                {
-                    &m_InternalId,
-                    &m_Name,
-                    &m_AssetId,
-                    &m_ProducedRecipe,
-                    &m_ProductionRate,
-                    &m_Size,
-                    &m_OutputPipe
-                })
-        {
-        }
-
         [[nodiscard]] FactoryId GetInternalId() const { return m_InternalId.m_Value; }
         [[nodiscard]] const std::string& GetName() const { return m_Name.m_Value; }
         [[nodiscard]] Eigen::Vector3i GetSize() const { return m_Size.m_Value; }
@@ -52,11 +38,24 @@ namespace cpp_conv
     private:
         DataField<FactoryId, "id"> m_InternalId{};
         DataField<std::string, "name"> m_Name{};
-        DataField<atlas::resource::BundleRegistryId, "asset"> m_AssetId{atlas::resource::BundleRegistryId::Invalid()};
+        DataField<AssetReference, "asset"> m_AssetId{};
         DataField<RecipeId, "recipe"> m_ProducedRecipe{};
         DataField<uint32_t, "rate"> m_ProductionRate{};
 
         DataField<Eigen::Vector3i, "size"> m_Size{};
         DataField<Eigen::Vector3i, "output", false> m_OutputPipe{};
+
+        // Read and cooked in this order.
+        static constexpr auto GetFields()
+        {
+            return std::tuple{
+                &FactoryDefinition::m_InternalId,
+                &FactoryDefinition::m_Name,
+                &FactoryDefinition::m_AssetId,
+                &FactoryDefinition::m_ProducedRecipe,
+                &FactoryDefinition::m_ProductionRate,
+                &FactoryDefinition::m_Size,
+                &FactoryDefinition::m_OutputPipe};
+        }
     };
 }
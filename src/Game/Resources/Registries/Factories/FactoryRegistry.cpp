@@ -14,14 +14,19 @@
 #include "AtlasResource/FileData.h"
 #include "AtlasResource/ResourceLoader.h"
 
-static std::vector<atlas::resource::AssetPtr<cpp_conv::FactoryDefinition>> g_vFactories;
+static cpp_conv::resources::asset_handler_common::DefinitionStore<cpp_conv::FactoryDefinition, cpp_conv::FactoryId> g_Factories;
 
 void cpp_conv::resources::loadFactories()
 {
-    asset_handler_common::loadDefinitions<FactoryDefinition>(g_vFactories);
+    g_Factories.Load();
 }
 
-atlas::resource::AssetPtr<cpp_conv::FactoryDefinition> cpp_conv::resources::getFactoryDefinition(const FactoryId id)
+const cpp_conv::FactoryDefinition* cpp_conv::resources::getFactoryDefinition(const FactoryId id)
 {
-    return asset_handler_common::getDefinition(g_vFactories, id);
+    return g_Factories.Find(id);
+}
+
+const std::vector<const cpp_conv::FactoryDefinition*>& cpp_conv::resources::getFactoryDefinitions()
+{
+    return g_Factories.GetDefinitions();
 }
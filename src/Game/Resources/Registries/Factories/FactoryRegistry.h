@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 #include "AtlasResource/AssetPtr.h"
 #include "DataId.h"
 #include "AtlasResource/FileData.h"
@@ -16,5 +17,6 @@ namespace cpp_conv::resources
 {
     void loadFactories();
 
-    atlas::resource::AssetPtr<FactoryDefinition> getFactoryDefinition(FactoryId id);
+    const FactoryDefinition* getFactoryDefinition(FactoryId id);
+    const std::vector<const FactoryDefinition*>& getFactoryDefinitions();
 }
@@ -4,5 +4,5 @@
 
 atlas::resource::AssetPtr<cpp_conv::resources::TileAsset> cpp_conv::InserterDefinition::GetTile() const
 {
-    return atlas::resource::ResourceLoader::LoadAsset<resources::TileAsset>(m_AssetId.m_Value);
+    return atlas::resource::ResourceLoader::LoadAsset<resources::TileAsset>(m_AssetId.m_Value.m_Id);
 }
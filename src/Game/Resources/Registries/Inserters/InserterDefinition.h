@@ -12,22 +12,9 @@ namespace cpp_conv
 {
     class InserterDefinition : public Serializable<InserterDefinition, TomlSerializer, atlas::resource::ResourceAsset>
     {
-        inline static TomlSerializer::Config ms_ConveyorConfig = {"inserter"};
+        friend Serializable;
+        inline static TomlSerializer::Config ms_Config = {"inserter"};
     public:
-        InserterDefinition()
-            : Serializable(
-                ms_ConveyorConfig,
-                {
-                    &m_InternalId,
-                    &m_Name,
-                    &m_AssetId,
-                    &m_TransitTime,
-                    &m_CooldownTime,
-                    &m_bSupportsStacks,
-                })
-        {
-        }
-
         [[nodiscard]] InserterId GetInternalId() const { return m_InternalId.m_Value; }
 
         [[nodiscard]] const std::string& GetName() const { return m_Name.m_Value; }
@@ -40,9 +27,21 @@ namespace cpp_conv
     private:
         DataField<InserterId, "id"> m_InternalId{};
         DataField<std::string, "name"> m_Name{};
-        DataField<atlas::resource::BundleRegistryId, "asset"> m_AssetId{atlas::resource::BundleRegistryId::Invalid()};
+        DataField<AssetReference, "asset"> m_AssetId{};
         DataField<uint32_t, "transitTime"> m_TransitTime{};
         DataField<uint32_t, "cooldownTime"> m_CooldownTime{};
         DataField<bool, "supportsStacks"> m_bSupportsStacks{};
+
+        // Read and cooked in this order.
+        static constexpr auto GetFields()
+        {
+            return std::tuple{
+                &InserterDefinition::m_InternalId,
+                &InserterDefinition::m_Name,
+                &InserterDefinition::m_AssetId,
+                &InserterDefinition::m_TransitTime,
+                &InserterDefinition::m_CooldownTime,
+                &InserterDefinition::m_bSupportsStacks};
+        }
     };
 }
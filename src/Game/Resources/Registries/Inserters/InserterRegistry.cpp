@@ -9,15 +9,15 @@
 #include "DataId.h"
 #include "Profiler.h"
 
-static std::vector<atlas::resource::AssetPtr<cpp_conv::InserterDefinition>> g_vInsertersItems;
+static cpp_conv::resources::asset_handler_common::DefinitionStore<cpp_conv::InserterDefinition, cpp_conv::InserterId> g_Inserters;
 
 void cpp_conv::resources::loadInserters()
 {
-    asset_handler_common::loadDefinitions<InserterDefinition>(g_vInsertersItems);
+    g_Inserters.Load();
 }
 
-atlas::resource::AssetPtr<cpp_conv::InserterDefinition> cpp_conv::resources::getInserterDefinition(
+const cpp_conv::InserterDefinition* cpp_conv::resources::getInserterDefinition(
     const InserterId id)
 {
-    return asset_handler_common::getDefinition(g_vInsertersItems, id);
+    return g_Inserters.Find(id);
 }
@@ -16,5 +16,5 @@ namespace cpp_conv::resources
 {
     void loadInserters();
 
-    atlas::resource::AssetPtr<InserterDefinition> getInserterDefinition(InserterId id);
+    const InserterDefinition* getInserterDefinition(InserterId id);
 }
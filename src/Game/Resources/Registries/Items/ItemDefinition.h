@@ -12,31 +12,30 @@ namespace cpp_conv
 {
     class ItemDefinition : public Serializable<ItemDefinition, TomlSerializer, atlas::resource::ResourceAsset>
     {
-        inline static TomlSerializer::Config ms_ConveyorConfig = {"item"};
+        friend Serializable;
+        inline static TomlSerializer::Config ms_Config = {"item"};
     public:
-        ItemDefinition()
-            : Serializable(
-                ms_ConveyorConfig,
-                {
-                    &m_InternalId,
-                    &m_Name,
-                    &m_Description,
-                    &m_AssetId,
-                })
-        {
-        }
-
         ItemId GetInternalId() const { return m_InternalId.m_Value; }
 
         const std::string& GetName() const { return m_Name.m_Value; }
         const std::string& GetDescription() const { return m_Description.m_Value; }
 
-        [[nodiscard]] atlas::resource::BundleRegistryId GetAssetId() const { return m_AssetId.m_Value; }
+        [[nodiscard]] atlas::resource::BundleRegistryId GetAssetId() const { return m_AssetId.m_Value.m_Id; }
 
     private:
         DataField<ItemId, "id"> m_InternalId{};
         DataField<std::string, "name"> m_Name{};
         DataField<std::string, "description", false> m_Description{};
-        DataField<atlas::resource::BundleRegistryId, "asset"> m_AssetId{atlas::resource::BundleRegistryId::Invalid()};
+        DataField<AssetReference, "asset"> m_AssetId{};
+
+        // Read and cooked in this order.
+        static constexpr auto GetFields()
+        {
+            return std::tuple{
+                &ItemDefinition::m_InternalId,
+                &ItemDefinition::m_Name,
+                &ItemDefinition::m_Description,
+                &ItemDefinition::m_AssetId};
+        }
     };
 }
@@ -2,9 +2,10 @@
 #include "AtlasResource/AssetPtr.h"
 #include "ItemDefinition.h"
 
+#include <cassert>
 #include <iostream>
+#include <limits>
 #include <memory>
-#include <sstream>
 #include <vector>
 
 #include "AssetHandlerCommon.h"
@@ -12,14 +13,72 @@
 #include "Profiler.h"
 #include "AtlasResource/ResourceLoader.h"
 
-static std::vector<atlas::resource::AssetPtr<cpp_conv::ItemDefinition>> g_vItems;
+static cpp_conv::resources::asset_handler_common::DefinitionStore<cpp_conv::ItemDefinition, cpp_conv::ItemId> g_Items;
+
+// Indexed by ItemIndex, with slot 0 reserved for the empty item. ItemIndex N refers to the store's dense entry N - 1.
+static std::vector<cpp_conv::ItemId> g_vItemIndexToId;
+
+namespace
+{
+    void buildItemIndexTable()
+    {
+        PROFILE_FUNC();
+        assert(g_Items.GetCount() < std::numeric_limits<uint16_t>::max());
+
+        g_vItemIndexToId.clear();
+        g_vItemIndexToId.reserve(g_Items.GetCount() + 1);
+        g_vItemIndexToId.push_back(cpp_conv::ItemIds::None);
+
+        for (const cpp_conv::ItemDefinition* pItem : g_Items.GetDefinitions())
+        {
+            g_vItemIndexToId.push_back(pItem->GetInternalId());
+        }
+    }
+}
 
 void cpp_conv::resources::loadItems()
 {
-    asset_handler_common::loadDefinitions<ItemDefinition>(g_vItems);
+    g_Items.Load();
+    buildItemIndexTable();
+}
+
+const cpp_conv::ItemDefinition* cpp_conv::resources::getItemDefinition(const ItemId id)
+{
+    return g_Items.Find(id);
+}
+
+const cpp_conv::ItemDefinition* cpp_conv::resources::getItemDefinition(const ItemIndex index)
+{
+    if (index.IsEmpty())
+    {
+        return nullptr;
+    }
+
+    return g_Items.Get(index.m_uiIndex - 1);
+}
+
+cpp_conv::ItemIndex cpp_conv::resources::getItemIndex(const ItemId id)
+{
+    const uint32_t uiIndex = g_Items.FindIndex(id);
+    if (uiIndex == decltype(g_Items)::c_uiInvalidIndex)
+    {
+        return ItemIndices::None;
+    }
+
+    return {static_cast<uint16_t>(uiIndex + 1)};
+}
+
+cpp_conv::ItemId cpp_conv::resources::getItemId(const ItemIndex index)
+{
+    if (index.m_uiIndex >= g_vItemIndexToId.size())
+    {
+        return ItemIds::None;
+    }
+
+    return g_vItemIndexToId[index.m_uiIndex];
 }
 
-atlas::resource::AssetPtr<cpp_conv::ItemDefinition> cpp_conv::resources::getItemDefinition(const ItemId id)
+uint32_t cpp_conv::resources::getItemIndexCount()
 {
-    return asset_handler_common::getDefinition(g_vItems, id);
+    return static_cast<uint32_t>(g_vItemIndexToId.size());
 }
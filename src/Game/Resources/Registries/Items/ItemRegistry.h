@@ -14,5 +14,13 @@ namespace cpp_conv::resources
 {
     void loadItems();
 
-    atlas::resource::AssetPtr<ItemDefinition> getItemDefinition(ItemId id);
+    const ItemDefinition* getItemDefinition(ItemId id);
+    const ItemDefinition* getItemDefinition(ItemIndex index);
+
+    // Interning table built by loadItems(). Unknown ids map to ItemIndices::None.
+    ItemIndex getItemIndex(ItemId id);
+    ItemId getItemId(ItemIndex index);
+
+    // Number of entries a table indexed by ItemIndex needs, including the reserved empty slot.
+    uint32_t getItemIndexCount();
 }
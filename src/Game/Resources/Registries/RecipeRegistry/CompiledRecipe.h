@@ -0,0 +1,40 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+#include "DataId.h"
+
+namespace cpp_conv
+{
+    // Immutable, simulation-ready form of a RecipeDefinition. Built once by the recipe registry after items have been
+    // interned, and shared by every factory producing the recipe.
+    struct CompiledRecipe
+    {
+        static constexpr uint32_t c_uiMaxItems = 4;
+
+        // Stack size of every factory container, and so of the stack requirements below.
+        static constexpr uint32_t c_uiStackSize = 64;
+
+        struct Item
+        {
+            ItemIndex m_Item;
+            uint32_t m_uiCount;
+        };
+
+        [[nodiscard]] std::span<const Item> GetInputItems() const { return {m_InputItems.data(), m_uiInputCount}; }
+        [[nodiscard]] std::span<const Item> GetOutputItems() const { return {m_OutputItems.data(), m_uiOutputCount}; }
+
+        uint32_t m_uiEffort = 0;
+
+        // Number of container stacks a single cycle's worth of inputs and outputs occupy.
+        uint32_t m_uiInputStacks = 0;
+        uint32_t m_uiOutputStacks = 0;
+
+        uint8_t m_uiInputCount = 0;
+        uint8_t m_uiOutputCount = 0;
+        std::array<Item, c_uiMaxItems> m_InputItems{};
+        std::array<Item, c_uiMaxItems> m_OutputItems{};
+    };
+}
@@ -14,7 +14,8 @@ namespace cpp_conv
 {
     class RecipeDefinition : public Serializable<RecipeDefinition, TomlSerializer, atlas::resource::ResourceAsset>
     {
-        inline static TomlSerializer::Config ms_ConveyorConfig = {"recipe"};
+        friend Serializable;
+        inline static TomlSerializer::Config ms_Config = {"recipe"};
     public:
         struct RecipeItem
         {
@@ -22,20 +23,6 @@ namespace cpp_conv
             uint32_t m_uiCount;
         };
 
-        RecipeDefinition()
-            : Serializable(
-                ms_ConveyorConfig,
-                {
-                    &m_InternalId,
-                    &m_Name,
-                    &m_Description,
-                    &m_Effort,
-                    &m_InputItems,
-                    &m_OutputItems,
-                })
-        {
-        }
-
         [[nodiscard]] RecipeId GetInternalId() const { return m_InternalId.m_Value; }
         [[nodiscard]] std::string GetName() const { return m_Name.m_Value; }
         [[nodiscard]] std::string GetDescription() const { return m_Description.m_Value; }
@@ -52,6 +39,18 @@ namespace cpp_conv
 
         DataField<std::vector<RecipeItem>, "input", false> m_InputItems;
         DataField<std::vector<RecipeItem>, "output"> m_OutputItems;
+
+        // Read and cooked in this order.
+        static constexpr auto GetFields()
+        {
+            return std::tuple{
+                &RecipeDefinition::m_InternalId,
+                &RecipeDefinition::m_Name,
+                &RecipeDefinition::m_Description,
+                &RecipeDefinition::m_Effort,
+                &RecipeDefinition::m_InputItems,
+                &RecipeDefinition::m_OutputItems};
+        }
     };
 
     template <>
@@ -2,23 +2,125 @@
 #include "AtlasResource/AssetPtr.h"
 #include "RecipeDefinition.h"
 
+#include <array>
+#include <cassert>
+#include <format>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <vector>
 
 #include "AssetHandlerCommon.h"
+#include "CompiledRecipe.h"
 #include "DataId.h"
+#include "ItemRegistry.h"
 #include "Profiler.h"
 #include "AtlasResource/ResourceLoader.h"
 
-static std::vector<atlas::resource::AssetPtr<cpp_conv::RecipeDefinition>> g_vRecipes;
+static cpp_conv::resources::asset_handler_common::DefinitionStore<cpp_conv::RecipeDefinition, cpp_conv::RecipeId> g_Recipes;
+
+// Indexed by RecipeIndex, with slot 0 reserved for "no recipe".
+static std::vector<cpp_conv::CompiledRecipe> g_vCompiledRecipes;
+
+// Indexed by the store's dense index. Recipes which failed to compile map to RecipeIndices::None.
+static std::vector<cpp_conv::RecipeIndex> g_vRecipeIndices;
+
+namespace
+{
+    bool compileRecipeItems(
+        const cpp_conv::RecipeDefinition& definition,
+        const std::vector<cpp_conv::RecipeDefinition::RecipeItem>& vItems,
+        std::array<cpp_conv::CompiledRecipe::Item, cpp_conv::CompiledRecipe::c_uiMaxItems>& rOutItems,
+        uint8_t& rOutCount,
+        uint32_t& rOutStacks)
+    {
+        using cpp_conv::CompiledRecipe;
+
+        if (vItems.size() > CompiledRecipe::c_uiMaxItems)
+        {
+            std::cerr << std::format(
+                "Recipe {} has {} items on one side, only {} are supported\n",
+                definition.GetName(),
+                vItems.size(),
+                CompiledRecipe::c_uiMaxItems);
+            return false;
+        }
+
+        rOutCount = 0;
+        rOutStacks = 0;
+        for (const auto& item : vItems)
+        {
+            const cpp_conv::ItemIndex index = cpp_conv::resources::getItemIndex(item.m_idItem);
+            if (index.IsEmpty())
+            {
+                std::cerr << std::format("Recipe {} references an unknown item\n", definition.GetName());
+                return false;
+            }
+
+            rOutItems[rOutCount++] = {index, item.m_uiCount};
+            rOutStacks += (item.m_uiCount + CompiledRecipe::c_uiStackSize - 1) / CompiledRecipe::c_uiStackSize;
+        }
+
+        return true;
+    }
+
+    void compileRecipes()
+    {
+        PROFILE_FUNC();
+        assert(g_Recipes.GetCount() < std::numeric_limits<uint16_t>::max());
+
+        g_vCompiledRecipes.clear();
+        g_vCompiledRecipes.reserve(g_Recipes.GetCount() + 1);
+        g_vCompiledRecipes.emplace_back();
+
+        g_vRecipeIndices.assign(g_Recipes.GetCount(), cpp_conv::RecipeIndices::None);
+
+        for (uint32_t uiStoreIndex = 0; uiStoreIndex < g_Recipes.GetCount(); ++uiStoreIndex)
+        {
+            const cpp_conv::RecipeDefinition& definition = *g_Recipes.Get(uiStoreIndex);
+
+            cpp_conv::CompiledRecipe recipe;
+            recipe.m_uiEffort = definition.GetEffort();
+            if (!compileRecipeItems(definition, definition.GetInputItems(), recipe.m_InputItems, recipe.m_uiInputCount, recipe.m_uiInputStacks) ||
+                !compileRecipeItems(definition, definition.GetOutputItems(), recipe.m_OutputItems, recipe.m_uiOutputCount, recipe.m_uiOutputStacks))
+            {
+                continue;
+            }
+
+            g_vRecipeIndices[uiStoreIndex] = {static_cast<uint16_t>(g_vCompiledRecipes.size())};
+            g_vCompiledRecipes.push_back(recipe);
+        }
+    }
+}
 
 void cpp_conv::resources::loadRecipes()
 {
-    asset_handler_common::loadDefinitions<RecipeDefinition>(g_vRecipes);
+    g_Recipes.Load();
+    compileRecipes();
+}
+
+const cpp_conv::RecipeDefinition* cpp_conv::resources::getRecipeDefinition(const RecipeId id)
+{
+    return g_Recipes.Find(id);
 }
 
-atlas::resource::AssetPtr<cpp_conv::RecipeDefinition> cpp_conv::resources::getRecipeDefinition(const RecipeId id)
+cpp_conv::RecipeIndex cpp_conv::resources::getRecipeIndex(const RecipeId id)
 {
-    return asset_handler_common::getDefinition(g_vRecipes, id);
+    const uint32_t uiIndex = g_Recipes.FindIndex(id);
+    if (uiIndex == decltype(g_Recipes)::c_uiInvalidIndex)
+    {
+        return RecipeIndices::None;
+    }
+
+    return g_vRecipeIndices[uiIndex];
+}
+
+const cpp_conv::CompiledRecipe* cpp_conv::resources::getCompiledRecipe(const RecipeIndex index)
+{
+    if (index.IsEmpty() || index.m_uiIndex >= g_vCompiledRecipes.size())
+    {
+        return nullptr;
+    }
+
+    return &g_vCompiledRecipes[index.m_uiIndex];
 }
@@ -8,11 +8,16 @@
 namespace cpp_conv
 {
     class RecipeDefinition;
+    struct CompiledRecipe;
 }
 
 namespace cpp_conv::resources
 {
     void loadRecipes();
 
-    atlas::resource::AssetPtr<RecipeDefinition> getRecipeDefinition(RecipeId id);
+    const RecipeDefinition* getRecipeDefinition(RecipeId id);
+
+    // Recipes are compiled against the interned item indices, so items must be loaded first.
+    RecipeIndex getRecipeIndex(RecipeId id);
+    const CompiledRecipe* getCompiledRecipe(RecipeIndex index);
 }
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "Eigen/Core"
+
+namespace cpp_conv
+{
+    // Reads values back in the order they were written. A read past the end fails and leaves the value as it was.
+    class BinaryDataReader
+    {
+    public:
+        explicit BinaryDataReader(const std::span<const uint8_t> data)
+            : m_Data{data}
+        {
+        }
+
+        bool Read(void* pValue, const size_t uiSize)
+        {
+            if (uiSize > m_Data.size())
+            {
+                return false;
+            }
+
+            std::memcpy(pValue, m_Data.data(), uiSize);
+            m_Data = m_Data.subspan(uiSize);
+            return true;
+        }
+
+        [[nodiscard]] bool IsAtEnd() const { return m_Data.empty(); }
+
+    private:
+        std::span<const uint8_t> m_Data;
+    };
+
+    // The binary counterpart of TypedDataReader, used for cooked definitions. Plain values are copied as they are in
+    // memory, so cooked data is only read back by the build that wrote it.
+    template <typename TValue>
+    struct BinaryDataCodec
+    {
+        static_assert(std::is_trivially_copyable_v<TValue>);
+
+        static void Write(std::vector<uint8_t>& vOut, const TValue& value)
+        {
+            const auto pBytes = reinterpret_cast<const uint8_t*>(&value);
+            vOut.insert(vOut.end(), pBytes, pBytes + sizeof(TValue));
+        }
+
+        static bool Read(BinaryDataReader& reader, TValue& value)
+        {
+            return reader.Read(&value, sizeof(TValue));
+        }
+    };
+
+    template <>
+    struct BinaryDataCodec<std::string>
+    {
+        static void Write(std::vector<uint8_t>& vOut, const std::string& value)
+        {
+            BinaryDataCodec<uint32_t>::Write(vOut, static_cast<uint32_t>(value.size()));
+            vOut.insert(vOut.end(), value.begin(), value.end());
+        }
+
+        static bool Read(BinaryDataReader& reader, std::string& value)
+        {
+            uint32_t uiSize;
+            if (!BinaryDataCodec<uint32_t>::Read(reader, uiSize))
+            {
+                return false;
+            }
+
+            std::string result(uiSize, '\0');
+            if (!reader.Read(result.data(), uiSize))
+            {
+                return false;
+            }
+
+            value = std::move(result);
+            return true;
+        }
+    };
+
+    template <>
+    struct BinaryDataCodec<Eigen::Vector3i>
+    {
+        static void Write(std::vector<uint8_t>& vOut, const Eigen::Vector3i& value)
+        {
+            BinaryDataCodec<int32_t>::Write(vOut, value.x());
+            BinaryDataCodec<int32_t>::Write(vOut, value.y());
+            BinaryDataCodec<int32_t>::Write(vOut, value.z());
+        }
+
+        static bool Read(BinaryDataReader& reader, Eigen::Vector3i& value)
+        {
+            int32_t x, y, z;
+            if (!BinaryDataCodec<int32_t>::Read(reader, x) ||
+                !BinaryDataCodec<int32_t>::Read(reader, y) ||
+                !BinaryDataCodec<int32_t>::Read(reader, z))
+            {
+                return false;
+            }
+
+            value = {x, y, z};
+            return true;
+        }
+    };
+
+    template <typename TElement>
+    struct BinaryDataCodec<std::vector<TElement>>
+    {
+        static void Write(std::vector<uint8_t>& vOut, const std::vector<TElement>& value)
+        {
+            BinaryDataCodec<uint32_t>::Write(vOut, static_cast<uint32_t>(value.size()));
+            for (const TElement& element : value)
+            {
+                BinaryDataCodec<TElement>::Write(vOut, element);
+            }
+        }
+
+        static bool Read(BinaryDataReader& reader, std::vector<TElement>& value)
+        {
+            uint32_t uiCount;
+            if (!BinaryDataCodec<uint32_t>::Read(reader, uiCount))
+            {
+                return false;
+            }
+
+            std::vector<TElement> result;
+            for (uint32_t i = 0; i < uiCount; ++i)
+            {
+                if (!BinaryDataCodec<TElement>::Read(reader, result.emplace_back()))
+                {
+                    return false;
+                }
+            }
+
+            value = std::move(result);
+            return true;
+        }
+    };
+}
@@ -1,7 +1,22 @@
 #include "DataField.h"
 
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "LoadGraph.h"
 #include "AtlasResource/ResourceLoader.h"
 
+namespace
+{
+    // Definitions are deserialized on the startup loading threads, outside of the resource loader's lock.
+    std::optional<atlas::resource::BundleRegistryId> lookupId(const std::string& path)
+    {
+        std::scoped_lock lock{cpp_conv::resources::getResourceLoaderMutex()};
+        return atlas::resource::ResourceLoader::LookupId(path);
+    }
+}
+
 bool cpp_conv::TypedDataReader<bool>::Read(const toml::Table* value, const char* szPropertyName, bool& pTargetVariable)
 {
     auto [bOk, bValue] = value->getBool(szPropertyName);
@@ -122,7 +137,7 @@ bool cpp_conv::TypedDataReader<atlas::resource::BundleRegistryId>::Read(
         return false;
     }
 
-    const auto id = atlas::resource::ResourceLoader::LookupId(strValue);
+    const auto id = lookupId(strValue);
     if (!id.has_value())
     {
         pTargetVariable = {};
@@ -132,3 +147,34 @@ bool cpp_conv::TypedDataReader<atlas::resource::BundleRegistryId>::Read(
     pTargetVariable = id.value();
     return true;
 }
+
+bool cpp_conv::TypedDataReader<cpp_conv::AssetReference>::Read(
+    const toml::Table* value, const char* szPropertyName, AssetReference& pTargetVariable)
+{
+    auto [bOk, strValue] = value->getString(szPropertyName);
+    if (!bOk)
+    {
+        return false;
+    }
+
+    // A path that names no asset leaves an empty id, as for a BundleRegistryId field.
+    pTargetVariable.m_Path = strValue;
+    pTargetVariable.m_Id = lookupId(strValue).value_or(atlas::resource::BundleRegistryId{});
+    return true;
+}
+
+void cpp_conv::BinaryDataCodec<cpp_conv::AssetReference>::Write(std::vector<uint8_t>& vOut, const AssetReference& value)
+{
+    BinaryDataCodec<std::string>::Write(vOut, value.m_Path);
+}
+
+bool cpp_conv::BinaryDataCodec<cpp_conv::AssetReference>::Read(BinaryDataReader& reader, AssetReference& value)
+{
+    if (!BinaryDataCodec<std::string>::Read(reader, value.m_Path))
+    {
+        return false;
+    }
+
+    value.m_Id = lookupId(value.m_Path).value_or(atlas::resource::BundleRegistryId{});
+    return true;
+}
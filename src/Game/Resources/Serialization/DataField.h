@@ -1,11 +1,31 @@
 #pragma once
 
+#include <string>
+#include <string_view>
+#include <vector>
+
 #include "AssetRegistry.h"
+#include "BinaryDataCodec.h"
 #include "tomlcpp.hpp"
 #include "Eigen/Core"
 
 namespace cpp_conv
 {
+    // An asset named by its path. The path is what gets cooked, and is resolved again when the cooked definition is
+    // read, as registry ids are only stable for as long as the asset registry is unchanged.
+    struct AssetReference
+    {
+        std::string m_Path;
+        atlas::resource::BundleRegistryId m_Id = atlas::resource::BundleRegistryId::Invalid();
+    };
+
+    template <>
+    struct BinaryDataCodec<AssetReference>
+    {
+        static void Write(std::vector<uint8_t>& vOut, const AssetReference& value);
+        static bool Read(BinaryDataReader& reader, AssetReference& value);
+    };
+
     template <typename TReadType>
     struct TypedDataReader;
 
@@ -34,22 +54,18 @@ static bool Read(const toml::Table* value, const char* szPropertyName, TYPE& pTa
 
     DEFINE_DATA_TYPE_HANDLER(atlas::resource::BundleRegistryId);
 
-    struct DataFieldBase
-    {
-        DataFieldBase(const char* fieldName, bool bIsRequired)
-            : m_FieldName{fieldName}
-              , m_bIsRequired{bIsRequired}
-              , m_bIsSet{false}
-        {
-        }
+    DEFINE_DATA_TYPE_HANDLER(AssetReference);
 
-        virtual bool TryRead(toml::Table* rootTable) = 0;
-
-        const char* m_FieldName;
-        const bool m_bIsRequired;
-
-        bool m_bIsSet;
-    };
+    // Names a type, in whatever form the compiler spells it, so that a schema can tell fields of different types apart.
+    template <typename TValue>
+    constexpr std::string_view getTypeTag()
+    {
+#if defined(_MSC_VER)
+        return __FUNCSIG__;
+#else
+        return __PRETTY_FUNCTION__;
+#endif
+    }
 
     template <size_t N>
     struct TemplateLiteralString
@@ -63,33 +79,50 @@ static bool Read(const toml::Table* value, const char* szPropertyName, TYPE& pTa
         char m_Value[N];
     };
 
+    // A field of a Serializable definition. The name and whether it is required are part of the type, so that a field
+    // only holds its value, and definitions read their fields without dispatching through each one.
     template <typename TDataType, TemplateLiteralString DataEntryName, bool IsRequired = true>
-    struct DataField : public DataFieldBase
+    struct DataField
     {
-        DataField()
-            : DataFieldBase(DataEntryName.m_Value, IsRequired)
+        using ValueType = TDataType;
+
+        static constexpr const char* c_szFieldName = DataEntryName.m_Value;
+        static constexpr bool c_bIsRequired = IsRequired;
+
+        DataField() = default;
+
+        explicit DataField(TDataType initialValue)
+            : m_Value{initialValue}
         {
         }
 
-        explicit DataField(TDataType initialValue)
-            : DataFieldBase(DataEntryName.m_Value, IsRequired)
-              , m_Value{initialValue}
+        bool TryRead(const toml::Table* rootTable)
         {
+            m_bIsSet = TypedDataReader<TDataType>::Read(rootTable, c_szFieldName, m_Value);
+            return m_bIsSet;
         }
 
-        bool TryRead(toml::Table* rootTable) override
+        // Whether the field was set is cooked along with its value, as optional fields may have been left out.
+        void WriteBinary(std::vector<uint8_t>& vOut) const
         {
-            if (TypedDataReader<TDataType>::Read(rootTable, m_FieldName, m_Value))
+            BinaryDataCodec<bool>::Write(vOut, m_bIsSet);
+            if (m_bIsSet)
             {
-                m_bIsSet = true;
-                return true;
+                BinaryDataCodec<TDataType>::Write(vOut, m_Value);
             }
-
-            m_bIsSet = false;
-            return false;
         }
 
+        bool ReadBinary(BinaryDataReader& reader)
+        {
+            if (!BinaryDataCodec<bool>::Read(reader, m_bIsSet))
+            {
+                return false;
+            }
+
+            return !m_bIsSet || BinaryDataCodec<TDataType>::Read(reader, m_Value);
+        }
 
-        TDataType m_Value;
+        TDataType m_Value{};
+        bool m_bIsSet = false;
     };
 }
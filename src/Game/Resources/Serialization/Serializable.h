@@ -1,26 +1,97 @@
 #pragma once
+#include <span>
+#include <string_view>
+#include <tuple>
+
+#include "BinaryDataCodec.h"
 #include "DataField.h"
+#include "Hashing.h"
 
 namespace cpp_conv
 {
+    // Definitions list their fields once, for the type rather than per instance, as
+    //
+    //   static constexpr auto GetFields() { return std::tuple{&TSelf::m_FieldA, &TSelf::m_FieldB}; }
+    //
+    // along with their serializer config as ms_Config. Both may be private if the definition befriends Serializable.
+    // Each member pointer is the field's offset, and its type picks the reader, so reading a definition is unrolled at
+    // compile time.
     template <typename TSelf, typename Serializer, typename TBase>
     class Serializable : public TBase
     {
     public:
         std::string Serialize(std::string* outErrors = nullptr)
         {
-            return Serializer::Serialize(m_Config, m_Fields, outErrors);
+            return Serializer::Serialize(TSelf::ms_Config, Self(), TSelf::GetFields(), outErrors);
         }
 
-        static std::unique_ptr<TSelf> Deserialize(const std::string& input, std::string* outErrors = nullptr)
+        // The fields in binary, to be read back by DeserializeCooked without parsing the source again.
+        std::vector<uint8_t> Cook() const
+        {
+            std::vector<uint8_t> vCooked;
+            BinaryDataCodec<uint64_t>::Write(vCooked, GetSchemaHash());
+            std::apply(
+                [&](const auto... pFields) { ((Self().*pFields).WriteBinary(vCooked), ...); },
+                TSelf::GetFields());
+
+            return vCooked;
+        }
+
+        // Identifies the definition type and its fields, with their names, types and sizes, which cooked data must match.
+        [[nodiscard]] static uint64_t GetSchemaHash()
+        {
+            uint64_t uiHash = hashing::c_uiFnvOffsetBasis;
+            const auto hash = [&uiHash](const std::string_view str)
+            {
+                // The separator keeps one name from running into the next.
+                uiHash = hashing::fnv1a(std::string_view{"\xFF", 1}, hashing::fnv1a(str, uiHash));
+            };
+
+            hash(TSelf::ms_Config.m_RootTable);
+            std::apply(
+                [&]<typename... TFields>(TFields TSelf::*...)
+                {
+                    const auto hashField = [&]<typename TField>()
+                    {
+                        using TValue = typename TField::ValueType;
+                        hash(TField::c_szFieldName);
+                        hash(TField::c_bIsRequired ? "required" : "optional");
+                        hash(getTypeTag<TValue>());
+                        uiHash = hashing::fnv1aValue(uint64_t{sizeof(TValue)}, uiHash);
+                    };
+                    (hashField.template operator()<TFields>(), ...);
+                },
+                TSelf::GetFields());
+
+            return uiHash;
+        }
+
+        // Fails if the data was cooked for another definition type, or before its fields last changed.
+        static std::unique_ptr<TSelf> DeserializeCooked(
+            const std::span<const uint8_t> data,
+            std::string* outErrors = nullptr)
         {
             std::unique_ptr<TSelf> self = std::make_unique<TSelf>();
-            if (!Serializer::TryDeserialize(input, self->m_Config, self->m_Fields, outErrors))
+            BinaryDataReader reader{data};
+
+            uint64_t uiSchemaHash;
+            bool bOk = BinaryDataCodec<uint64_t>::Read(reader, uiSchemaHash) && uiSchemaHash == GetSchemaHash();
+            std::apply(
+                [&](const auto... pFields)
+                {
+                    const auto readField = [&](auto& field)
+                    {
+                        bOk = bOk && field.ReadBinary(reader) && (field.m_bIsSet || !field.c_bIsRequired);
+                    };
+                    (readField((*self).*pFields), ...);
+                },
+                TSelf::GetFields());
+
+            if (!bOk || !reader.IsAtEnd())
             {
                 if (outErrors)
                 {
-                    *outErrors = std::format("Error reading [{}:{}]\n{}", self->m_Config.m_RootTable, self->GetName(),
-                                             *outErrors);
+                    *outErrors += std::format("Unusable cooked [{}] definition\n", TSelf::ms_Config.m_RootTable);
                 }
 
                 self.reset();
@@ -29,15 +100,25 @@ namespace cpp_conv
             return self;
         }
 
-    protected:
-        explicit Serializable(const typename Serializer::Config& config, std::vector<DataFieldBase*> fields)
-            : m_Config(config)
-              , m_Fields(std::move(fields))
+        static std::unique_ptr<TSelf> Deserialize(const std::string& input, std::string* outErrors = nullptr)
         {
+            std::unique_ptr<TSelf> self = std::make_unique<TSelf>();
+            if (!Serializer::TryDeserialize(input, TSelf::ms_Config, *self, TSelf::GetFields(), outErrors))
+            {
+                if (outErrors)
+                {
+                    *outErrors = std::format("Error reading [{}:{}]\n{}", TSelf::ms_Config.m_RootTable,
+                                             self->GetName(), *outErrors);
+                }
+
+                self.reset();
+            }
+
+            return self;
         }
 
     private:
-        const typename Serializer::Config& m_Config;
-        std::vector<DataFieldBase*> m_Fields;
+        TSelf& Self() { return static_cast<TSelf&>(*this); }
+        const TSelf& Self() const { return static_cast<const TSelf&>(*this); }
     };
 }
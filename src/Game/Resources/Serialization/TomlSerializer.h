@@ -1,4 +1,6 @@
 #pragma once
+#include <tuple>
+
 #include "DataField.h"
 #include "tomlcpp.hpp"
 
@@ -11,18 +13,23 @@ namespace cpp_conv
             std::string m_RootTable;
         };
 
+        template <typename TSelf, typename TFields>
         static std::string Serialize(
             const Config& config,
-            const std::vector<DataFieldBase*>& fields,
+            const TSelf& self,
+            const TFields& fields,
             std::string* outErrors = nullptr)
         {
             return "";
         }
 
+        // Fields are a tuple of pointers to the DataField members of TSelf.
+        template <typename TSelf, typename TFields>
         static bool TryDeserialize(
             const std::string& input,
             const Config& config,
-            const std::vector<DataFieldBase*>& fields,
+            TSelf& self,
+            const TFields& fields,
             std::string* outErrors = nullptr)
         {
             const auto [table, errors] = toml::parse(input);
@@ -48,27 +55,33 @@ namespace cpp_conv
             }
 
             bool bErrors = false;
-            for (auto& field : fields)
+            std::apply(
+                [&](const auto... pFields) { (ReadField(rootTable.get(), self.*pFields, bErrors, outErrors), ...); },
+                fields);
+
+            return !bErrors;
+        }
+
+    private:
+        template <typename TField>
+        static void ReadField(const toml::Table* rootTable, TField& field, bool& bErrors, std::string* outErrors)
+        {
+            if (!field.TryRead(rootTable) && TField::c_bIsRequired)
             {
-                if (!field->TryRead(rootTable.get()) && field->m_bIsRequired)
+                bErrors = true;
+                if (outErrors)
                 {
-                    bErrors = true;
-                    if (outErrors)
+                    if (outErrors->size() > 0)
+                    {
+                        *outErrors = std::format("{}Failed to read required field {}\n", *outErrors,
+                                                 TField::c_szFieldName);
+                    }
+                    else
                     {
-                        if (outErrors->size() > 0)
-                        {
-                            *outErrors = std::format("{}Failed to read required field {}\n", *outErrors,
-                                                     field->m_FieldName);
-                        }
-                        else
-                        {
-                            *outErrors = std::format("Failed to read required field {}\n", field->m_FieldName);
-                        }
+                        *outErrors = std::format("Failed to read required field {}\n", TField::c_szFieldName);
                     }
                 }
             }
-
-            return !bErrors;
         }
     };
 }
@@ -19,7 +19,7 @@ namespace cpp_conv::components
     {
         struct PlacedItem
         {
-            ItemId m_Item;
+            ItemIndex m_Item;
             std::optional<Eigen::Vector2f> m_PreviousPosition;
             bool m_bShouldAnimate;
         };
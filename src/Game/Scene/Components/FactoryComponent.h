@@ -1,6 +1,7 @@
 #pragma once
 #include <optional>
 
+#include "CompiledRecipe.h"
 #include "FactoryDefinition.h"
 #include "GeneralItemContainer.h"
 #include "Eigen/Core"
@@ -9,25 +10,14 @@ namespace cpp_conv::components
 {
     struct FactoryComponent
     {
-        struct RecipeItem
-        {
-            ItemId m_Item;
-            uint32_t m_Count;
-        };
-
-        struct Recipe
-        {
-            uint32_t m_Effort{};
-            std::vector<RecipeItem> m_InputItems;
-            std::vector<RecipeItem> m_OutputItems;
-        };
-
         FactoryComponent()
-            : m_InputItems{256, 64, true}
-              , m_OutputItems{256, 64, true}
+            : m_InputItems{256, CompiledRecipe::c_uiStackSize, true}
+              , m_OutputItems{256, CompiledRecipe::c_uiStackSize, true}
               , m_ProductionRate{0}
-              , m_Tick{0}
-              , m_RemainingCurrentProductionEffort{0}
+              , m_uiProductionCompleteTick{0}
+              , m_uiScheduledTick{0}
+              , m_uiLastUpdateTick{0}
+              , m_uiOutputRetryInterval{0}
               , m_bIsDemandSatisfied{false}
         {
         }
@@ -35,13 +25,20 @@ namespace cpp_conv::components
         GeneralItemContainer m_InputItems;
         GeneralItemContainer m_OutputItems;
 
+        FactoryId m_Definition;
         Eigen::Vector3i m_Size;
-        std::optional<Recipe> m_Recipe;
+        RecipeIndex m_Recipe;
         std::optional<Eigen::Vector3i> m_OutputPipe;
         uint32_t m_ProductionRate;
-        uint32_t m_Tick;
-        uint32_t m_RemainingCurrentProductionEffort;
 
+        // Scheduler ticks. m_uiScheduledTick is the tick of the factory's live timer (0 while parked); any other timer
+        // firing for this factory is stale and is ignored.
+        uint64_t m_uiProductionCompleteTick;
+        uint64_t m_uiScheduledTick;
+        uint64_t m_uiLastUpdateTick;
+
+        // Ticks between looks at an output pipe with nothing to take the items, backed off while it stays that way.
+        uint32_t m_uiOutputRetryInterval;
 
         bool m_bIsDemandSatisfied;
     };
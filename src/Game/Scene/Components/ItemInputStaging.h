@@ -1,9 +1,217 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "DataId.h"
+#include "FactoryScheduler.h"
+#include "GeneralItemContainer.h"
+#include "AtlasScene/ECS/Entity.h"
 
 namespace cpp_conv::components
 {
+    // Per-entity inbox for items handed over by other entities. Any number of producers may push concurrently without
+    // locking (a bounded MPSC ring in the style of Vyukov's queue), while only the owning entity drains it, once per
+    // update, into its own container.
+    //
+    // Producers are expected to check the target container before pushing. Pushes racing each other can still admit
+    // more than the container takes, so anything left over on drain is held back and retried on the next drain.
     class ItemInputStaging
     {
     public:
+        static constexpr uint32_t c_uiCapacity = 16;
+
+        struct Entry
+        {
+            ItemIndex m_Item;
+            uint32_t m_uiCount;
+        };
+
+        ItemInputStaging()
+            : m_pQueue{std::make_unique<Queue>()}
+        {
+            for (uint32_t i = 0; i < c_uiCapacity; ++i)
+            {
+                m_pQueue->m_Slots[i].m_uiSequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        // The owner is woken through the scheduler on the first push after each drain.
+        void SetWakeTarget(FactoryScheduler* pScheduler, const atlas::scene::EntityId owner)
+        {
+            m_pWakeScheduler = pScheduler;
+            m_Owner = owner;
+        }
+
+        bool TryPush(const ItemIndex item, const uint32_t uiCount)
+        {
+            Queue& queue = *m_pQueue;
+            uint32_t uiPosition = queue.m_uiEnqueuePosition.load(std::memory_order_relaxed);
+            while (true)
+            {
+                Slot& slot = queue.m_Slots[uiPosition & c_uiMask];
+                const uint32_t uiSequence = slot.m_uiSequence.load(std::memory_order_acquire);
+                const int32_t iDifference = static_cast<int32_t>(uiSequence - uiPosition);
+                if (iDifference == 0)
+                {
+                    if (queue.m_uiEnqueuePosition.compare_exchange_weak(uiPosition, uiPosition + 1, std::memory_order_relaxed))
+                    {
+                        slot.m_Entry = {item, uiCount};
+                        slot.m_uiSequence.store(uiPosition + 1, std::memory_order_release);
+                        break;
+                    }
+                }
+                else if (iDifference < 0)
+                {
+                    return false;
+                }
+                else
+                {
+                    uiPosition = queue.m_uiEnqueuePosition.load(std::memory_order_relaxed);
+                }
+            }
+
+            if (m_pWakeScheduler && !queue.m_bWakeRequested.exchange(true, std::memory_order_acq_rel))
+            {
+                m_pWakeScheduler->Wake(m_Owner);
+            }
+
+            return true;
+        }
+
+        // Files a sender that could not hand items over, to be woken once the owner has made room. Only called from the
+        // serial hand-off, while the owner is not updating.
+        void AddBlockedSender(FactoryScheduler& scheduler, const atlas::scene::EntityId sender)
+        {
+            m_pBlockedSenderScheduler = &scheduler;
+            if (std::ranges::find(m_vBlockedSenders, sender) == m_vBlockedSenders.end())
+            {
+                m_vBlockedSenders.push_back(sender);
+            }
+        }
+
+        // Owner only. Called once the owner has taken items out of its container, and by Drain once it has freed queue
+        // slots.
+        void WakeBlockedSenders()
+        {
+            for (const atlas::scene::EntityId sender : m_vBlockedSenders)
+            {
+                m_pBlockedSenderScheduler->Wake(sender);
+            }
+
+            m_vBlockedSenders.clear();
+        }
+
+        // Owner only.
+        void Drain(GeneralItemContainer& container)
+        {
+            Queue& queue = *m_pQueue;
+            queue.m_bWakeRequested.store(false, std::memory_order_release);
+
+            const size_t uiHeldBack = m_vHeldBack.size();
+            for (size_t i = 0; i < uiHeldBack; ++i)
+            {
+                Store(container, m_vHeldBack[i]);
+            }
+            m_vHeldBack.erase(m_vHeldBack.begin(), m_vHeldBack.begin() + static_cast<ptrdiff_t>(uiHeldBack));
+
+            const uint32_t uiDequeueStart = queue.m_uiDequeuePosition;
+            while (true)
+            {
+                Slot& slot = queue.m_Slots[queue.m_uiDequeuePosition & c_uiMask];
+                const uint32_t uiSequence = slot.m_uiSequence.load(std::memory_order_acquire);
+                if (static_cast<int32_t>(uiSequence - (queue.m_uiDequeuePosition + 1)) < 0)
+                {
+                    break;
+                }
+
+                Store(container, slot.m_Entry);
+                slot.m_uiSequence.store(queue.m_uiDequeuePosition + c_uiCapacity, std::memory_order_release);
+                queue.m_uiDequeuePosition++;
+            }
+
+            if (queue.m_uiDequeuePosition != uiDequeueStart)
+            {
+                WakeBlockedSenders();
+            }
+        }
+
+        // Visits every entry a drain would store, in drain order, without consuming them. Owner only, and only while no
+        // producer is pushing.
+        template <typename TCallback>
+        void ForEachPending(TCallback&& callback) const
+        {
+            for (const Entry& entry : m_vHeldBack)
+            {
+                callback(entry);
+            }
+
+            const Queue& queue = *m_pQueue;
+            const uint32_t uiEnqueuePosition = queue.m_uiEnqueuePosition.load(std::memory_order_acquire);
+            for (uint32_t uiPosition = queue.m_uiDequeuePosition; uiPosition != uiEnqueuePosition; ++uiPosition)
+            {
+                callback(queue.m_Slots[uiPosition & c_uiMask].m_Entry);
+            }
+        }
+
+        // Owner only. Files an entry behind the held back ones, e.g. when restoring what ForEachPending reported.
+        void HoldBack(const Entry entry)
+        {
+            m_vHeldBack.push_back(entry);
+        }
+
+        // Whether a drain would now move some of the held back items, e.g. because the owner consumed some of its own.
+        [[nodiscard]] bool CouldStoreHeldBackItems(const GeneralItemContainer& container) const
+        {
+            return std::ranges::any_of(m_vHeldBack, [&container](const Entry& entry)
+            {
+                return container.GetInsertableCount(entry.m_Item) != 0;
+            });
+        }
+
+    private:
+        static_assert((c_uiCapacity & (c_uiCapacity - 1)) == 0, "Capacity must be a power of two");
+        static constexpr uint32_t c_uiMask = c_uiCapacity - 1;
+
+        struct Slot
+        {
+            std::atomic<uint32_t> m_uiSequence;
+            Entry m_Entry;
+        };
+
+        // Kept behind a pointer so the component stays movable and the producers' view of it stays put.
+        struct Queue
+        {
+            std::array<Slot, c_uiCapacity> m_Slots;
+            alignas(64) std::atomic<uint32_t> m_uiEnqueuePosition{0};
+            alignas(64) uint32_t m_uiDequeuePosition{0};
+            std::atomic<bool> m_bWakeRequested{false};
+        };
+
+        void Store(GeneralItemContainer& container, const Entry entry)
+        {
+            const uint32_t uiStored = std::min(entry.m_uiCount, container.GetInsertableCount(entry.m_Item));
+            if (uiStored != 0)
+            {
+                container.TryInsert(entry.m_Item, uiStored);
+            }
+
+            if (uiStored != entry.m_uiCount)
+            {
+                m_vHeldBack.push_back({entry.m_Item, entry.m_uiCount - uiStored});
+            }
+        }
+
+        std::unique_ptr<Queue> m_pQueue;
+        std::vector<Entry> m_vHeldBack;
+
+        FactoryScheduler* m_pWakeScheduler = nullptr;
+        atlas::scene::EntityId m_Owner;
+
+        FactoryScheduler* m_pBlockedSenderScheduler = nullptr;
+        std::vector<atlas::scene::EntityId> m_vBlockedSenders;
     };
 }
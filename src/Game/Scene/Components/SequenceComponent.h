@@ -10,7 +10,7 @@ namespace cpp_conv::components
     {
         struct SlotItem
         {
-            ItemId m_Item;
+            ItemIndex m_Item;
             std::optional<Eigen::Vector2f> m_Position{};
         };
 
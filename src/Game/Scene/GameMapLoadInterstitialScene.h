@@ -1,12 +1,19 @@
 #pragma once
+#include <filesystem>
+#include <memory>
+
 #include "AssetRegistry.h"
 #include "GameScene.h"
+#include "MapLoadJob.h"
 #include "AtlasResource/ResourceLoader.h"
 #include "AtlasScene/Scene.h"
 #include "AtlasScene/SceneManager.h"
+#include "bgfx/bgfx.h"
 
 namespace cpp_conv
 {
+    // Shows the load's progress while a MapLoadJob builds the map's simulation state, and moves on to the GameScene
+    // once it is ready.
     class GameMapLoadInterstitialScene : public atlas::scene::SceneBase
     {
     public:
@@ -15,14 +22,64 @@ namespace cpp_conv
         {
         }
 
+        explicit GameMapLoadInterstitialScene(std::filesystem::path savePath)
+            : m_MapId{}
+            , m_SavePath{std::move(savePath)}
+        {
+        }
+
         void OnEntered(atlas::scene::SceneManager& sceneManager) override
         {
-            const atlas::resource::AssetPtr<resources::Map> map = atlas::resource::ResourceLoader::LoadAssetUncached<
-                resources::Map>(m_MapId);
-            sceneManager.TransitionTo<GameScene>(map);
+            SceneBase::OnEntered(sceneManager);
+            bgfx::setDebug(BGFX_DEBUG_TEXT);
+            m_pLoadJob = m_SavePath.empty()
+                ? std::make_unique<MapLoadJob>(m_MapId)
+                : std::make_unique<MapLoadJob>(m_SavePath);
+        }
+
+        void OnUpdate(atlas::scene::SceneManager& sceneManager) override
+        {
+            SceneBase::OnUpdate(sceneManager);
+            m_pLoadJob->Update();
+
+            if (std::shared_ptr<PreparedGameState> pState = m_pLoadJob->TakeState())
+            {
+                sceneManager.TransitionTo<GameScene>(std::move(pState));
+            }
+        }
+
+        void OnRender(atlas::scene::SceneManager& sceneManager) override
+        {
+            SceneBase::OnRender(sceneManager);
+
+            const MapLoadJob::Stage stage = m_pLoadJob->GetStage();
+            bgfx::touch(0);
+            bgfx::dbgTextClear();
+            if (stage == MapLoadJob::Stage::Failed)
+            {
+                bgfx::dbgTextPrintf(1, 1, 0x4f, "Failed to load the map");
+                return;
+            }
+
+            bgfx::dbgTextPrintf(
+                1,
+                1,
+                0x0f,
+                "%s... %3d%%",
+                MapLoadJob::GetStageName(stage),
+                static_cast<int>(m_pLoadJob->GetProgress() * 100.0f));
+        }
+
+        void OnExited(atlas::scene::SceneManager& sceneManager) override
+        {
+            bgfx::setDebug(BGFX_DEBUG_NONE);
+            m_pLoadJob.reset();
+            SceneBase::OnExited(sceneManager);
         }
 
     private:
         atlas::resource::BundleRegistryId m_MapId;
+        std::filesystem::path m_SavePath;
+        std::unique_ptr<MapLoadJob> m_pLoadJob;
     };
 }
@@ -1,25 +1,28 @@
 #include "GameScene.h"
 
+#include <format>
+#include <fstream>
+#include <iostream>
+
 #include "Constants.h"
 #include "ConveyorComponent.h"
 #include "ConveyorRenderingSystem.h"
 #include "ConveyorStateDeterminationSystem.h"
-#include "Factory.h"
 #include "FactoryComponent.h"
-#include "FactoryRegistry.h"
 #include "FactorySystem.h"
+#include "ItemInputStaging.h"
+#include "ItemRegistry.h"
 #include "ModelComponent.h"
 #include "ModelRenderSystem.h"
 #include "NameComponent.h"
 #include "PostProcessSystem.h"
-#include "RecipeDefinition.h"
-#include "RecipeRegistry.h"
+#include "SaveGame.h"
 #include "SequenceFormationSystem.h"
 #include "SequenceProcessingSystem.h"
 #include "SolarBodyComponent.h"
 #include "StandaloneConveyorSystem.h"
-#include "Storage.h"
 #include "StorageComponent.h"
+#include "StorageSystem.h"
 #include "AtlasAppHost/Application.h"
 #include "AtlasGame/Scene/Components/Cameras/LookAtCameraComponent.h"
 #include "AtlasGame/Scene/Components/Cameras/SphericalLookAtCameraComponent.h"
@@ -37,105 +40,6 @@ using namespace atlas::render;
 
 namespace
 {
-    void loadFactory(
-        cpp_conv::EntityLookupGrid& grid,
-        const Eigen::Vector3i& position,
-        atlas::scene::EcsManager& ecs,
-        const atlas::scene::EntityId& ecsEntity,
-        const cpp_conv::Entity* entity)
-    {
-        using namespace cpp_conv::constants::render_masks;
-
-        const auto factoryEntity = static_cast<const cpp_conv::Factory*>(entity);
-        const auto definition = cpp_conv::resources::getFactoryDefinition(factoryEntity->GetDefinitionId());
-        if (definition && definition->GetModel())
-        {
-            ecs.AddComponent<ModelComponent>(ecsEntity, definition->GetModel(), c_generalGeometry | c_shadowCaster);
-        }
-
-        ecs.AddComponent<NameComponent>(ecsEntity, definition->GetName().c_str());
-        auto& factory = ecs.AddComponent<FactoryComponent>(ecsEntity);
-        auto size = definition->GetSize();
-
-        factory.m_Size = {size.x(), size.y(), size.z()};
-        if (definition->HasOwnOutputPipe())
-        {
-            auto outputPipe = definition->GetOutputPipe();
-            factory.m_OutputPipe = {outputPipe.x(), outputPipe.y(), outputPipe.z()};
-        }
-
-        const auto recipeId = definition->GetProducedRecipe();
-        const auto recipe = cpp_conv::resources::getRecipeDefinition(recipeId);
-        if (recipe)
-        {
-            FactoryComponent::Recipe componentRecipe;
-            componentRecipe.m_Effort = recipe->GetEffort();
-            for (auto& input : recipe->GetInputItems())
-            {
-                componentRecipe.m_InputItems.emplace_back(input.m_idItem, input.m_uiCount);
-            }
-
-            for (auto& output : recipe->GetOutputItems())
-            {
-                componentRecipe.m_OutputItems.emplace_back(output.m_idItem, output.m_uiCount);
-            }
-
-            factory.m_Recipe = componentRecipe;
-        }
-
-        if (!grid.PlaceEntity(position, factory.m_Size, ecsEntity))
-        {
-            ecs.RemoveEntity(ecsEntity);
-        }
-    }
-
-    void loadStorage(
-        cpp_conv::EntityLookupGrid& grid,
-        const Eigen::Vector3i& position,
-        atlas::scene::EcsManager& ecs,
-        const atlas::scene::EntityId& ecsEntity,
-        const cpp_conv::Entity* entity)
-    {
-        using namespace cpp_conv::constants::render_masks;
-
-        const auto storageEntity = static_cast<const cpp_conv::Storage*>(entity);
-        ecs.AddComponent<NameComponent>(ecsEntity, "Storage");
-        ecs.AddComponent<ModelComponent>(
-            ecsEntity,
-            ResourceLoader::LoadAsset<CoreBundle, ModelAsset>(core_bundle::assets::others::c_Barrel),
-            c_generalGeometry | c_shadowCaster);
-
-        auto& storage = ecs.AddComponent<StorageComponent>(ecsEntity);
-        storage.m_ItemContainer.Initialise(
-            storageEntity->GetContainer().GetMaxCapacity(),
-            storageEntity->GetContainer().GetMaxStackSize(),
-            storageEntity->GetContainer().OnlyAllowsUniqueStacks());
-
-        if (!grid.PlaceEntity(position, { 1, 1, 1 }, ecsEntity))
-        {
-            ecs.RemoveEntity(ecsEntity);
-        }
-    }
-
-    void loadLaunchPad(
-        cpp_conv::EntityLookupGrid& grid,
-        const Eigen::Vector3i& position,
-        atlas::scene::EcsManager& ecs,
-        const atlas::scene::EntityId& ecsEntity,
-        const cpp_conv::Entity* entity)
-    {
-        using namespace cpp_conv::constants::render_masks;
-        ecs.AddComponent<NameComponent>(ecsEntity, "Launchpad");
-        ecs.AddComponent<ModelComponent>(ecsEntity,
-            ResourceLoader::LoadAsset<CoreBundle, ModelAsset>(core_bundle::assets::others::c_LaunchPad),
-            c_generalGeometry | c_shadowCaster | c_clipCasterGeometry);
-
-        if (!grid.PlaceEntity(position, { 10, 4, 10 }, ecsEntity))
-        {
-            ecs.RemoveEntity(ecsEntity);
-        }
-    }
-
     /*
     *struct SphericalLookAtCamera : public CameraComponent
     {
@@ -196,56 +100,81 @@ void cpp_conv::GameScene::OnEntered(atlas::scene::SceneManager& sceneManager)
 {
     atlas::scene::EcsManager& ecs = GetEcsManager();
 
+    // The map's entities were built while loading, so take them over before adding the scene's own.
+    ecs = std::move(m_InitialisationData.m_pState->m_Ecs);
+    m_SceneData.m_FactoryScheduler.Reset(m_InitialisationData.m_pState->m_uiTick);
+    m_InitialisationData.m_pState.reset();
+
     addGround(ecs);
     addCameras(ecs);
     addLights(ecs);
 
-    /*for (const auto& entity : m_InitialisationData.m_Map->GetConveyors())
+    EcsScene::OnEntered(sceneManager);
+}
+
+void cpp_conv::GameScene::OnUpdate(atlas::scene::SceneManager& sceneManager)
+{
+    using namespace atlas::game::scene::components::cameras;
+
+    // Requested while the last frame rendered, and written before the next tick so that it lands between ticks.
+    if (m_RenderSystems.m_UI.m_DebugUI.ConsumeSaveRequest())
     {
-        const auto ecsEntity = ecs.AddEntity();
-        const auto& position = ecs.AddComponent<PositionComponent>(
-            ecsEntity, Eigen::Vector3i(entity->m_position.x(), entity->m_position.y(),
-                                       entity->m_position.z()));
-        ecs.AddComponent<NameComponent>(ecsEntity, "Basic Conveyor");
-        ecs.AddComponent<DescriptionComponent>(ecsEntity, "The wheels of invention");
-        ecs.AddComponent<DirectionComponent>(ecsEntity, entity->m_Direction);
-        ecs.AddComponent<ConveyorComponent>(ecsEntity);
-        ecs.AddComponent<WorldEntityInformationComponent>(ecsEntity, entity->m_eEntityKind);
-        m_SceneData.m_LookupGrid.PlaceEntity(position.m_Position, {1, 1, 1}, ecsEntity);
+        SaveGame(constants::save_game::c_szPath);
     }
 
-    static std::map<EntityKind, std::function<void(EntityLookupGrid&,
-            const Eigen::Vector3i&,
-            atlas::scene::EcsManager&,
-            const atlas::scene::EntityId&,
-            const Entity*)>> handlers =
+    EcsScene::OnUpdate(sceneManager);
+
+    atlas::scene::EcsManager& ecs = GetEcsManager();
+
+    // The world stays resident around whatever the active cameras are looking at.
+    std::vector<Eigen::Vector3f> vFocusPoints;
+    for (const auto entity : ecs.GetEntitiesWithComponents<LookAtCameraComponent>())
     {
-        {EntityKind::Producer, &loadFactory},
-        {EntityKind::Storage, &loadStorage},
-        {EntityKind::LaunchPad, &loadLaunchPad},
-    };
+        const auto& camera = ecs.GetComponent<LookAtCameraComponent>(entity);
+        if (camera.m_bIsRenderActive)
+        {
+            vFocusPoints.push_back(camera.m_LookAtPoint);
+        }
+    }
 
-    for (const auto& entity : m_InitialisationData.m_Map->GetOtherEntities())
+    // The spherical camera orbits a point on the surface, rather than the centre it is defined around. Its controller
+    // derives that point from the centre, pitch, yaw and distance every update.
+    for (const auto entity : ecs.GetEntitiesWithComponents<
+        SphericalLookAtCameraComponent, SphericalLookAtCameraComponent_Private>())
     {
-        auto handlerIt = handlers.find(entity->m_eEntityKind);
-        if (handlerIt == handlers.end())
+        const auto& [camera, derived] = ecs.GetComponents<
+            SphericalLookAtCameraComponent, SphericalLookAtCameraComponent_Private>(entity);
+        if (camera.m_bIsRenderActive)
         {
-            continue;
+            vFocusPoints.push_back(derived.m_LookAt);
         }
+    }
+
+    m_SceneData.m_ChunkStreamer.Update(ecs, vFocusPoints);
+    m_SceneData.m_Autosaver.Update(ecs, m_SceneData.m_FactoryScheduler.GetCurrentTick(), m_SceneData.m_ChunkStreamer);
+}
 
-        const auto ecsEntity = ecs.AddEntity();
-        ecs.AddComponent<WorldEntityInformationComponent>(ecsEntity, entity->m_eEntityKind);
-        const auto& position = ecs.AddComponent<PositionComponent>(
-            ecsEntity,
-            Eigen::Vector3i(entity->m_position.x(), entity->m_position.y(), entity->m_position.z()));
-        ecs.AddComponent<DirectionComponent>(ecsEntity, entity->m_Direction);
+bool cpp_conv::GameScene::SaveGame(const std::filesystem::path& path)
+{
+    save_game::SimulationSnapshot snapshot;
+    save_game::captureSimulation(GetEcsManager(), m_SceneData.m_FactoryScheduler.GetCurrentTick(), true, snapshot);
+    if (!m_SceneData.m_ChunkStreamer.CaptureFrozenState(snapshot))
+    {
+        std::cerr << std::format("Failed to save game {}\n", path.string());
+        return false;
+    }
 
-        (*handlerIt).second(m_SceneData.m_LookupGrid, position.m_Position, ecs, ecsEntity, entity);
-    }*/
+    const std::vector<uint8_t> vData = save_game::writeSaveGame(snapshot);
 
-    m_InitialisationData.m_Map.reset();
+    std::ofstream output(path, std::ios::binary);
+    output.write(reinterpret_cast<const char*>(vData.data()), static_cast<std::streamsize>(vData.size()));
+    if (!output)
+    {
+        std::cerr << std::format("Failed to write save game {}\n", path.string());
+        return false;
+    }
 
-    EcsScene::OnEntered(sceneManager);
+    return true;
 }
 
 void cpp_conv::GameScene::ConstructSystems(atlas::scene::SystemsBuilder& builder)
@@ -254,13 +183,15 @@ void cpp_conv::GameScene::ConstructSystems(atlas::scene::SystemsBuilder& builder
         "Conveyor Processing",
         [this](atlas::scene::SystemsBuilder& groupBuilder)
         {
-            groupBuilder.RegisterSystem<ConveyorStateDeterminationSystem>(m_SceneData.m_LookupGrid);
+            // Both already ran over the map's conveyors while it was loading.
+            groupBuilder.RegisterSystem<ConveyorStateDeterminationSystem>(*m_SceneData.m_pLookupGrid, true);
             groupBuilder.RegisterSystem<SequenceFormationSystem, ConveyorStateDeterminationSystem>(
-                m_SceneData.m_LookupGrid);
+                *m_SceneData.m_pLookupGrid,
+                true);
             groupBuilder.RegisterSystem<SequenceProcessingSystem_Process, SequenceFormationSystem>(
-                m_SceneData.m_LookupGrid);
+                *m_SceneData.m_pLookupGrid);
             groupBuilder.RegisterSystem<StandaloneConveyorSystem_Process, SequenceFormationSystem>(
-                m_SceneData.m_LookupGrid);
+                *m_SceneData.m_pLookupGrid);
         });
 
     auto conveyorRealizeGroup = builder.RegisterGroup(
@@ -283,7 +214,8 @@ void cpp_conv::GameScene::ConstructSystems(atlas::scene::SystemsBuilder& builder
         {conveyorRealizeGroup},
         [this](atlas::scene::SystemsBuilder& groupBuilder)
         {
-            groupBuilder.RegisterSystem<FactorySystem>(m_SceneData.m_LookupGrid);
+            groupBuilder.RegisterSystem<FactorySystem>(*m_SceneData.m_pLookupGrid, m_SceneData.m_FactoryScheduler);
+            groupBuilder.RegisterSystem<StorageSystem>();
         });
 
     ConstructFrameGraph();
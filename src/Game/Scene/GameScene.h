@@ -1,13 +1,18 @@
 #pragma once
 
+#include <filesystem>
+
 #include <AtlasScene/Scene.h>
 
 #include "SolarBodyRenderSystem.h"
+#include "Autosaver.h"
+#include "ChunkStreamer.h"
 #include "ConveyorRenderingSystem.h"
 #include "EntityLookupGrid.h"
+#include "FactoryScheduler.h"
 #include "FactoryDefinition.h"
 #include "LightingRenderSystem.h"
-#include "Map.h"
+#include "MapLoadJob.h"
 #include "ModelRenderSystem.h"
 #include "PostProcessSystem.h"
 #include "ShadowMappingSystem.h"
@@ -22,19 +27,20 @@ namespace cpp_conv
     class GameScene : public atlas::scene::EcsScene
     {
     public:
-        explicit GameScene(atlas::resource::AssetPtr<resources::Map> map)
-            : m_InitialisationData{std::move(map)}
+        explicit GameScene(std::shared_ptr<PreparedGameState> pState)
+            : m_InitialisationData{pState}
+            , m_SceneData{std::move(pState->m_pLookupGrid)}
         {
         }
 
         void OnEntered(atlas::scene::SceneManager& sceneManager) override;
 
+        // Writes the simulation as it stands between ticks, for a MapLoadJob to resume from.
+        bool SaveGame(const std::filesystem::path& path);
+
         void ConstructSystems(atlas::scene::SystemsBuilder& builder) override;
 
-        void OnUpdate(atlas::scene::SceneManager& sceneManager) override
-        {
-            EcsScene::OnUpdate(sceneManager);
-        }
+        void OnUpdate(atlas::scene::SceneManager& sceneManager) override;
 
         void OnRender(atlas::scene::SceneManager& sceneManager) override
         {
@@ -66,12 +72,26 @@ namespace cpp_conv
 
         struct InitialisationData
         {
-            atlas::resource::AssetPtr<resources::Map> m_Map;
+            std::shared_ptr<PreparedGameState> m_pState;
         } m_InitialisationData;
 
         struct SceneData
         {
-            EntityLookupGrid m_LookupGrid;
+            std::unique_ptr<EntityLookupGrid> m_pLookupGrid;
+            FactoryScheduler m_FactoryScheduler;
+            ChunkStreamer m_ChunkStreamer{
+                *m_pLookupGrid,
+                m_FactoryScheduler,
+                {
+                    constants::streaming::c_iThawDistance,
+                    constants::streaming::c_iFreezeDistance,
+                    constants::streaming::c_uiUpdateIntervalTicks,
+                    constants::streaming::c_uiMaxTransitionsPerUpdate,
+                    constants::streaming::c_szPageDirectory
+                }};
+            Autosaver m_Autosaver{
+                constants::autosave::c_szPath,
+                constants::autosave::c_uiIntervalTicks};
         } m_SceneData;
 
         struct RenderSystems
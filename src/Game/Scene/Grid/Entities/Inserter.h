@@ -22,6 +22,7 @@ namespace cpp_conv
         }
 
         [[nodiscard]] Direction GetDirection() const { return m_direction; }
+        [[nodiscard]] InserterId GetInserterId() const { return m_inserterId; }
 
         [[nodiscard]] const char* GetName() const { return "Inserter"; }
         [[nodiscard]] std::string GetDescription() const;
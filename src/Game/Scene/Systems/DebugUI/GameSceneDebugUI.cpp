@@ -1,6 +1,7 @@
 #include "GameSceneDebugUI.h"
 
 #include <format>
+#include <utility>
 
 #include "Constants.h"
 #include "imgui.h"
@@ -252,8 +253,22 @@ void cpp_conv::GameSceneDebugUI::Update(atlas::scene::EcsManager& ecs)
     if (ImGui::Begin("GameScene Debug UI", nullptr, flags))
     {
         addCameraDebugUi(ecs, m_pCameraRenderer);
+
+        ImGui::Separator();
+        if (ImGui::Button("Save Game"))
+        {
+            m_bSaveRequested = true;
+        }
+
+        ImGui::SameLine();
+        ImGui::Text("%s", constants::save_game::c_szPath);
     }
     ImGui::End();
 
     present();
 }
+
+bool cpp_conv::GameSceneDebugUI::ConsumeSaveRequest()
+{
+    return std::exchange(m_bSaveRequested, false);
+}
@@ -14,8 +14,13 @@ namespace cpp_conv
         void Initialise(atlas::scene::EcsManager&, atlas::game::scene::systems::cameras::CameraViewProjectionUpdateSystem*);
         void Update(atlas::scene::EcsManager& ecs) override;
 
+        // Whether the save button was pressed since the last call. The UI renders mid-frame, so the scene saves once the
+        // frame is over rather than from here.
+        [[nodiscard]] bool ConsumeSaveRequest();
+
     private:
         atlas::game::scene::systems::cameras::CameraViewProjectionUpdateSystem* m_pCameraRenderer{nullptr};
+        bool m_bSaveRequested{false};
     };
 
 }
@@ -1,7 +1,6 @@
 #include "ConveyorRenderingSystem.h"
 #include <array>
 #include <iostream>
-#include <ranges>
 
 #include "Constants.h"
 #include "ConveyorComponent.h"
@@ -56,7 +55,7 @@ void ConveyorRenderingSystem::Update(atlas::scene::EcsManager& ecs)
     };
 
     std::vector<ConveyorInstanceSet> conveyors;
-    std::map<atlas::resource::BundleRegistryId, ConveyorInstanceSet> items;
+    std::vector<ConveyorInstanceSet> items(cpp_conv::resources::getItemIndexCount());
     conveyors.reserve(Max);
     conveyors.emplace_back(atlas::resource::ResourceLoader::LoadAsset<cpp_conv::resources::registry::CoreBundle, atlas::render::ModelAsset>(
     cpp_conv::resources::registry::core_bundle::assets::conveyors::models::c_ConveyorStraight));
@@ -118,16 +117,16 @@ void ConveyorRenderingSystem::Update(atlas::scene::EcsManager& ecs)
                     continue;
                 }
 
-                // TODO: This should be cached better, the constant item definition lookups get expensive
-                const atlas::resource::AssetPtr<cpp_conv::ItemDefinition> itemAsset = cpp_conv::resources::getItemDefinition(itemSlot->m_Item);
-                if (!itemAsset || !itemAsset->GetAssetId().IsValid())
-                {
-                    continue;
-                }
-
-                auto& itemSet = items[itemAsset->GetAssetId()];
+                assert(itemSlot->m_Item.m_uiIndex < items.size());
+                auto& itemSet = items[itemSlot->m_Item.m_uiIndex];
                 if (!itemSet.m_Model)
                 {
+                    const cpp_conv::ItemDefinition* itemAsset = cpp_conv::resources::getItemDefinition(itemSlot->m_Item);
+                    if (!itemAsset || !itemAsset->GetAssetId().IsValid())
+                    {
+                        continue;
+                    }
+
                     itemSet.m_Model = atlas::resource::ResourceLoader::LoadAsset<atlas::render::ModelAsset>(itemAsset->GetAssetId());
                 }
 
@@ -187,16 +186,16 @@ void ConveyorRenderingSystem::Update(atlas::scene::EcsManager& ecs)
                     continue;
                 }
 
-                // TODO: This should be cached better, the constant item definition lookups get expensive
-                const atlas::resource::AssetPtr<cpp_conv::ItemDefinition> itemAsset = cpp_conv::resources::getItemDefinition(itemSlot->m_Item);
-                if (!itemAsset || !itemAsset->GetAssetId().IsValid())
-                {
-                    continue;
-                }
-
-                auto& itemSet = items[itemAsset->GetAssetId()];
+                assert(itemSlot->m_Item.m_uiIndex < items.size());
+                auto& itemSet = items[itemSlot->m_Item.m_uiIndex];
                 if (!itemSet.m_Model)
                 {
+                    const cpp_conv::ItemDefinition* itemAsset = cpp_conv::resources::getItemDefinition(itemSlot->m_Item);
+                    if (!itemAsset || !itemAsset->GetAssetId().IsValid())
+                    {
+                        continue;
+                    }
+
                     itemSet.m_Model = atlas::resource::ResourceLoader::LoadAsset<atlas::render::ModelAsset>(itemAsset->GetAssetId());
                 }
 
@@ -246,7 +245,7 @@ void ConveyorRenderingSystem::Update(atlas::scene::EcsManager& ecs)
         }
 
         bgfx::setMarker("Drawing Conveyor Items");
-        for(auto& item : items | std::ranges::views::values)
+        for(auto& item : items)
         {
             if (item.m_ConveyorPositions.empty())
             {
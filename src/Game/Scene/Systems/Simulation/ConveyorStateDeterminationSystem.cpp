@@ -34,13 +34,13 @@ namespace
 
     bool isCornerConveyor(
         const atlas::scene::EcsManager& ecs,
-        const cpp_conv::EntityLookupGrid& lookupGraph,
+        const cpp_conv::EntityLookupGrid::Neighbourhood& neighbourhood,
         const atlas::game::scene::components::PositionComponent& position,
         const cpp_conv::components::DirectionComponent& direction)
     {
         RelativeDirection outDirection;
         const atlas::scene::EntityId tailConverter = cpp_conv::conveyor_helper::findNextTailConveyor(
-            ecs, lookupGraph, position.m_Position, direction.m_Direction, outDirection);
+            ecs, neighbourhood, position.m_Position, direction.m_Direction, outDirection);
         if (tailConverter.IsInvalid() || outDirection == RelativeDirection::Backwards || outDirection ==
             RelativeDirection::Forward)
         {
@@ -55,13 +55,13 @@ namespace
 
     bool isClockwiseCorner(
         const atlas::scene::EcsManager& ecs,
-        const cpp_conv::EntityLookupGrid& lookupGraph,
+        const cpp_conv::EntityLookupGrid::Neighbourhood& neighbourhood,
         const atlas::game::scene::components::PositionComponent& position,
         const cpp_conv::components::DirectionComponent& direction)
     {
         RelativeDirection outDirection;
         const atlas::scene::EntityId tailConverter = cpp_conv::conveyor_helper::findNextTailConveyor(
-            ecs, lookupGraph, position.m_Position, direction.m_Direction, outDirection);
+            ecs, neighbourhood, position.m_Position, direction.m_Direction, outDirection);
         if (tailConverter.IsInvalid() || outDirection == RelativeDirection::Backwards || outDirection ==
             RelativeDirection::Forward)
         {
@@ -83,13 +83,13 @@ namespace
 
     std::tuple<int, Direction> getInnerMostCornerChannel(
         const atlas::scene::EcsManager& ecs,
-        const cpp_conv::EntityLookupGrid& lookupGraph,
+        const cpp_conv::EntityLookupGrid::Neighbourhood& neighbourhood,
         const atlas::game::scene::components::PositionComponent& position,
         const cpp_conv::components::DirectionComponent& direction)
     {
         RelativeDirection outDirection;
         const atlas::scene::EntityId tailConverter = cpp_conv::conveyor_helper::findNextTailConveyor(
-            ecs, lookupGraph, position.m_Position, direction.m_Direction, outDirection);
+            ecs, neighbourhood, position.m_Position, direction.m_Direction, outDirection);
         if (tailConverter.IsInvalid() || outDirection == RelativeDirection::Backwards || outDirection ==
             RelativeDirection::Forward)
         {
@@ -209,12 +209,19 @@ namespace
     }
 }
 
-cpp_conv::ConveyorStateDeterminationSystem::ConveyorStateDeterminationSystem(EntityLookupGrid& lookupGrid): m_LookupGrid{lookupGrid}
+cpp_conv::ConveyorStateDeterminationSystem::ConveyorStateDeterminationSystem(EntityLookupGrid& lookupGrid, const bool bStateIsPrepared)
+    : m_LookupGrid{lookupGrid}
+    , m_bStateIsPrepared{bStateIsPrepared}
 {
 }
 
 void cpp_conv::ConveyorStateDeterminationSystem::Initialise(atlas::scene::EcsManager& ecs)
 {
+    if (m_bStateIsPrepared)
+    {
+        return;
+    }
+
     using namespace components;
     using atlas::scene::EntityId;
 
@@ -228,11 +235,12 @@ void cpp_conv::ConveyorStateDeterminationSystem::Initialise(atlas::scene::EcsMan
         // Good job this doesn't run frequently...
         const auto& [info, position, direction, conveyor] = ecs.GetComponents<
             WorldEntityInformationComponent, atlas::game::scene::components::PositionComponent, DirectionComponent, ConveyorComponent>(entity);
-        const EntityId forwardEntity = m_LookupGrid.GetEntity(position_helper::getForwardPosition(position.m_Position, direction.m_Direction));
-        const EntityId backwardsEntity = m_LookupGrid.GetEntity(position_helper::getBackwardsPosition(position.m_Position, direction.m_Direction));
+        const EntityLookupGrid::Neighbourhood neighbourhood = m_LookupGrid.GetNeighbourhood(position.m_Position, direction.m_Direction);
+        const EntityId forwardEntity = neighbourhood.m_Forward;
+        const EntityId backwardsEntity = neighbourhood.m_Back;
 
-        conveyor.m_bIsCorner = isCornerConveyor(ecs, m_LookupGrid, position, direction);
-        conveyor.m_bIsClockwise = conveyor.m_bIsCorner && isClockwiseCorner(ecs, m_LookupGrid, position, direction);
+        conveyor.m_bIsCorner = isCornerConveyor(ecs, neighbourhood, position, direction);
+        conveyor.m_bIsClockwise = conveyor.m_bIsCorner && isClockwiseCorner(ecs, neighbourhood, position, direction);
 
         bool bIsCapped = true;
         if (forwardEntity.IsValid() && ecs.DoesEntityHaveComponent<WorldEntityInformationComponent>(forwardEntity))
@@ -249,34 +257,46 @@ void cpp_conv::ConveyorStateDeterminationSystem::Initialise(atlas::scene::EcsMan
         }
 
         std::tie(conveyor.m_InnerMostChannel, conveyor.m_CornerDirection) = getInnerMostCornerChannel(
-            ecs, m_LookupGrid, position, direction);
+            ecs, neighbourhood, position, direction);
 
-        for (auto iLane = 0; iLane < conveyor.m_Channels.size(); iLane++)
-        {
-            conveyor.m_Channels[iLane].m_ChannelLane = iLane;
-            conveyor.m_Channels[iLane].m_LaneLength = 2;
-            if (conveyor.m_bIsCorner)
-            {
-                conveyor.m_Channels[iLane].m_LaneLength += conveyor.m_InnerMostChannel == iLane ? -1 : 1;
-            }
+        ApplyCornerState(ecs, entity);
+    }
+}
 
-            for (auto iSlot = 0; iSlot < conveyor.m_Channels[iLane].m_pSlots.size(); iSlot++)
-            {
-                conveyor.m_Channels[iLane].m_pSlots[iSlot].m_VisualPosition = getRenderPosition(
-                    position, direction, conveyor, {iLane, iSlot});
-            }
-        }
+void cpp_conv::ConveyorStateDeterminationSystem::ApplyCornerState(
+    atlas::scene::EcsManager& ecs,
+    const atlas::scene::EntityId entity)
+{
+    using namespace components;
+
+    const auto& [position, direction, conveyor] = ecs.GetComponents<
+        atlas::game::scene::components::PositionComponent, DirectionComponent, ConveyorComponent>(entity);
 
-        const bool bAlreadyHasIndividual = ecs.DoesEntityHaveComponent<IndividuallyProcessableConveyorComponent>(entity);
-        if (conveyor.m_bIsCorner && !bAlreadyHasIndividual)
+    for (auto iLane = 0; iLane < conveyor.m_Channels.size(); iLane++)
+    {
+        conveyor.m_Channels[iLane].m_ChannelLane = iLane;
+        conveyor.m_Channels[iLane].m_LaneLength = 2;
+        if (conveyor.m_bIsCorner)
         {
-            ecs.AddComponent<IndividuallyProcessableConveyorComponent>(entity);
+            conveyor.m_Channels[iLane].m_LaneLength += conveyor.m_InnerMostChannel == iLane ? -1 : 1;
         }
-        else if (!conveyor.m_bIsCorner && bAlreadyHasIndividual)
+
+        for (auto iSlot = 0; iSlot < conveyor.m_Channels[iLane].m_pSlots.size(); iSlot++)
         {
-            ecs.RemoveComponent<IndividuallyProcessableConveyorComponent>(entity);
+            conveyor.m_Channels[iLane].m_pSlots[iSlot].m_VisualPosition = getRenderPosition(
+                position, direction, conveyor, {iLane, iSlot});
         }
     }
+
+    const bool bAlreadyHasIndividual = ecs.DoesEntityHaveComponent<IndividuallyProcessableConveyorComponent>(entity);
+    if (conveyor.m_bIsCorner && !bAlreadyHasIndividual)
+    {
+        ecs.AddComponent<IndividuallyProcessableConveyorComponent>(entity);
+    }
+    else if (!conveyor.m_bIsCorner && bAlreadyHasIndividual)
+    {
+        ecs.RemoveComponent<IndividuallyProcessableConveyorComponent>(entity);
+    }
 }
 
 void cpp_conv::ConveyorStateDeterminationSystem::Update(atlas::scene::EcsManager&)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "AtlasScene/ECS/Entity.h"
 #include "AtlasScene/ECS/Systems/SystemBase.h"
 
 namespace cpp_conv
@@ -9,13 +10,19 @@ namespace cpp_conv
     class ConveyorStateDeterminationSystem final : public atlas::scene::SystemBase
     {
     public:
-        explicit ConveyorStateDeterminationSystem(EntityLookupGrid& lookupGrid);
+        // bStateIsPrepared skips Initialise, for scenes whose state was already run through this system while loading.
+        explicit ConveyorStateDeterminationSystem(EntityLookupGrid& lookupGrid, bool bStateIsPrepared = false);
         void Initialise(atlas::scene::EcsManager& ecs) override;
         void Update(atlas::scene::EcsManager&) override;
 
+        // Lays out the lanes of a conveyor whose corner state is already known, and tags it for individual processing
+        // if it is a corner. For conveyors whose neighbours are not all constructed, e.g. when restoring a region.
+        static void ApplyCornerState(atlas::scene::EcsManager& ecs, atlas::scene::EntityId entity);
+
     private:
         inline static constexpr int c_MaxSequenceLength = 32;
 
         EntityLookupGrid& m_LookupGrid;
+        bool m_bStateIsPrepared;
     };
 }
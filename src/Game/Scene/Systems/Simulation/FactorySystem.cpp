@@ -1,112 +1,120 @@
 #include "FactorySystem.h"
 
+#include <algorithm>
+#include <execution>
+
+#include "CompiledRecipe.h"
 #include "ConveyorComponent.h"
 #include "DirectionComponent.h"
 #include "EntityLookupGrid.h"
 #include "FactoryComponent.h"
+#include "FactoryScheduler.h"
+#include "ItemInputStaging.h"
 #include "ItemPassingUtility.h"
 #include "PositionHelper.h"
+#include "RecipeRegistry.h"
+#include "SequenceComponent.h"
 #include "Transform2D.h"
 #include "AtlasGame/Scene/Components/PositionComponent.h"
 #include "AtlasScene/ECS/Components/EcsManager.h"
 
 namespace
 {
-    bool isReadyToProduce(const cpp_conv::components::FactoryComponent& factory)
+    uint64_t getProductionDuration(
+        const cpp_conv::components::FactoryComponent& factory,
+        const cpp_conv::CompiledRecipe& recipe)
     {
-        return factory.m_RemainingCurrentProductionEffort == 0;
+        const uint32_t uiRate = std::max(factory.m_ProductionRate, 1U);
+        return std::max((recipe.m_uiEffort + uiRate - 1) / uiRate, 1U);
     }
 
-    bool trySatisfyRecipeInput(cpp_conv::components::FactoryComponent& factory)
+    bool trySatisfyRecipeInput(
+        cpp_conv::components::FactoryComponent& factory,
+        const cpp_conv::CompiledRecipe& recipe)
     {
-        if (!factory.m_Recipe.has_value())
-        {
-            return false;
-        }
-
-        if (factory.m_Recipe->m_InputItems.empty())
+        for (const auto& item : recipe.GetInputItems())
         {
-            return true;
-        }
-
-        for (const auto& pItem : factory.m_Recipe->m_InputItems)
-        {
-            bool bIsMet = false;
-            for (auto& rStorageItem : factory.m_InputItems.GetItems())
-            {
-                if (rStorageItem.m_pItem == pItem.m_Item && rStorageItem.m_pCount >= pItem.m_Count)
-                {
-                    bIsMet = true;
-                    break;
-                }
-            }
-
-            if (!bIsMet)
+            if (!factory.m_InputItems.HasItems(item.m_Item, item.m_uiCount))
             {
                 return false;
             }
         }
 
-        for (const auto& pItem : factory.m_Recipe->m_InputItems)
+        for (const auto& item : recipe.GetInputItems())
         {
-            factory.m_InputItems.TryTake(pItem.m_Item, pItem.m_Count);
+            factory.m_InputItems.TryTake(item.m_Item, item.m_uiCount);
         }
 
         return true;
     }
 
-    bool produceItems(cpp_conv::components::FactoryComponent& factory)
+    bool couldStoreOutputs(
+        const cpp_conv::components::FactoryComponent& factory,
+        const cpp_conv::CompiledRecipe& recipe)
     {
-        if (!factory.m_Recipe.has_value())
+        for (const auto& item : recipe.GetOutputItems())
         {
-            return false;
+            if (!factory.m_OutputItems.CouldInsert(item.m_Item, item.m_uiCount))
+            {
+                return false;
+            }
         }
 
-        const auto& vOutputItems = factory.m_Recipe->m_OutputItems;
-        if (vOutputItems.empty())
-        {
-            return true;
-        }
+        return true;
+    }
 
-        for (const auto& pItem : vOutputItems)
+    bool produceItems(
+        cpp_conv::components::FactoryComponent& factory,
+        const cpp_conv::CompiledRecipe& recipe)
+    {
+        if (!couldStoreOutputs(factory, recipe))
         {
-            if (!factory.m_OutputItems.CouldInsert(pItem.m_Item, pItem.m_Count))
-            {
-                return false;
-            }
+            return false;
         }
 
-        for (const auto& pItem : vOutputItems)
+        for (const auto& item : recipe.GetOutputItems())
         {
-            factory.m_OutputItems.TryInsert(pItem.m_Item, pItem.m_Count);
+            factory.m_OutputItems.TryInsert(item.m_Item, item.m_uiCount);
         }
 
         return true;
     }
 
-    void runProductionCycle(cpp_conv::components::FactoryComponent& factory)
+    void runProductionCycle(
+        cpp_conv::components::FactoryComponent& factory,
+        cpp_conv::components::ItemInputStaging* pStaging,
+        const uint64_t uiTick)
     {
-        if (!factory.m_bIsDemandSatisfied)
+        const cpp_conv::CompiledRecipe* pRecipe = cpp_conv::resources::getCompiledRecipe(factory.m_Recipe);
+        if (!pRecipe)
         {
-            if (!trySatisfyRecipeInput(factory))
-            {
-                return;
-            }
-
-            factory.m_bIsDemandSatisfied = true;
+            return;
         }
 
-        if (!isReadyToProduce(factory))
+        while (true)
         {
-            factory.m_RemainingCurrentProductionEffort -= factory.m_ProductionRate;
-            if (!isReadyToProduce(factory))
+            if (!factory.m_bIsDemandSatisfied)
+            {
+                if (!trySatisfyRecipeInput(factory, *pRecipe))
+                {
+                    return;
+                }
+
+                // Taking the inputs made room for whoever was turned away while they were full.
+                if (pStaging)
+                {
+                    pStaging->WakeBlockedSenders();
+                }
+
+                factory.m_bIsDemandSatisfied = true;
+                factory.m_uiProductionCompleteTick = uiTick + getProductionDuration(factory, *pRecipe);
+            }
+
+            if (factory.m_uiProductionCompleteTick > uiTick || !produceItems(factory, *pRecipe))
             {
                 return;
             }
-        }
 
-        if (produceItems(factory))
-        {
             factory.m_bIsDemandSatisfied = false;
         }
     }
@@ -132,18 +140,67 @@ namespace
         return {input.x(), input.y()};
     }
 
-    void runOutputCycle(
+    constexpr uint32_t c_uiMaxOutputRetryInterval = 64;
+
+    // Nothing announces an entity turning up at an output pipe, so the factory looks again after a growing delay.
+    uint64_t getUntargetedRetryTick(cpp_conv::components::FactoryComponent& factory, const uint64_t uiTick)
+    {
+        factory.m_uiOutputRetryInterval =
+            std::clamp(factory.m_uiOutputRetryInterval * 2, 1U, c_uiMaxOutputRetryInterval);
+        return uiTick + factory.m_uiOutputRetryInterval;
+    }
+
+    // Conveyors only free their head slots when they move, so a factory blocked on one can sleep until then. Factories
+    // and storage wake the senders they turned away once they have made room.
+    std::optional<uint64_t> getOutputRetryTick(
+        atlas::scene::EcsManager& ecs,
+        cpp_conv::FactoryScheduler& scheduler,
+        const atlas::scene::EntityId entity,
+        cpp_conv::components::FactoryComponent& factory,
+        const atlas::scene::EntityId targetEntity,
+        const uint64_t uiTick)
+    {
+        using namespace cpp_conv::components;
+
+        if (!ecs.DoesEntityHaveComponent<ConveyorComponent>(targetEntity))
+        {
+            if (!ecs.DoesEntityHaveComponent<ItemInputStaging>(targetEntity))
+            {
+                return getUntargetedRetryTick(factory, uiTick);
+            }
+
+            ecs.GetComponent<ItemInputStaging>(targetEntity).AddBlockedSender(scheduler, entity);
+            return {};
+        }
+
+        const auto& conveyor = ecs.GetComponent<ConveyorComponent>(targetEntity);
+        uint32_t uiCurrentTick = conveyor.m_CurrentTick;
+        uint32_t uiMoveTick = conveyor.m_MoveTick;
+        if (!conveyor.m_Sequence.IsInvalid() && ecs.DoesEntityHaveComponent<SequenceComponent>(conveyor.m_Sequence))
+        {
+            const auto& sequence = ecs.GetComponent<SequenceComponent>(conveyor.m_Sequence);
+            uiCurrentTick = sequence.m_CurrentTick;
+            uiMoveTick = sequence.m_MoveTick;
+        }
+
+        return uiTick + (uiMoveTick > uiCurrentTick ? uiMoveTick - uiCurrentTick : 1);
+    }
+
+    // Returns the tick to retry at if items are left behind, or nothing if the output is empty or will be woken.
+    std::optional<uint64_t> runOutputCycle(
         atlas::scene::EcsManager& ecs,
         const cpp_conv::EntityLookupGrid& grid,
+        cpp_conv::FactoryScheduler& scheduler,
         const atlas::scene::EntityId entity,
-        cpp_conv::components::FactoryComponent& factory)
+        cpp_conv::components::FactoryComponent& factory,
+        const uint64_t uiTick)
     {
         if (!factory.m_OutputPipe.has_value() ||
             factory.m_OutputItems.IsEmpty() ||
             !ecs.DoesEntityHaveComponents<atlas::game::scene::components::PositionComponent,
                                           cpp_conv::components::DirectionComponent>(entity))
         {
-            return;
+            return {};
         }
 
         const auto& [position, direction] = ecs.GetComponents<
@@ -165,52 +222,183 @@ namespace
         const auto targetEntity = grid.GetEntity(cpp_conv::position_helper::getForwardPosition(pipe, direction.m_Direction));
         if (targetEntity.IsInvalid() || !cpp_conv::item_passing_utility::entitySupportsInsertion(ecs, targetEntity))
         {
-            return;
+            return getUntargetedRetryTick(factory, uiTick);
         }
 
-        auto& vContainerItems = factory.m_OutputItems.GetItems();
-        auto itItems = vContainerItems.begin();
-        while (itItems != vContainerItems.end())
+        factory.m_uiOutputRetryInterval = 0;
+
+        const auto& vStoredItems = factory.m_OutputItems.GetStoredItems();
+        while (!vStoredItems.empty())
         {
-            for (uint32_t i = 0; i < itItems->m_pCount; ++i)
-            {
-                if (!cpp_conv::item_passing_utility::tryInsertItem(
-                    ecs,
-                    grid,
-                    entity,
-                    targetEntity,
-                    itItems->m_pItem,
-                    (factory.m_Tick + i) % cpp_conv::components::c_conveyorChannels,
-                    {}))
+            const cpp_conv::ItemIndex item = vStoredItems.front();
+            const uint32_t uiCount = factory.m_OutputItems.GetItemCount(item);
 
-                {
-                    itItems->m_pCount--;
-                }
-            }
+            const uint32_t uiInserted = cpp_conv::item_passing_utility::tryInsertItemsFromAnyChannel(
+                ecs,
+                grid,
+                entity,
+                targetEntity,
+                item,
+                uiCount,
+                static_cast<int>(uiTick % cpp_conv::components::c_conveyorChannels));
 
-            if (itItems->m_pCount == 0)
-            {
-                itItems = vContainerItems.erase(itItems);
-            }
-            else
+            factory.m_OutputItems.TryTake(item, uiInserted);
+            if (uiInserted != uiCount)
             {
-                break;
+                return getOutputRetryTick(ecs, scheduler, entity, factory, targetEntity, uiTick);
             }
         }
+
+        return {};
+    }
+
+    void scheduleFactory(
+        cpp_conv::FactoryScheduler& scheduler,
+        const atlas::scene::EntityId entity,
+        cpp_conv::components::FactoryComponent& factory,
+        const uint64_t uiTick)
+    {
+        // An earlier live timer will revisit the factory anyway, and it can reschedule from there.
+        if (factory.m_uiScheduledTick > scheduler.GetCurrentTick() && factory.m_uiScheduledTick <= uiTick)
+        {
+            return;
+        }
+
+        factory.m_uiScheduledTick = uiTick;
+        scheduler.Schedule(entity, uiTick);
+    }
+
+    // Hands off whatever the production phase left in the output, then decides when the factory next needs a visit.
+    void runHandoff(
+        atlas::scene::EcsManager& ecs,
+        const cpp_conv::EntityLookupGrid& grid,
+        cpp_conv::FactoryScheduler& scheduler,
+        const atlas::scene::EntityId entity,
+        cpp_conv::components::FactoryComponent& factory,
+        cpp_conv::components::ItemInputStaging* pStaging)
+    {
+        const uint64_t uiTick = scheduler.GetCurrentTick();
+        std::optional<uint64_t> nextTick = runOutputCycle(ecs, grid, scheduler, entity, factory, uiTick);
+
+        // Production that was blocked on a full output runs again now that the hand-off has made room, and its output
+        // goes out in the same visit, as it would have if the factory had been updated on its own.
+        if (factory.m_bIsDemandSatisfied &&
+            factory.m_uiProductionCompleteTick <= uiTick &&
+            couldStoreOutputs(factory, *cpp_conv::resources::getCompiledRecipe(factory.m_Recipe)))
+        {
+            runProductionCycle(factory, pStaging, uiTick);
+            nextTick = runOutputCycle(ecs, grid, scheduler, entity, factory, uiTick);
+        }
+
+        // Items that arrived while the inputs were full get another chance once production has made room.
+        if (pStaging && pStaging->CouldStoreHeldBackItems(factory.m_InputItems))
+        {
+            nextTick = uiTick + 1;
+        }
+
+        if (factory.m_bIsDemandSatisfied && factory.m_uiProductionCompleteTick > uiTick)
+        {
+            nextTick = std::min(nextTick.value_or(factory.m_uiProductionCompleteTick), factory.m_uiProductionCompleteTick);
+        }
+
+        // Without a next tick the factory is either starved or blocked on a factory or storage, and parks until an
+        // input arrives or the target wakes it.
+        if (nextTick.has_value())
+        {
+            scheduleFactory(scheduler, entity, factory, nextTick.value());
+        }
     }
 }
 
-cpp_conv::FactorySystem::FactorySystem(EntityLookupGrid& lookupGrid): m_LookupGrid{lookupGrid}
+cpp_conv::FactorySystem::FactorySystem(EntityLookupGrid& lookupGrid, FactoryScheduler& scheduler)
+    : m_LookupGrid{lookupGrid}
+      , m_Scheduler{scheduler}
 {
 }
 
-void cpp_conv::FactorySystem::Update(atlas::scene::EcsManager& ecs)
+void cpp_conv::FactorySystem::Initialise(atlas::scene::EcsManager& ecs)
 {
     for (const auto entity : ecs.GetEntitiesWithComponents<components::FactoryComponent>())
     {
         auto& factory = ecs.GetComponent<components::FactoryComponent>(entity);
-        factory.m_Tick++;
-        runProductionCycle(factory);
-        runOutputCycle(ecs, m_LookupGrid, entity, factory);
+        if (ecs.DoesEntityHaveComponent<components::ItemInputStaging>(entity))
+        {
+            ecs.GetComponent<components::ItemInputStaging>(entity).SetWakeTarget(&m_Scheduler, entity);
+        }
+
+        scheduleFactory(m_Scheduler, entity, factory, m_Scheduler.GetCurrentTick() + 1);
     }
 }
+
+void cpp_conv::FactorySystem::Update(atlas::scene::EcsManager& ecs)
+{
+    const uint64_t uiTick = m_Scheduler.GetCurrentTick() + 1;
+
+    m_vDueFactories.clear();
+    m_Scheduler.Advance([&](const atlas::scene::EntityId entity, const uint64_t uiScheduledTick)
+    {
+        if (!ecs.DoesEntityHaveComponent<components::FactoryComponent>(entity))
+        {
+            return;
+        }
+
+        auto& factory = ecs.GetComponent<components::FactoryComponent>(entity);
+        const bool bIsStale =
+            uiScheduledTick != FactoryScheduler::c_uiWakeTick && uiScheduledTick != factory.m_uiScheduledTick;
+        if (bIsStale || factory.m_uiLastUpdateTick == uiTick)
+        {
+            return;
+        }
+
+        factory.m_uiLastUpdateTick = uiTick;
+        if (factory.m_uiScheduledTick <= uiTick)
+        {
+            factory.m_uiScheduledTick = 0;
+        }
+
+        components::ItemInputStaging* pStaging = nullptr;
+        if (ecs.DoesEntityHaveComponent<components::ItemInputStaging>(entity))
+        {
+            pStaging = &ecs.GetComponent<components::ItemInputStaging>(entity);
+            pStaging->Drain(factory.m_InputItems);
+        }
+
+        m_vDueFactories.push_back({entity, &factory, pStaging});
+    });
+
+    RunProductionPhase(uiTick);
+
+    // Output is handed off in schedule order so that contention for conveyor slots resolves the same way regardless of
+    // how production was split across threads.
+    for (const auto& [entity, pFactory, pStaging] : m_vDueFactories)
+    {
+        runHandoff(ecs, m_LookupGrid, m_Scheduler, entity, *pFactory, pStaging);
+    }
+}
+
+void cpp_conv::FactorySystem::RunProductionPhase(const uint64_t uiTick)
+{
+    // Production only reads and writes the factory's own containers, so batches are independent of one another.
+    const auto runBatch = [uiTick](const std::span<DueFactory> batch)
+    {
+        for (const DueFactory& due : batch)
+        {
+            runProductionCycle(*due.m_pFactory, due.m_pStaging, uiTick);
+        }
+    };
+
+    if (m_vDueFactories.size() <= c_uiProductionBatchSize)
+    {
+        runBatch(m_vDueFactories);
+        return;
+    }
+
+    m_vBatches.clear();
+    for (size_t uiStart = 0; uiStart < m_vDueFactories.size(); uiStart += c_uiProductionBatchSize)
+    {
+        const size_t uiCount = std::min(c_uiProductionBatchSize, m_vDueFactories.size() - uiStart);
+        m_vBatches.emplace_back(m_vDueFactories.data() + uiStart, uiCount);
+    }
+
+    std::for_each(std::execution::par, m_vBatches.begin(), m_vBatches.end(), runBatch);
+}
@@ -1,17 +1,47 @@
 #pragma once
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "AtlasScene/ECS/Entity.h"
 #include "AtlasScene/ECS/Systems/SystemBase.h"
 
 namespace cpp_conv
 {
     class EntityLookupGrid;
+    class FactoryScheduler;
+
+    namespace components
+    {
+        struct FactoryComponent;
+        class ItemInputStaging;
+    }
 
+    // Runs in two phases each tick: production for all due factories in parallel batches, then a serial hand-off of
+    // their outputs in schedule order.
     class FactorySystem final : public atlas::scene::SystemBase
     {
     public:
-        explicit FactorySystem(EntityLookupGrid& lookupGrid);
+        FactorySystem(EntityLookupGrid& lookupGrid, FactoryScheduler& scheduler);
+        void Initialise(atlas::scene::EcsManager& ecs) override;
         void Update(atlas::scene::EcsManager&) override;
 
     private:
+        static constexpr size_t c_uiProductionBatchSize = 256;
+
+        struct DueFactory
+        {
+            atlas::scene::EntityId m_Entity;
+            components::FactoryComponent* m_pFactory;
+            components::ItemInputStaging* m_pStaging;
+        };
+
+        void RunProductionPhase(uint64_t uiTick);
+
         EntityLookupGrid& m_LookupGrid;
+        FactoryScheduler& m_Scheduler;
+
+        std::vector<DueFactory> m_vDueFactories;
+        std::vector<std::span<DueFactory>> m_vBatches;
     };
 }
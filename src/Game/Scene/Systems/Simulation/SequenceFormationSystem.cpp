@@ -1,5 +1,9 @@
 #include "SequenceFormationSystem.h"
 
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
 #include "ConveyorComponent.h"
 #include "ConveyorHelper.h"
 #include "DirectionComponent.h"
@@ -11,10 +15,12 @@
 
 namespace
 {
+    // With bStopAtSequenced, conveyors which already belong to a sequence end the trace as if they were corners.
     atlas::scene::EntityId traceHeadConveyor(
         const atlas::scene::EcsManager& ecs,
-        cpp_conv::EntityLookupGrid& grid,
-        atlas::scene::EntityId currentConveyor)
+        const cpp_conv::EntityLookupGrid& grid,
+        atlas::scene::EntityId currentConveyor,
+        const bool bStopAtSequenced = false)
     {
         using namespace cpp_conv::components;
         using atlas::scene::EntityId;
@@ -43,24 +49,19 @@ namespace
 
             auto [targetPosition, targetDirection, targetConveyor] = ecs.GetComponents<
                 atlas::game::scene::components::PositionComponent, DirectionComponent, ConveyorComponent>(targetEntity);
-            if (targetConveyor.m_bIsCorner)
+            if (targetConveyor.m_bIsCorner || (bStopAtSequenced && targetConveyor.m_Sequence.IsValid()))
             {
                 break;
             }
 
             // Check that the route ahead of us doesn't have another potential chain which would take priority over this
             {
-                Eigen::Vector3i vPotentialNeighbours[4];
-                vPotentialNeighbours[static_cast<int>(RelativeDirection::Backwards)] =
-                    cpp_conv::position_helper::getBackwardsPosition(targetPosition.m_Position, targetDirection.m_Direction);
-                vPotentialNeighbours[static_cast<int>(RelativeDirection::Right)] = cpp_conv::position_helper::getRightPosition(
-                    targetPosition.m_Position, targetDirection.m_Direction);
-                vPotentialNeighbours[static_cast<int>(RelativeDirection::Left)] = cpp_conv::position_helper::getLeftPosition(
+                const cpp_conv::EntityLookupGrid::Neighbourhood targetNeighbourhood = grid.GetNeighbourhood(
                     targetPosition.m_Position, targetDirection.m_Direction);
 
                 for (auto neighbourCell : directionPriority)
                 {
-                    auto neighbourEntity = grid.GetEntity(vPotentialNeighbours[static_cast<int>(neighbourCell)]);
+                    auto neighbourEntity = targetNeighbourhood.Get(neighbourCell);
                     if (neighbourEntity == EntityId::Invalid() || !ecs.DoesEntityHaveComponents<
                         atlas::game::scene::components::PositionComponent, DirectionComponent, ConveyorComponent>(neighbourEntity))
                     {
@@ -97,10 +98,11 @@ namespace
 
     atlas::scene::EntityId traceTailConveyor(
         atlas::scene::EcsManager& ecs,
-        cpp_conv::EntityLookupGrid& grid,
+        const cpp_conv::EntityLookupGrid& grid,
         atlas::scene::EntityId searchStart,
         atlas::scene::EntityId head,
-        std::vector<atlas::scene::EntityId>& vOutConveyors)
+        std::vector<atlas::scene::EntityId>& vOutConveyors,
+        const bool bStopAtSequenced = false)
     {
         using namespace cpp_conv::components;
         using atlas::scene::EntityId;
@@ -126,7 +128,7 @@ namespace
             }
 
             const auto& targetConveyorComponent = ecs.GetComponent<ConveyorComponent>(targetConveyor);
-            if (targetConveyorComponent.m_bIsCorner)
+            if (targetConveyorComponent.m_bIsCorner || (bStopAtSequenced && targetConveyorComponent.m_Sequence.IsValid()))
             {
                 break;
             }
@@ -137,14 +139,38 @@ namespace
         std::ranges::reverse(vOutConveyors);
         return currentConveyor;
     }
+
+    // Splits a chain of conveyors, ordered tail to head, into spans no longer than a sequence may be.
+    template <typename TCallback>
+    void forEachSequenceSpan(const std::span<const atlas::scene::EntityId> chain, TCallback&& callback)
+    {
+        constexpr size_t c_uiMaxLength = cpp_conv::SequenceFormationSystem::c_MaxSequenceLength;
+        for (size_t uiStart = 0; uiStart < chain.size(); uiStart += c_uiMaxLength)
+        {
+            callback(chain.subspan(uiStart, std::min(c_uiMaxLength, chain.size() - uiStart)));
+        }
+    }
+
+    // Lane bits run from the head conveyor's leading slot at bit 0 back to the tail's first slot.
+    uint64_t getLaneBit(const size_t uiLength, const size_t uiSequenceIndex, const int iSlot)
+    {
+        return 1ULL << (uiLength * 2 - uiSequenceIndex * 2 - static_cast<size_t>(iSlot) - 1);
+    }
 }
 
-cpp_conv::SequenceFormationSystem::SequenceFormationSystem(EntityLookupGrid& lookupGrid): m_LookupGrid{lookupGrid}
+cpp_conv::SequenceFormationSystem::SequenceFormationSystem(EntityLookupGrid& lookupGrid, const bool bStateIsPrepared)
+    : m_LookupGrid{lookupGrid}
+    , m_bStateIsPrepared{bStateIsPrepared}
 {
 }
 
 void cpp_conv::SequenceFormationSystem::Initialise(atlas::scene::EcsManager& ecs)
 {
+    if (m_bStateIsPrepared)
+    {
+        return;
+    }
+
     using namespace components;
     using atlas::scene::EntityId;
 
@@ -178,51 +204,180 @@ void cpp_conv::SequenceFormationSystem::Initialise(atlas::scene::EcsManager& ecs
         const EntityId pHeadConveyor = traceHeadConveyor(ecs, m_LookupGrid, entity);
         traceTailConveyor(ecs, m_LookupGrid, pHeadConveyor, pHeadConveyor, vConveyors);
 
-        const auto end = vConveyors.end();
-        std::vector<EntityId>::iterator chunk_begin;
-        std::vector<EntityId>::iterator chunk_end;
-        chunk_end = chunk_begin = vConveyors.begin();
-        do
+        forEachSequenceSpan(vConveyors, [&](const std::span<const EntityId> sequenceConveyors)
         {
-            if (static_cast<uint32_t>(std::distance(chunk_end, end)) < c_MaxSequenceLength)
+            CreateSequence(ecs, sequenceConveyors);
+            for (const EntityId conveyor : sequenceConveyors)
             {
-                chunk_end = end;
+                alreadyProcessedConveyors.insert(conveyor);
             }
-            else
+        });
+    }
+}
+
+atlas::scene::EntityId cpp_conv::SequenceFormationSystem::CreateSequence(
+    atlas::scene::EcsManager& ecs,
+    const std::span<const atlas::scene::EntityId> conveyors)
+{
+    using namespace components;
+    using atlas::scene::EntityId;
+
+    const auto& pTailConveyor = ecs.GetComponent<ConveyorComponent>(conveyors.front());
+    const auto unitDirection2d =
+        pTailConveyor.m_Channels[0].m_pSlots[1].m_VisualPosition - pTailConveyor.m_Channels[0].m_pSlots[0].
+        m_VisualPosition;
+    const auto normalizedUnitDirection2d = unitDirection2d.normalized();
+
+    const EntityId sequenceId = ecs.AddEntity();
+    ecs.AddComponent<SequenceComponent>(
+        sequenceId,
+        static_cast<uint8_t>(conveyors.size()),
+        conveyors.back(),
+        pTailConveyor.m_Channels[0].m_pSlots[0].m_VisualPosition,
+        pTailConveyor.m_Channels[1].m_pSlots[0].m_VisualPosition,
+        Eigen::Vector3f(normalizedUnitDirection2d.x(), normalizedUnitDirection2d.y(), 0.0f),
+        pTailConveyor.m_MoveTick
+    );
+
+    for (size_t i = 0; i < conveyors.size(); ++i)
+    {
+        auto& localConveyor = ecs.GetComponent<ConveyorComponent>(conveyors[i]);
+        localConveyor.m_Sequence = sequenceId;
+        localConveyor.m_SequenceIndex = static_cast<uint8_t>(i);
+    }
+
+    return sequenceId;
+}
+
+void cpp_conv::SequenceFormationSystem::FormSequences(
+    atlas::scene::EcsManager& ecs,
+    const EntityLookupGrid& grid,
+    const std::span<const atlas::scene::EntityId> conveyors)
+{
+    using namespace components;
+    using atlas::scene::EntityId;
+
+    std::vector<EntityId> vChain;
+    for (const EntityId entity : conveyors)
+    {
+        if (!ecs.DoesEntityHaveComponents<
+                atlas::game::scene::components::PositionComponent, DirectionComponent, ConveyorComponent>(entity))
+        {
+            continue;
+        }
+
+        const auto& conveyor = ecs.GetComponent<ConveyorComponent>(entity);
+        if (conveyor.m_bIsCorner || conveyor.m_Sequence.IsValid())
+        {
+            continue;
+        }
+
+        vChain.clear();
+        const EntityId head = traceHeadConveyor(ecs, grid, entity, true);
+        traceTailConveyor(ecs, grid, head, head, vChain, true);
+
+        forEachSequenceSpan(vChain, [&ecs](const std::span<const EntityId> sequenceConveyors)
+        {
+            const EntityId sequenceId = CreateSequence(ecs, sequenceConveyors);
+            auto& sequence = ecs.GetComponent<SequenceComponent>(sequenceId);
+            sequence.m_CurrentTick = ecs.GetComponent<ConveyorComponent>(sequenceConveyors.front()).m_CurrentTick;
+
+            // Lane bits ascend from the head, which is also the order the items are kept in.
+            const size_t uiLength = sequenceConveyors.size();
+            for (size_t uiIndex = uiLength; uiIndex-- > 0;)
             {
-                std::advance(chunk_end, c_MaxSequenceLength);
+                auto& conveyor = ecs.GetComponent<ConveyorComponent>(sequenceConveyors[uiIndex]);
+                for (int iChannel = 0; iChannel < components::c_conveyorChannels; ++iChannel)
+                {
+                    SequenceComponent::RealizedState& state = sequence.m_RealizedStates[iChannel];
+                    ConveyorComponent::Channel& channel = conveyor.m_Channels[iChannel];
+                    for (int iSlot = components::c_conveyorChannelSlots; iSlot-- > 0;)
+                    {
+                        ConveyorComponent::PlacedItem& placed = channel.m_pSlots[iSlot].m_Item;
+                        if (!placed.m_Item.IsEmpty())
+                        {
+                            state.m_Lanes |= getLaneBit(uiLength, uiIndex, iSlot);
+                            state.m_Items.Push({placed.m_Item});
+                        }
+
+                        placed = {};
+                    }
+                }
+
+                if (ecs.DoesEntityHaveComponent<IndividuallyProcessableConveyorComponent>(sequenceConveyors[uiIndex]))
+                {
+                    ecs.RemoveComponent<IndividuallyProcessableConveyorComponent>(sequenceConveyors[uiIndex]);
+                }
             }
+        });
+    }
+}
+
+void cpp_conv::SequenceFormationSystem::DissolveSequence(
+    atlas::scene::EcsManager& ecs,
+    const EntityLookupGrid& grid,
+    const atlas::scene::EntityId sequenceId,
+    std::vector<atlas::scene::EntityId>& vOutConveyors)
+{
+    using namespace components;
+    using atlas::game::scene::components::PositionComponent;
+    using atlas::scene::EntityId;
 
-            std::vector vSequenceConveyors(chunk_begin, chunk_end);
-            const auto& pTailConveyor = ecs.GetComponent<ConveyorComponent>(vSequenceConveyors.front());
-            const auto unitDirection2d =
-                pTailConveyor.m_Channels[0].m_pSlots[1].m_VisualPosition - pTailConveyor.m_Channels[0].m_pSlots[0].
-                m_VisualPosition;
-            const auto normalizedUnitDirection2d = unitDirection2d.normalized();
-
-            const EntityId sequenceId = ecs.AddEntity();
-            SequenceComponent& component = ecs.AddComponent<SequenceComponent>(
-                sequenceId,
-                static_cast<uint8_t>(vSequenceConveyors.size()),
-                vSequenceConveyors[vSequenceConveyors.size() - 1],
-                pTailConveyor.m_Channels[0].m_pSlots[0].m_VisualPosition,
-                pTailConveyor.m_Channels[1].m_pSlots[0].m_VisualPosition,
-                Eigen::Vector3f(normalizedUnitDirection2d.x(), normalizedUnitDirection2d.y(), 0.0f),
-                pTailConveyor.m_MoveTick
-            );
-
-            for (size_t i = 0; i < vSequenceConveyors.size(); ++i)
+    const auto& sequence = ecs.GetComponent<SequenceComponent>(sequenceId);
+    const size_t uiLength = sequence.m_Length;
+
+    // Only the head is known, so the rest are found walking back through whichever neighbour holds the next index.
+    const size_t uiFirst = vOutConveyors.size();
+    vOutConveyors.resize(uiFirst + uiLength, EntityId::Invalid());
+    std::span<EntityId> conveyors{vOutConveyors.data() + uiFirst, uiLength};
+    conveyors[uiLength - 1] = sequence.m_HeadConveyor;
+    for (size_t uiIndex = uiLength - 1; uiIndex > 0; --uiIndex)
+    {
+        const auto& [position, direction] = ecs.GetComponents<PositionComponent, DirectionComponent>(conveyors[uiIndex]);
+        const EntityLookupGrid::Neighbourhood neighbourhood = grid.GetNeighbourhood(position.m_Position, direction.m_Direction);
+        for (const EntityId candidate : {neighbourhood.m_Back, neighbourhood.m_Left, neighbourhood.m_Right})
+        {
+            if (candidate.IsValid() &&
+                ecs.DoesEntityHaveComponent<ConveyorComponent>(candidate) &&
+                ecs.GetComponent<ConveyorComponent>(candidate).m_Sequence == sequenceId &&
+                ecs.GetComponent<ConveyorComponent>(candidate).m_SequenceIndex == uiIndex - 1)
             {
-                auto& localConveyor = ecs.GetComponent<ConveyorComponent>(vSequenceConveyors[i]);
-                localConveyor.m_Sequence = sequenceId;
-                localConveyor.m_SequenceIndex = static_cast<uint8_t>(i);
-                alreadyProcessedConveyors.insert(vSequenceConveyors[i]);
+                conveyors[uiIndex - 1] = candidate;
+                break;
             }
+        }
 
-            chunk_begin = chunk_end;
+        assert(conveyors[uiIndex - 1].IsValid());
+    }
+
+    for (size_t uiIndex = 0; uiIndex < uiLength; ++uiIndex)
+    {
+        auto& conveyor = ecs.GetComponent<ConveyorComponent>(conveyors[uiIndex]);
+        for (int iChannel = 0; iChannel < components::c_conveyorChannels; ++iChannel)
+        {
+            const SequenceComponent::RealizedState& state = sequence.m_RealizedStates[iChannel];
+            for (int iSlot = 0; iSlot < components::c_conveyorChannelSlots; ++iSlot)
+            {
+                const uint64_t uiLaneBit = getLaneBit(uiLength, uiIndex, iSlot);
+                ConveyorComponent::PlacedItem& placed = conveyor.m_Channels[iChannel].m_pSlots[iSlot].m_Item;
+                placed = {};
+                if ((state.m_Lanes & uiLaneBit) != 0)
+                {
+                    placed.m_Item = state.m_Items.Peek(std::popcount(state.m_Lanes & (uiLaneBit - 1))).m_Item;
+                }
+            }
+        }
+
+        conveyor.m_CurrentTick = sequence.m_CurrentTick;
+        conveyor.m_Sequence = EntityId::Invalid();
+        conveyor.m_SequenceIndex = 0;
+        if (!ecs.DoesEntityHaveComponent<IndividuallyProcessableConveyorComponent>(conveyors[uiIndex]))
+        {
+            ecs.AddComponent<IndividuallyProcessableConveyorComponent>(conveyors[uiIndex]);
         }
-        while (std::distance(chunk_begin, end) > 0);
     }
+
+    ecs.RemoveEntity(sequenceId);
 }
 
 void cpp_conv::SequenceFormationSystem::Update(atlas::scene::EcsManager&)
@@ -1,4 +1,7 @@
 #pragma once
+#include <span>
+#include <vector>
+
 #include "EntityLookupGrid.h"
 #include "AtlasScene/ECS/Components/EcsManager.h"
 #include "AtlasScene/ECS/Systems/SystemBase.h"
@@ -8,13 +11,35 @@ namespace cpp_conv
     class SequenceFormationSystem final : public atlas::scene::SystemBase
     {
     public:
-        explicit SequenceFormationSystem(EntityLookupGrid& lookupGrid);
+        // bStateIsPrepared skips Initialise, for scenes whose state was already run through this system while loading.
+        explicit SequenceFormationSystem(EntityLookupGrid& lookupGrid, bool bStateIsPrepared = false);
         void Initialise(atlas::scene::EcsManager& ecs) override;
         void Update(atlas::scene::EcsManager&) override;
 
-    private:
         inline static constexpr int c_MaxSequenceLength = 31;
 
+        // Creates an empty sequence over the given conveyors, ordered tail to head, and links them to it.
+        static atlas::scene::EntityId CreateSequence(
+            atlas::scene::EcsManager& ecs,
+            std::span<const atlas::scene::EntityId> conveyors);
+
+        // Forms sequences over the given conveyors and the unsequenced straight conveyors chained to them, moving the
+        // items on their slots onto the new sequences. Conveyors which are already sequenced, or corners, are skipped.
+        static void FormSequences(
+            atlas::scene::EcsManager& ecs,
+            const EntityLookupGrid& grid,
+            std::span<const atlas::scene::EntityId> conveyors);
+
+        // Moves a sequence's items back onto its conveyors' slots and removes it, leaving the conveyors to be processed
+        // individually. The former conveyors are appended to vOutConveyors, tail to head. Only valid between ticks.
+        static void DissolveSequence(
+            atlas::scene::EcsManager& ecs,
+            const EntityLookupGrid& grid,
+            atlas::scene::EntityId sequence,
+            std::vector<atlas::scene::EntityId>& vOutConveyors);
+
+    private:
         EntityLookupGrid& m_LookupGrid;
+        bool m_bStateIsPrepared;
     };
 }
@@ -0,0 +1,14 @@
+#include "StorageSystem.h"
+
+#include "ItemInputStaging.h"
+#include "StorageComponent.h"
+#include "AtlasScene/ECS/Components/EcsManager.h"
+
+void cpp_conv::StorageSystem::Update(atlas::scene::EcsManager& ecs)
+{
+    for (const auto entity : ecs.GetEntitiesWithComponents<components::StorageComponent, components::ItemInputStaging>())
+    {
+        auto [storage, staging] = ecs.GetComponents<components::StorageComponent, components::ItemInputStaging>(entity);
+        staging.Drain(storage.m_ItemContainer);
+    }
+}
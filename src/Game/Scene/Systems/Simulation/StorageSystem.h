@@ -0,0 +1,11 @@
+#pragma once
+#include "AtlasScene/ECS/Systems/SystemBase.h"
+
+namespace cpp_conv
+{
+    class StorageSystem final : public atlas::scene::SystemBase
+    {
+    public:
+        void Update(atlas::scene::EcsManager&) override;
+    };
+}
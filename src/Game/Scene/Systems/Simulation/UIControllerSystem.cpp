@@ -1,6 +1,7 @@
 #include "UIControllerSystem.h"
 
 #include <cstdint>
+#include <initializer_list>
 #include <RmlUi/Core.h>
 #include <SDL_timer.h>
 
@@ -529,6 +530,31 @@ atlas::resource::AssetPtr<atlas::resource::ResourceAsset> rawRmlDataLoader(atlas
     return std::make_shared<RmlRawDataAsset>(data.m_FilePath, std::move(data.m_pData), data.m_Size);
 }
 
+void cpp_conv::registerUiTypeHandlers()
+{
+    atlas::resource::ResourceLoader::RegisterTypeHandler<RmlRawDataAsset>(rawRmlDataLoader);
+
+    atlas::resource::ResourceLoader::RegisterTypeHandler<RmlUIPage>(rmlUiPageLoader);
+    atlas::resource::ResourceLoader::RegisterTypeHandler<RmlUICss>(rmlUiCssLoader);
+    atlas::resource::ResourceLoader::RegisterTypeHandler<RmlUIFont>(rmlUiFontLoader);
+}
+
+std::vector<atlas::resource::AssetPtr<atlas::resource::ResourceAsset>> cpp_conv::loadUiFonts()
+{
+    std::vector<atlas::resource::AssetPtr<atlas::resource::ResourceAsset>> vFonts;
+    for (const atlas::resource::RegistryId font : {
+             resources::registry::core_bundle::ui::fonts::c_LatoLatin_Regular,
+             resources::registry::core_bundle::ui::fonts::c_NotoEmoji_Regular})
+    {
+        if (auto pFont = atlas::resource::ResourceLoader::LoadAsset<resources::registry::CoreBundle, RmlUIFont>(font))
+        {
+            vFonts.push_back(std::move(pFont));
+        }
+    }
+
+    return vFonts;
+}
+
 cpp_conv::UIControllerSystem::UIControllerSystem()
 {
 }
@@ -539,12 +565,6 @@ cpp_conv::UIControllerSystem::~UIControllerSystem()
 
 void cpp_conv::UIControllerSystem::Initialise(atlas::scene::EcsManager& ecsManager)
 {
-    atlas::resource::ResourceLoader::RegisterTypeHandler<RmlRawDataAsset>(rawRmlDataLoader);
-
-    atlas::resource::ResourceLoader::RegisterTypeHandler<RmlUIPage>(rmlUiPageLoader);
-    atlas::resource::ResourceLoader::RegisterTypeHandler<RmlUICss>(rmlUiCssLoader);
-    atlas::resource::ResourceLoader::RegisterTypeHandler<RmlUIFont>(rmlUiFontLoader);
-
     m_FileInterface = std::make_unique<RmlFileInterface>();
     m_SystemInterface = std::make_unique<RmlSystemInterface>();
     m_RenderInterface = std::make_unique<RmlRenderInterface>();
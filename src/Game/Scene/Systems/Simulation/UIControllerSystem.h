@@ -1,8 +1,10 @@
 #pragma once
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "AtlasResource/AssetPtr.h"
+#include "AtlasResource/ResourceAsset.h"
 #include "AtlasScene/ECS/Systems/SystemBase.h"
 
 class RmlUIPage;
@@ -17,6 +19,13 @@ namespace Rml
 
 namespace cpp_conv
 {
+    // Registers the handlers for the UI's pages, stylesheets and fonts.
+    void registerUiTypeHandlers();
+
+    // Loads the fonts that the UI uses, so that they are not read when it is first shown. They are returned to keep
+    // them alive.
+    std::vector<atlas::resource::AssetPtr<atlas::resource::ResourceAsset>> loadUiFonts();
+
     class UIControllerSystem final : public atlas::scene::SystemBase
     {
     public:
@@ -0,0 +1,518 @@
+#include "Autosaver.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <string_view>
+#include <system_error>
+
+#if _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "BinaryMap.h"
+#include "ChunkStreamer.h"
+#include "Hashing.h"
+#include "SaveGameFormat.h"
+#include "Topology.h"
+
+namespace
+{
+    using namespace cpp_conv::save_game;
+
+    template <typename TValue>
+    std::span<const uint8_t> asBytes(const TValue& value)
+    {
+        return {reinterpret_cast<const uint8_t*>(&value), sizeof(TValue)};
+    }
+
+    uint64_t getBlockEntrySize(const RecordBlock& block)
+    {
+        return sizeof(JournalEntryHeader) + sizeof(BlockHeader) + block.m_vRecords.size();
+    }
+
+    // Appends entries to a journal and keeps track of where each one starts. Writes after the first failure are
+    // skipped, so callers check once at the end.
+    class JournalFile
+    {
+    public:
+        JournalFile(const std::filesystem::path& path, const char* szMode, const uint64_t uiOffset)
+            : m_pFile{std::fopen(path.string().c_str(), szMode)}
+            , m_uiOffset{uiOffset}
+        {
+        }
+
+        ~JournalFile()
+        {
+            if (m_pFile)
+            {
+                std::fclose(m_pFile);
+            }
+        }
+
+        JournalFile(const JournalFile&) = delete;
+        JournalFile& operator=(const JournalFile&) = delete;
+
+        void Write(const std::span<const uint8_t> data)
+        {
+            if (HasFailed())
+            {
+                return;
+            }
+
+            m_bFailed = std::fwrite(data.data(), 1, data.size(), m_pFile) != data.size();
+            m_uiOffset += data.size();
+        }
+
+        // Returns the entry's offset, by which commits refer to it.
+        uint64_t BeginEntry(const JournalEntryType type, const uint64_t uiSize)
+        {
+            const uint64_t uiEntryOffset = m_uiOffset;
+            JournalEntryHeader header{};
+            header.m_Type = type;
+            header.m_uiSize = uiSize;
+            Write(asBytes(header));
+            return uiEntryOffset;
+        }
+
+        // Makes everything written so far durable.
+        void Sync()
+        {
+            if (HasFailed())
+            {
+                return;
+            }
+
+#if _WIN32
+            m_bFailed = std::fflush(m_pFile) != 0 || _commit(_fileno(m_pFile)) != 0;
+#else
+            m_bFailed = std::fflush(m_pFile) != 0 || fsync(fileno(m_pFile)) != 0;
+#endif
+        }
+
+        bool Close()
+        {
+            bool bSucceeded = !HasFailed();
+            if (m_pFile && std::fclose(m_pFile) != 0)
+            {
+                bSucceeded = false;
+            }
+
+            m_pFile = nullptr;
+            m_bFailed = !bSucceeded;
+            return bSucceeded;
+        }
+
+        [[nodiscard]] bool HasFailed() const { return m_bFailed || !m_pFile; }
+        [[nodiscard]] uint64_t GetOffset() const { return m_uiOffset; }
+
+    private:
+        std::FILE* m_pFile;
+        uint64_t m_uiOffset;
+        bool m_bFailed = false;
+    };
+
+    uint64_t writeBlockEntry(JournalFile& file, const BlockKey& key, const RecordBlock& block)
+    {
+        const uint64_t uiOffset = file.BeginEntry(JournalEntryType::Block, sizeof(BlockHeader) + block.m_vRecords.size());
+        file.Write(asBytes(makeBlockHeader(key, block)));
+        file.Write(block.m_vRecords);
+        return uiOffset;
+    }
+
+    // Syncs the entries ahead of the commit, so that the commit can never reach the disk before what it refers to.
+    void writeCommit(
+        JournalFile& file,
+        const uint64_t uiTick,
+        const uint64_t uiLayoutOffset,
+        const uint64_t uiTopologyOffset,
+        const std::vector<uint64_t>& vItemIds,
+        const std::vector<uint64_t>& vBlockOffsets)
+    {
+        file.Sync();
+
+        CommitHeader header{};
+        header.m_uiTick = uiTick;
+        header.m_uiLayoutOffset = uiLayoutOffset;
+        header.m_uiTopologyOffset = uiTopologyOffset;
+        header.m_uiItemCount = static_cast<uint32_t>(vItemIds.size());
+        header.m_uiBlockCount = static_cast<uint32_t>(vBlockOffsets.size());
+
+        file.BeginEntry(
+            JournalEntryType::Commit,
+            sizeof(CommitHeader) + (vItemIds.size() + vBlockOffsets.size()) * sizeof(uint64_t));
+        file.Write(asBytes(header));
+        file.Write({reinterpret_cast<const uint8_t*>(vItemIds.data()), vItemIds.size() * sizeof(uint64_t)});
+        file.Write({reinterpret_cast<const uint8_t*>(vBlockOffsets.data()), vBlockOffsets.size() * sizeof(uint64_t)});
+        file.Sync();
+    }
+
+    // The payload of the entry at uiOffset, provided that it is complete and of the given type.
+    std::optional<std::span<const uint8_t>> getEntry(
+        const std::span<const uint8_t> data,
+        const uint64_t uiOffset,
+        const JournalEntryType type)
+    {
+        if (uiOffset < sizeof(JournalHeader) || uiOffset > data.size() || data.size() - uiOffset < sizeof(JournalEntryHeader))
+        {
+            return {};
+        }
+
+        JournalEntryHeader header;
+        std::memcpy(&header, data.data() + uiOffset, sizeof(JournalEntryHeader));
+        const uint64_t uiPayloadOffset = uiOffset + sizeof(JournalEntryHeader);
+        if (header.m_Type != type || header.m_uiSize > data.size() - uiPayloadOffset)
+        {
+            return {};
+        }
+
+        return data.subspan(uiPayloadOffset, header.m_uiSize);
+    }
+}
+
+cpp_conv::Autosaver::Autosaver(std::filesystem::path path, const uint64_t uiIntervalTicks)
+    : m_Path{std::move(path)}
+    , m_uiIntervalTicks{uiIntervalTicks}
+    , m_Worker{[this](const std::stop_token& stopToken) { Run(stopToken); }}
+{
+}
+
+void cpp_conv::Autosaver::Update(
+    atlas::scene::EcsManager& ecs,
+    const uint64_t uiTick,
+    const ChunkStreamer& streamer)
+{
+    if (!m_uiNextSaveTick)
+    {
+        m_uiNextSaveTick = uiTick + m_uiIntervalTicks;
+        return;
+    }
+
+    // A save that is still being written delays the next one rather than the simulation.
+    if (uiTick < *m_uiNextSaveTick || m_bWriting.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    // Everything is copied on the one tick, so an item moving between chunks is saved exactly once. The layout is
+    // captured every time, and only written out again by the worker if it has changed.
+    save_game::captureSimulation(ecs, uiTick, true, m_Snapshot);
+    m_pFrozenPages = streamer.GetFrozenChunks(m_vFrozenChunks);
+    m_uiNextSaveTick = uiTick + m_uiIntervalTicks;
+    m_bWriting.store(true, std::memory_order_relaxed);
+
+    {
+        std::scoped_lock lock{m_Mutex};
+        m_bHasSnapshot = true;
+    }
+
+    m_SnapshotReady.notify_one();
+}
+
+void cpp_conv::Autosaver::Run(const std::stop_token& stopToken)
+{
+    while (true)
+    {
+        {
+            std::unique_lock lock{m_Mutex};
+            if (!m_SnapshotReady.wait(lock, stopToken, [this] { return m_bHasSnapshot; }))
+            {
+                return;
+            }
+
+            m_bHasSnapshot = false;
+        }
+
+        if (!Write())
+        {
+            std::cerr << std::format("Failed to write autosave {}\n", m_Path.string());
+        }
+
+        m_bWriting.store(false, std::memory_order_release);
+    }
+}
+
+bool cpp_conv::Autosaver::Write()
+{
+    std::string errors;
+    bool bReadFrozenChunks = true;
+    for (const ChunkStreamer::FrozenChunk& chunk : m_vFrozenChunks)
+    {
+        if (!ChunkStreamer::ReadFrozenChunk(*m_pFrozenPages, chunk, m_Snapshot.m_uiTick, m_Snapshot, &errors))
+        {
+            bReadFrozenChunks = false;
+            break;
+        }
+    }
+
+    // Lets the page file go, so that it can be deleted once the streamer has moved on from it.
+    m_pFrozenPages.reset();
+    if (!bReadFrozenChunks)
+    {
+        std::cerr << errors;
+        return false;
+    }
+
+    const std::map<save_game::BlockKey, save_game::RecordBlock> blocks = save_game::encodeRecordBlocks(
+        m_Snapshot,
+        m_Palette);
+
+    m_vLayoutData = resources::writeBinaryMap(m_Snapshot.m_vLayout);
+    const uint64_t uiLayoutHash = hashing::fnv1a(m_vLayoutData);
+    const bool bLayoutChanged = uiLayoutHash != m_uiLayoutHash;
+    m_uiLayoutHash = uiLayoutHash;
+    m_vTopologyData = topology::encodeTopology(m_Snapshot.m_Topology, topology::hashLayout(m_vLayoutData));
+
+    // Entries that no commit refers to any more are only dropped when the journal is written afresh, once they
+    // outweigh the live ones.
+    uint64_t uiLiveSize =
+        sizeof(JournalHeader) +
+        sizeof(JournalEntryHeader) + m_vLayoutData.size() +
+        sizeof(JournalEntryHeader) + m_vTopologyData.size();
+    for (const auto& [key, location] : m_BlockIndex)
+    {
+        uiLiveSize += location.m_uiSize;
+    }
+
+    if (!m_bHasJournal || m_uiFileSize - std::min(m_uiFileSize, uiLiveSize) > uiLiveSize)
+    {
+        return WriteFreshJournal(blocks);
+    }
+
+    JournalFile file{m_Path, "ab", m_uiFileSize};
+    if (bLayoutChanged)
+    {
+        m_uiLayoutOffset = file.BeginEntry(JournalEntryType::Layout, m_vLayoutData.size());
+        file.Write(m_vLayoutData);
+        m_uiTopologyOffset = file.BeginEntry(JournalEntryType::Topology, m_vTopologyData.size());
+        file.Write(m_vTopologyData);
+    }
+
+    std::map<save_game::BlockKey, BlockLocation> blockIndex;
+    std::vector<uint64_t> vBlockOffsets;
+    vBlockOffsets.reserve(blocks.size());
+    for (const auto& [key, block] : blocks)
+    {
+        const uint64_t uiHash = hashing::fnv1a(block.m_vRecords, hashing::fnv1aValue(makeBlockHeader(key, block)));
+        const auto it = m_BlockIndex.find(key);
+        BlockLocation location = it != m_BlockIndex.end() ? it->second : BlockLocation{};
+        if (it == m_BlockIndex.end() || location.m_uiHash != uiHash)
+        {
+            location = {writeBlockEntry(file, key, block), getBlockEntrySize(block), uiHash};
+        }
+
+        blockIndex.emplace(key, location);
+        vBlockOffsets.push_back(location.m_uiOffset);
+    }
+
+    writeCommit(
+        file,
+        m_Snapshot.m_uiTick,
+        m_uiLayoutOffset,
+        m_uiTopologyOffset,
+        m_Palette.GetItemIds(),
+        vBlockOffsets);
+    const uint64_t uiFileSize = file.GetOffset();
+    if (!file.Close())
+    {
+        // The journal's tail is now unknown, so the next autosave starts over.
+        m_bHasJournal = false;
+        return false;
+    }
+
+    m_BlockIndex = std::move(blockIndex);
+    m_uiFileSize = uiFileSize;
+    return true;
+}
+
+bool cpp_conv::Autosaver::WriteFreshJournal(const std::map<save_game::BlockKey, save_game::RecordBlock>& blocks)
+{
+    m_bHasJournal = false;
+
+    // Written beside the journal and moved over it, so that the previous autosave survives until this one is complete.
+    std::filesystem::path temporaryPath = m_Path;
+    temporaryPath += ".tmp";
+
+    JournalFile file{temporaryPath, "wb", 0};
+    save_game::JournalHeader header{};
+    header.m_Magic = save_game::c_JournalMagic;
+    header.m_uiVersion = save_game::c_uiJournalVersion;
+    file.Write(asBytes(header));
+
+    const uint64_t uiLayoutOffset = file.BeginEntry(save_game::JournalEntryType::Layout, m_vLayoutData.size());
+    file.Write(m_vLayoutData);
+    const uint64_t uiTopologyOffset = file.BeginEntry(save_game::JournalEntryType::Topology, m_vTopologyData.size());
+    file.Write(m_vTopologyData);
+
+    std::map<save_game::BlockKey, BlockLocation> blockIndex;
+    std::vector<uint64_t> vBlockOffsets;
+    vBlockOffsets.reserve(blocks.size());
+    for (const auto& [key, block] : blocks)
+    {
+        const uint64_t uiHash = hashing::fnv1a(block.m_vRecords, hashing::fnv1aValue(makeBlockHeader(key, block)));
+        const BlockLocation location{writeBlockEntry(file, key, block), getBlockEntrySize(block), uiHash};
+        blockIndex.emplace(key, location);
+        vBlockOffsets.push_back(location.m_uiOffset);
+    }
+
+    writeCommit(file, m_Snapshot.m_uiTick, uiLayoutOffset, uiTopologyOffset, m_Palette.GetItemIds(), vBlockOffsets);
+    const uint64_t uiFileSize = file.GetOffset();
+    if (!file.Close())
+    {
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, m_Path, error);
+    if (error)
+    {
+        return false;
+    }
+
+    m_uiLayoutOffset = uiLayoutOffset;
+    m_uiTopologyOffset = uiTopologyOffset;
+    m_BlockIndex = std::move(blockIndex);
+    m_uiFileSize = uiFileSize;
+    m_bHasJournal = true;
+    return true;
+}
+
+bool cpp_conv::save_game::isAutosave(const std::span<const uint8_t> data)
+{
+    return data.size() >= c_JournalMagic.size() &&
+        std::memcmp(data.data(), c_JournalMagic.data(), c_JournalMagic.size()) == 0;
+}
+
+std::optional<cpp_conv::save_game::SaveGame> cpp_conv::save_game::readAutosave(
+    const std::span<const uint8_t> data,
+    std::string* pErrors)
+{
+    const auto fail = [pErrors](const std::string_view reason) -> std::optional<SaveGame>
+    {
+        if (pErrors)
+        {
+            *pErrors += std::format("Invalid autosave: {}\n", reason);
+        }
+
+        return {};
+    };
+
+    if (!isAutosave(data) || data.size() < sizeof(JournalHeader))
+    {
+        return fail("bad header");
+    }
+
+    JournalHeader header;
+    std::memcpy(&header, data.data(), sizeof(JournalHeader));
+    if (header.m_uiVersion != c_uiJournalVersion)
+    {
+        return fail(std::format("unsupported version {}", header.m_uiVersion));
+    }
+
+    // Scans up to the first incomplete entry, which is where a torn write would have left off.
+    std::optional<std::span<const uint8_t>> commit;
+    uint64_t uiOffset = sizeof(JournalHeader);
+    while (data.size() - uiOffset >= sizeof(JournalEntryHeader))
+    {
+        JournalEntryHeader entry;
+        std::memcpy(&entry, data.data() + uiOffset, sizeof(JournalEntryHeader));
+        const uint64_t uiPayloadOffset = uiOffset + sizeof(JournalEntryHeader);
+        if (entry.m_uiSize > data.size() - uiPayloadOffset)
+        {
+            break;
+        }
+
+        if (entry.m_Type == JournalEntryType::Commit)
+        {
+            commit = data.subspan(uiPayloadOffset, entry.m_uiSize);
+        }
+
+        uiOffset = uiPayloadOffset + entry.m_uiSize;
+    }
+
+    if (!commit || commit->size() < sizeof(CommitHeader))
+    {
+        return fail("no complete commit");
+    }
+
+    CommitHeader commitHeader;
+    std::memcpy(&commitHeader, commit->data(), sizeof(CommitHeader));
+    const std::span<const uint8_t> offsets = commit->subspan(sizeof(CommitHeader));
+    const uint64_t uiPaletteSize = uint64_t{commitHeader.m_uiItemCount} * sizeof(uint64_t);
+    if (offsets.size() != uiPaletteSize + uint64_t{commitHeader.m_uiBlockCount} * sizeof(uint64_t))
+    {
+        return fail("bad commit");
+    }
+
+    const std::optional<std::span<const uint8_t>> layout = getEntry(
+        data,
+        commitHeader.m_uiLayoutOffset,
+        JournalEntryType::Layout);
+    const std::optional<std::span<const uint8_t>> topology = getEntry(
+        data,
+        commitHeader.m_uiTopologyOffset,
+        JournalEntryType::Topology);
+    if (!layout || !topology)
+    {
+        return fail("missing layout");
+    }
+
+    SaveGame save;
+    save.m_uiTick = commitHeader.m_uiTick;
+    save.m_vItemPalette = readItemPalette(offsets.first(uiPaletteSize));
+    save.m_vMapData.assign(layout->begin(), layout->end());
+    save.m_vTopologyData.assign(topology->begin(), topology->end());
+    save.m_vBlocks.reserve(commitHeader.m_uiBlockCount);
+    for (uint32_t i = 0; i < commitHeader.m_uiBlockCount; ++i)
+    {
+        uint64_t uiBlockOffset;
+        std::memcpy(&uiBlockOffset, offsets.data() + uiPaletteSize + i * sizeof(uint64_t), sizeof(uint64_t));
+        const std::optional<std::span<const uint8_t>> entry = getEntry(data, uiBlockOffset, JournalEntryType::Block);
+        std::optional<RecordBlock> block = entry ? readBlockEntry(*entry) : std::nullopt;
+        if (!block)
+        {
+            return fail("missing block");
+        }
+
+        save.m_vBlocks.push_back(std::move(*block));
+    }
+
+    return save;
+}
+
+cpp_conv::save_game::BlockHeader cpp_conv::save_game::makeBlockHeader(const BlockKey& key, const RecordBlock& block)
+{
+    BlockHeader header{};
+    header.m_iChunkX = key.m_iChunkX;
+    header.m_iChunkZ = key.m_iChunkZ;
+    header.m_iFloor = key.m_iFloor;
+    header.m_uiSequenceCount = block.m_uiSequenceCount;
+    header.m_uiConveyorCount = block.m_uiConveyorCount;
+    header.m_uiFactoryCount = block.m_uiFactoryCount;
+    header.m_uiStorageCount = block.m_uiStorageCount;
+    return header;
+}
+
+std::optional<cpp_conv::save_game::RecordBlock> cpp_conv::save_game::readBlockEntry(const std::span<const uint8_t> payload)
+{
+    if (payload.size() < sizeof(BlockHeader))
+    {
+        return {};
+    }
+
+    BlockHeader header;
+    std::memcpy(&header, payload.data(), sizeof(BlockHeader));
+    const std::span<const uint8_t> records = payload.subspan(sizeof(BlockHeader));
+
+    RecordBlock block;
+    block.m_uiSequenceCount = header.m_uiSequenceCount;
+    block.m_uiConveyorCount = header.m_uiConveyorCount;
+    block.m_uiFactoryCount = header.m_uiFactoryCount;
+    block.m_uiStorageCount = header.m_uiStorageCount;
+    block.m_vRecords.assign(records.begin(), records.end());
+    return block;
+}
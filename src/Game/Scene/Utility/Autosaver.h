@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ChunkStreamer.h"
+#include "SaveGame.h"
+
+namespace atlas::scene
+{
+    class EcsManager;
+}
+
+namespace cpp_conv
+{
+    // Periodically saves the simulation to a journal without holding up the simulation. The resident world is copied
+    // into a snapshot's flat buffers on a single tick, and a worker thread then reads the frozen chunks back from their
+    // pages, encodes everything and appends the grid chunks that changed since the previous autosave, followed by a
+    // commit. The file is synced before and after the commit, so a crash at any point leaves the last complete
+    // autosave loadable.
+    class Autosaver
+    {
+    public:
+        Autosaver(std::filesystem::path path, uint64_t uiIntervalTicks);
+        Autosaver(const Autosaver&) = delete;
+        Autosaver& operator=(const Autosaver&) = delete;
+
+        // Call between ticks, while nothing else touches the ECS. Captures the simulation once the interval has passed,
+        // or on a later tick if the previous autosave is still being written. Frozen chunks are saved along with the
+        // rest.
+        void Update(atlas::scene::EcsManager& ecs, uint64_t uiTick, const ChunkStreamer& streamer);
+
+    private:
+        struct BlockLocation
+        {
+            uint64_t m_uiOffset;
+            uint64_t m_uiSize;
+            uint64_t m_uiHash;
+        };
+
+        void Run(const std::stop_token& stopToken);
+        bool Write();
+        bool WriteFreshJournal(const std::map<save_game::BlockKey, save_game::RecordBlock>& blocks);
+
+        std::filesystem::path m_Path;
+        uint64_t m_uiIntervalTicks;
+        std::optional<uint64_t> m_uiNextSaveTick;
+
+        // Filled by Update and read by the worker. Update only touches them while m_bWriting is clear. Frozen chunks do
+        // not change, so their pages still hold them as of the snapshot's tick when the worker gets to them.
+        save_game::SimulationSnapshot m_Snapshot;
+        std::shared_ptr<const ChunkPageFile> m_pFrozenPages;
+        std::vector<ChunkStreamer::FrozenChunk> m_vFrozenChunks;
+        std::atomic<bool> m_bWriting{false};
+
+        std::mutex m_Mutex;
+        std::condition_variable_any m_SnapshotReady;
+        bool m_bHasSnapshot = false;
+
+        // Worker only. Describes the journal on disk as of its last commit.
+        save_game::ItemPalette m_Palette;
+        std::vector<uint8_t> m_vLayoutData;
+        std::vector<uint8_t> m_vTopologyData;
+        uint64_t m_uiLayoutHash = 0;
+        uint64_t m_uiLayoutOffset = 0;
+        uint64_t m_uiTopologyOffset = 0;
+        std::map<save_game::BlockKey, BlockLocation> m_BlockIndex;
+        uint64_t m_uiFileSize = 0;
+        bool m_bHasJournal = false;
+
+        // Declared last so that it is stopped and joined before anything the worker uses is destroyed.
+        std::jthread m_Worker;
+    };
+
+    namespace save_game
+    {
+        [[nodiscard]] bool isAutosave(std::span<const uint8_t> data);
+        // Reads the journal's last complete commit as a save game.
+        std::optional<SaveGame> readAutosave(std::span<const uint8_t> data, std::string* pErrors);
+
+        // Block entries, which frozen chunk pages are written in as well.
+        [[nodiscard]] BlockHeader makeBlockHeader(const BlockKey& key, const RecordBlock& block);
+        std::optional<RecordBlock> readBlockEntry(std::span<const uint8_t> payload);
+    }
+}
@@ -0,0 +1,226 @@
+#include "ChunkPageFile.h"
+
+#include <cstring>
+#include <format>
+#include <initializer_list>
+#include <string_view>
+#include <system_error>
+
+#include "Autosaver.h"
+#include "BinaryMap.h"
+#include "SaveGameFormat.h"
+#include "Topology.h"
+
+namespace
+{
+    using namespace cpp_conv::save_game;
+
+    template <typename TValue>
+    std::span<const uint8_t> asBytes(const TValue& value)
+    {
+        return {reinterpret_cast<const uint8_t*>(&value), sizeof(TValue)};
+    }
+
+    void appendEntry(
+        std::vector<uint8_t>& vData,
+        const JournalEntryType type,
+        const std::initializer_list<std::span<const uint8_t>> parts)
+    {
+        JournalEntryHeader header{};
+        header.m_Type = type;
+        for (const std::span<const uint8_t> part : parts)
+        {
+            header.m_uiSize += part.size();
+        }
+
+        const std::span<const uint8_t> headerData = asBytes(header);
+        vData.insert(vData.end(), headerData.begin(), headerData.end());
+        for (const std::span<const uint8_t> part : parts)
+        {
+            vData.insert(vData.end(), part.begin(), part.end());
+        }
+    }
+
+    // Takes the entry at the front of the data, provided that it is complete and of the given type.
+    std::optional<std::span<const uint8_t>> takeEntry(std::span<const uint8_t>& rData, const JournalEntryType type)
+    {
+        if (rData.size() < sizeof(JournalEntryHeader))
+        {
+            return {};
+        }
+
+        JournalEntryHeader header;
+        std::memcpy(&header, rData.data(), sizeof(JournalEntryHeader));
+        rData = rData.subspan(sizeof(JournalEntryHeader));
+        if (header.m_Type != type || header.m_uiSize > rData.size())
+        {
+            return {};
+        }
+
+        const std::span<const uint8_t> payload = rData.first(header.m_uiSize);
+        rData = rData.subspan(header.m_uiSize);
+        return payload;
+    }
+
+    bool seekTo(std::FILE* pFile, const uint64_t uiOffset)
+    {
+#if _WIN32
+        return _fseeki64(pFile, static_cast<int64_t>(uiOffset), SEEK_SET) == 0;
+#else
+        return fseeko(pFile, static_cast<off_t>(uiOffset), SEEK_SET) == 0;
+#endif
+    }
+}
+
+cpp_conv::ChunkPageFile::ChunkPageFile(std::filesystem::path path, save_game::ItemPalette palette)
+    : m_Path{std::move(path)}
+    , m_pFile{nullptr}
+    , m_Palette{std::move(palette)}
+{
+    std::error_code error;
+    std::filesystem::create_directories(m_Path.parent_path(), error);
+    m_pFile = std::fopen(m_Path.string().c_str(), "w+b");
+}
+
+cpp_conv::ChunkPageFile::~ChunkPageFile()
+{
+    if (m_pFile)
+    {
+        std::fclose(m_pFile);
+        std::error_code error;
+        std::filesystem::remove(m_Path, error);
+    }
+}
+
+std::optional<cpp_conv::ChunkPageFile::Page> cpp_conv::ChunkPageFile::Write(
+    const save_game::BlockKey& key,
+    const save_game::SimulationSnapshot& snapshot)
+{
+    const std::vector<uint8_t> vLayoutData = resources::writeBinaryMap(snapshot.m_vLayout);
+    const std::vector<uint8_t> vTopologyData = topology::encodeTopology(
+        snapshot.m_Topology,
+        topology::hashLayout(vLayoutData));
+
+    std::scoped_lock lock{m_Mutex};
+
+    // Every record is in the chunk, so they all end up in its block.
+    std::map<BlockKey, RecordBlock> blocks = encodeRecordBlocks(snapshot, m_Palette);
+    const RecordBlock records = blocks.empty() ? RecordBlock{} : std::move(blocks.begin()->second);
+
+    std::vector<uint8_t> vData;
+    appendEntry(vData, JournalEntryType::Layout, {vLayoutData});
+    appendEntry(vData, JournalEntryType::Topology, {vTopologyData});
+    appendEntry(vData, JournalEntryType::Block, {asBytes(makeBlockHeader(key, records)), records.m_vRecords});
+    return Append(vData);
+}
+
+std::optional<cpp_conv::ChunkPageFile::Page> cpp_conv::ChunkPageFile::CopyPage(
+    const ChunkPageFile& source,
+    const Page& page)
+{
+    std::scoped_lock lock{m_Mutex, source.m_Mutex};
+    std::vector<uint8_t> vData;
+    if (!source.ReadAt(page, vData))
+    {
+        return {};
+    }
+
+    return Append(vData);
+}
+
+bool cpp_conv::ChunkPageFile::Read(
+    const Page& page,
+    save_game::SimulationSnapshot& outSnapshot,
+    std::string* pErrors) const
+{
+    const auto fail = [pErrors](const std::string_view reason)
+    {
+        if (pErrors)
+        {
+            *pErrors += std::format("Invalid chunk page: {}\n", reason);
+        }
+
+        return false;
+    };
+
+    // Decoded outside the lock, with the palette as it was. Indices never change, so it covers the page.
+    std::vector<uint8_t> vData;
+    std::vector<ItemIndex> vPalette;
+    {
+        std::scoped_lock lock{m_Mutex};
+        if (!ReadAt(page, vData))
+        {
+            return fail("unreadable");
+        }
+
+        vPalette = m_Palette.GetItems();
+    }
+
+    std::span<const uint8_t> remaining = vData;
+    const std::optional<std::span<const uint8_t>> layout = takeEntry(remaining, JournalEntryType::Layout);
+    const std::optional<std::span<const uint8_t>> topology = takeEntry(remaining, JournalEntryType::Topology);
+    const std::optional<std::span<const uint8_t>> block = takeEntry(remaining, JournalEntryType::Block);
+    const std::optional<RecordBlock> records = block ? readBlockEntry(*block) : std::nullopt;
+    if (!layout || !topology || !records)
+    {
+        return fail("missing entries");
+    }
+
+    const std::optional<resources::BinaryMapView> view = resources::BinaryMapView::Create(*layout, pErrors);
+    if (!view)
+    {
+        return false;
+    }
+
+    const std::optional<topology::Topology> conveyors = topology::decodeTopology(
+        *topology,
+        topology::hashLayout(*layout),
+        pErrors);
+    if (!conveyors || !decodeRecordBlocks({&*records, 1}, vPalette, outSnapshot, pErrors))
+    {
+        return false;
+    }
+
+    resources::readBinaryMap(*view, outSnapshot.m_vLayout);
+    outSnapshot.m_Topology.m_vConveyors.insert(
+        outSnapshot.m_Topology.m_vConveyors.end(),
+        conveyors->m_vConveyors.begin(),
+        conveyors->m_vConveyors.end());
+    return true;
+}
+
+cpp_conv::save_game::ItemPalette cpp_conv::ChunkPageFile::GetPalette() const
+{
+    std::scoped_lock lock{m_Mutex};
+    return m_Palette;
+}
+
+uint64_t cpp_conv::ChunkPageFile::GetSize() const
+{
+    std::scoped_lock lock{m_Mutex};
+    return m_uiSize;
+}
+
+std::optional<cpp_conv::ChunkPageFile::Page> cpp_conv::ChunkPageFile::Append(const std::span<const uint8_t> data)
+{
+    // A failed write is left to be overwritten by the next one.
+    if (!m_pFile ||
+        !seekTo(m_pFile, m_uiSize) ||
+        std::fwrite(data.data(), 1, data.size(), m_pFile) != data.size())
+    {
+        return {};
+    }
+
+    const Page page{m_uiSize, data.size()};
+    m_uiSize += data.size();
+    return page;
+}
+
+bool cpp_conv::ChunkPageFile::ReadAt(const Page& page, std::vector<uint8_t>& vOutData) const
+{
+    vOutData.resize(page.m_uiSize);
+    return m_pFile &&
+        page.m_uiOffset + page.m_uiSize <= m_uiSize &&
+        seekTo(m_pFile, page.m_uiOffset) &&
+        std::fread(vOutData.data(), 1, vOutData.size(), m_pFile) == vOutData.size();
+}
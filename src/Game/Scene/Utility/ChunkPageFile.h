@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "SaveGame.h"
+
+namespace cpp_conv
+{
+    // Frozen chunks paged out to disk. Each page is a chunk's layout, topology and records, written as the autosave
+    // journal's layout, topology and block entries (see SaveGameFormat.h), and the records of every page are encoded
+    // with the file's one palette. Pages are only ever appended, and the file is deleted along with the object, so
+    // whoever holds on to it can still read pages that its owner has since moved elsewhere. Access is serialised, so
+    // one thread can read pages while another writes them.
+    class ChunkPageFile
+    {
+    public:
+        struct Page
+        {
+            uint64_t m_uiOffset;
+            uint64_t m_uiSize;
+        };
+
+        // Pages copied in from another file read back only if the palette they were encoded with is carried over.
+        ChunkPageFile(std::filesystem::path path, save_game::ItemPalette palette);
+        ~ChunkPageFile();
+        ChunkPageFile(const ChunkPageFile&) = delete;
+        ChunkPageFile& operator=(const ChunkPageFile&) = delete;
+
+        // The snapshot must hold just the one chunk, with its layout.
+        std::optional<Page> Write(const save_game::BlockKey& key, const save_game::SimulationSnapshot& snapshot);
+        std::optional<Page> CopyPage(const ChunkPageFile& source, const Page& page);
+
+        // Appends a page's layout, topology and records to a snapshot. On failure some of them may have been appended.
+        bool Read(const Page& page, save_game::SimulationSnapshot& outSnapshot, std::string* pErrors) const;
+
+        [[nodiscard]] save_game::ItemPalette GetPalette() const;
+        [[nodiscard]] uint64_t GetSize() const;
+
+    private:
+        std::optional<Page> Append(std::span<const uint8_t> data);
+        bool ReadAt(const Page& page, std::vector<uint8_t>& vOutData) const;
+
+        std::filesystem::path m_Path;
+        std::FILE* m_pFile;
+        uint64_t m_uiSize = 0;
+        save_game::ItemPalette m_Palette;
+        mutable std::mutex m_Mutex;
+    };
+}
@@ -0,0 +1,477 @@
+#include "ChunkStreamer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <string>
+
+#include "BinaryMap.h"
+#include "ConveyorComponent.h"
+#include "EntityConstruction.h"
+#include "EntityLookupGrid.h"
+#include "FactoryScheduler.h"
+#include "ItemInputStaging.h"
+#include "Map.h"
+#include "SequenceComponent.h"
+#include "SequenceFormationSystem.h"
+#include "Topology.h"
+#include "AtlasGame/Scene/Components/PositionComponent.h"
+#include "AtlasScene/ECS/Components/EcsManager.h"
+
+namespace
+{
+    using namespace cpp_conv::components;
+    using atlas::game::scene::components::PositionComponent;
+    using atlas::scene::EntityId;
+    using cpp_conv::save_game::BlockKey;
+
+    // Chebyshev distance on the floor plane, in chunks, from a chunk to the nearest focus.
+    int32_t getFocusDistance(const BlockKey& key, const std::span<const Eigen::Vector2i> focusChunks)
+    {
+        int32_t iDistance = std::numeric_limits<int32_t>::max();
+        for (const Eigen::Vector2i& focus : focusChunks)
+        {
+            iDistance = std::min(
+                iDistance,
+                std::max(std::abs(key.m_iChunkX - focus.x()), std::abs(key.m_iChunkZ - focus.y())));
+        }
+
+        return iDistance;
+    }
+
+    // Numbers page files across every streamer, so that a file still being read by someone else is never reused.
+    uint32_t getNextPageFileNumber()
+    {
+        static std::atomic<uint32_t> s_uiNextNumber{0};
+        return s_uiNextNumber.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+cpp_conv::ChunkStreamer::ChunkStreamer(EntityLookupGrid& grid, FactoryScheduler& scheduler, const Settings settings)
+    : m_LookupGrid{grid}
+    , m_Scheduler{scheduler}
+    , m_Settings{settings}
+{
+}
+
+cpp_conv::save_game::BlockKey cpp_conv::ChunkStreamer::GetChunkKey(const Eigen::Vector3i& position)
+{
+    return {
+        position.x() >> EntityLookupGrid::c_iChunkShift,
+        position.z() >> EntityLookupGrid::c_iChunkShift,
+        position.y()};
+}
+
+void cpp_conv::ChunkStreamer::Update(
+    atlas::scene::EcsManager& ecs,
+    const std::span<const Eigen::Vector3f> focusPoints)
+{
+    const uint64_t uiTick = m_Scheduler.GetCurrentTick();
+    if (focusPoints.empty() || uiTick < m_uiNextUpdateTick)
+    {
+        return;
+    }
+
+    m_uiNextUpdateTick = uiTick + m_Settings.m_uiUpdateIntervalTicks;
+
+    std::vector<Eigen::Vector2i> vFocusChunks;
+    vFocusChunks.reserve(focusPoints.size());
+    for (const Eigen::Vector3f& point : focusPoints)
+    {
+        const Eigen::Vector3i position = point.array().floor().cast<int32_t>();
+        const BlockKey key = GetChunkKey(position);
+        vFocusChunks.emplace_back(key.m_iChunkX, key.m_iChunkZ);
+    }
+
+    size_t uiTransitions = 0;
+    std::vector<std::pair<int32_t, BlockKey>> vCandidates;
+
+    for (const BlockKey& key : m_FrozenChunks | std::views::keys)
+    {
+        const int32_t iDistance = getFocusDistance(key, vFocusChunks);
+        if (iDistance <= m_Settings.m_iThawDistance)
+        {
+            vCandidates.emplace_back(iDistance, key);
+        }
+    }
+
+    // Nearest first, as those are the ones most likely to be on screen.
+    std::ranges::sort(vCandidates);
+    for (const BlockKey& key : vCandidates | std::views::values)
+    {
+        if (uiTransitions == m_Settings.m_uiMaxTransitionsPerUpdate)
+        {
+            return;
+        }
+
+        Thaw(ecs, key);
+        uiTransitions++;
+    }
+
+    vCandidates.clear();
+    for (const Eigen::Vector3i& origin : m_LookupGrid.GetChunkOrigins())
+    {
+        const BlockKey key = GetChunkKey(origin);
+        const int32_t iDistance = getFocusDistance(key, vFocusChunks);
+        if (iDistance > m_Settings.m_iFreezeDistance)
+        {
+            vCandidates.emplace_back(iDistance, key);
+        }
+    }
+
+    std::ranges::sort(vCandidates, std::greater{});
+    for (const BlockKey& key : vCandidates | std::views::values)
+    {
+        if (uiTransitions == m_Settings.m_uiMaxTransitionsPerUpdate)
+        {
+            return;
+        }
+
+        // Chunks that are only overlapped by an entity placed in a neighbouring chunk have nothing to freeze.
+        if (Freeze(ecs, key))
+        {
+            uiTransitions++;
+        }
+    }
+}
+
+bool cpp_conv::ChunkStreamer::Freeze(atlas::scene::EcsManager& ecs, const save_game::BlockKey& key)
+{
+    if (IsFrozen(key))
+    {
+        return false;
+    }
+
+    const std::vector<EntityId> vEntities = GetChunkEntities(ecs, key, 0);
+    if (vEntities.empty())
+    {
+        return false;
+    }
+
+    std::vector<EntityId> vConveyors;
+    for (const EntityId entity : vEntities)
+    {
+        if (ecs.DoesEntityHaveComponent<ConveyorComponent>(entity))
+        {
+            vConveyors.push_back(entity);
+        }
+    }
+
+    // Sequences are captured whole, so any that run through the chunk are broken up first. The parts outside the chunk
+    // are formed into sequences of their own once it is gone.
+    std::vector<EntityId> vRemnants;
+    DissolveSequences(ecs, vConveyors, vRemnants);
+
+    const uint64_t uiTick = m_Scheduler.GetCurrentTick();
+    save_game::clearSnapshot(m_Snapshot);
+    m_Snapshot.m_uiTick = uiTick;
+    save_game::captureEntities(ecs, vEntities, m_Snapshot);
+
+    if (!m_pPages)
+    {
+        m_pPages = std::make_shared<ChunkPageFile>(GetNextPagePath(), save_game::ItemPalette{});
+    }
+
+    const std::optional<ChunkPageFile::Page> page = m_pPages->Write(key, m_Snapshot);
+    if (!page)
+    {
+        // The chunk stays resident, so its sequences are formed again as they were.
+        std::cerr << std::format("Failed to page out chunk {}, {} on floor {}\n", key.m_iChunkX, key.m_iChunkZ, key.m_iFloor);
+        SequenceFormationSystem::FormSequences(ecs, m_LookupGrid, vRemnants);
+        return false;
+    }
+
+    for (const EntityId entity : vEntities)
+    {
+        m_LookupGrid.RemoveEntity(entity);
+        ecs.RemoveEntity(entity);
+    }
+
+    // vEntities is in entity id order, as the region query returns it.
+    std::erase_if(vRemnants, [&vEntities](const EntityId entity)
+    {
+        return std::ranges::binary_search(vEntities, entity);
+    });
+    SequenceFormationSystem::FormSequences(ecs, m_LookupGrid, vRemnants);
+
+    m_FrozenChunks.emplace(key, FrozenChunk{uiTick, *page});
+    m_uiLivePageSize += page->m_uiSize;
+    return true;
+}
+
+bool cpp_conv::ChunkStreamer::Thaw(atlas::scene::EcsManager& ecs, const save_game::BlockKey& key)
+{
+    const auto it = m_FrozenChunks.find(key);
+    if (it == m_FrozenChunks.end())
+    {
+        return false;
+    }
+
+    save_game::clearSnapshot(m_Snapshot);
+    if (!AppendFrozenChunk(key, it->second, m_Snapshot))
+    {
+        return false;
+    }
+
+    std::string errors;
+    resources::Map map;
+    if (!map.AdoptBinaryData(resources::writeBinaryMap(m_Snapshot.m_vLayout), &errors))
+    {
+        std::cerr << std::format("Failed to thaw chunk {}, {} on floor {}\n{}", key.m_iChunkX, key.m_iChunkZ, key.m_iFloor, errors);
+        return false;
+    }
+
+    // Sequences that end at the border are broken up, to be formed again along with the chunk's conveyors.
+    std::vector<EntityId> vBorderConveyors;
+    for (const EntityId entity : GetChunkEntities(ecs, key, 1))
+    {
+        if (ecs.DoesEntityHaveComponent<ConveyorComponent>(entity))
+        {
+            vBorderConveyors.push_back(entity);
+        }
+    }
+
+    std::vector<EntityId> vRemnants;
+    DissolveSequences(ecs, vBorderConveyors, vRemnants);
+
+    const entity_construction::MapModels models = entity_construction::loadMapModels(map);
+    entity_construction::constructMapEntities(ecs, m_LookupGrid, map, models);
+
+    // Corner state depends on neighbours, which may still be frozen, so it is applied as it was rather than determined.
+    const bool bRestored =
+        topology::applyTopology(m_Snapshot.m_Topology, ecs, m_LookupGrid, &errors) &&
+        save_game::restoreSimulationState(m_Snapshot, ecs, m_LookupGrid, &errors);
+    if (!bRestored)
+    {
+        // The entities are already back in the world, so carry on without their state rather than lose them.
+        std::cerr << std::format("Failed to restore chunk {}, {} on floor {}\n{}", key.m_iChunkX, key.m_iChunkZ, key.m_iFloor, errors);
+        for (const topology::ConveyorState& state : m_Snapshot.m_Topology.m_vConveyors)
+        {
+            const EntityId entity = m_LookupGrid.GetEntity(state.m_Position);
+            if (entity.IsValid() && ecs.DoesEntityHaveComponent<ConveyorComponent>(entity))
+            {
+                vRemnants.push_back(entity);
+            }
+        }
+    }
+
+    SequenceFormationSystem::FormSequences(ecs, m_LookupGrid, vRemnants);
+
+    for (const save_game::SimulationSnapshot::Factory& factory : m_Snapshot.m_vFactories)
+    {
+        const EntityId entity = m_LookupGrid.GetEntity(factory.m_Position);
+        if (entity.IsValid() && ecs.DoesEntityHaveComponent<ItemInputStaging>(entity))
+        {
+            ecs.GetComponent<ItemInputStaging>(entity).SetWakeTarget(&m_Scheduler, entity);
+            m_Scheduler.Wake(entity);
+        }
+    }
+
+    // Factories just outside may have parked on an output into the chunk while it was frozen. They are found by
+    // footprint, as a large one can reach the border from well inside its own chunk.
+    const auto [chunkMin, chunkMax] = GetChunkBounds(key, 0);
+    const auto [ringMin, ringMax] = GetChunkBounds(key, 1);
+    for (const EntityId entity : m_LookupGrid.GetEntitiesInRegion(ringMin, ringMax))
+    {
+        if (!ecs.DoesEntityHaveComponent<ItemInputStaging>(entity) ||
+            !ecs.DoesEntityHaveComponent<PositionComponent>(entity))
+        {
+            continue;
+        }
+
+        const Eigen::Vector3i& position = ecs.GetComponent<PositionComponent>(entity).m_Position;
+        if ((position.array() < chunkMin.array()).any() || (position.array() > chunkMax.array()).any())
+        {
+            m_Scheduler.Wake(entity);
+        }
+    }
+
+    m_uiLivePageSize -= it->second.m_Page.m_uiSize;
+    m_FrozenChunks.erase(it);
+    CompactPages();
+    return bRestored;
+}
+
+bool cpp_conv::ChunkStreamer::CaptureFrozenState(save_game::SimulationSnapshot& outSnapshot) const
+{
+    for (const auto& [key, chunk] : m_FrozenChunks)
+    {
+        if (!AppendFrozenChunk(key, chunk, outSnapshot))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::shared_ptr<const cpp_conv::ChunkPageFile> cpp_conv::ChunkStreamer::GetFrozenChunks(
+    std::vector<FrozenChunk>& vOutChunks) const
+{
+    vOutChunks.clear();
+    for (const FrozenChunk& chunk : m_FrozenChunks | std::views::values)
+    {
+        vOutChunks.push_back(chunk);
+    }
+
+    return m_pPages;
+}
+
+bool cpp_conv::ChunkStreamer::ReadFrozenChunk(
+    const ChunkPageFile& pages,
+    const FrozenChunk& chunk,
+    const uint64_t uiTick,
+    save_game::SimulationSnapshot& outSnapshot,
+    std::string* pErrors)
+{
+    const size_t uiFirstFactory = outSnapshot.m_vFactories.size();
+    if (!pages.Read(chunk.m_Page, outSnapshot, pErrors))
+    {
+        return false;
+    }
+
+    // Production that was under way when the chunk froze carries on where it left off.
+    for (size_t i = uiFirstFactory; i < outSnapshot.m_vFactories.size(); ++i)
+    {
+        save_game::SimulationSnapshot::Factory& factory = outSnapshot.m_vFactories[i];
+        if (factory.m_uiProductionCompleteTick > chunk.m_uiFreezeTick)
+        {
+            factory.m_uiProductionCompleteTick += uiTick - chunk.m_uiFreezeTick;
+        }
+    }
+
+    return true;
+}
+
+bool cpp_conv::ChunkStreamer::AppendFrozenChunk(
+    const save_game::BlockKey& key,
+    const FrozenChunk& chunk,
+    save_game::SimulationSnapshot& outSnapshot) const
+{
+    std::string errors;
+    if (!ReadFrozenChunk(*m_pPages, chunk, m_Scheduler.GetCurrentTick(), outSnapshot, &errors))
+    {
+        std::cerr << std::format("Failed to read frozen chunk {}, {} on floor {}\n{}", key.m_iChunkX, key.m_iChunkZ, key.m_iFloor, errors);
+        return false;
+    }
+
+    return true;
+}
+
+void cpp_conv::ChunkStreamer::CompactPages()
+{
+    // Anyone still reading the old file keeps it alive until they are done.
+    if (m_FrozenChunks.empty())
+    {
+        m_pPages.reset();
+        m_uiLivePageSize = 0;
+        return;
+    }
+
+    if (m_pPages->GetSize() - m_uiLivePageSize <= m_uiLivePageSize)
+    {
+        return;
+    }
+
+    // Nothing is moved over unless every page is, so a failure leaves the chunks where they were.
+    const auto pPages = std::make_shared<ChunkPageFile>(GetNextPagePath(), m_pPages->GetPalette());
+    std::vector<ChunkPageFile::Page> vPages;
+    vPages.reserve(m_FrozenChunks.size());
+    for (const FrozenChunk& chunk : m_FrozenChunks | std::views::values)
+    {
+        const std::optional<ChunkPageFile::Page> page = pPages->CopyPage(*m_pPages, chunk.m_Page);
+        if (!page)
+        {
+            return;
+        }
+
+        vPages.push_back(*page);
+    }
+
+    size_t uiPage = 0;
+    for (FrozenChunk& chunk : m_FrozenChunks | std::views::values)
+    {
+        chunk.m_Page = vPages[uiPage++];
+    }
+
+    m_pPages = pPages;
+    m_uiLivePageSize = m_pPages->GetSize();
+}
+
+std::filesystem::path cpp_conv::ChunkStreamer::GetNextPagePath() const
+{
+    return m_Settings.m_PageDirectory / std::format("chunks{}.cppg", getNextPageFileNumber());
+}
+
+void cpp_conv::ChunkStreamer::DissolveSequences(
+    atlas::scene::EcsManager& ecs,
+    const std::span<const EntityId> conveyors,
+    std::vector<EntityId>& vOutConveyors) const
+{
+    std::vector<EntityId> vSequences;
+    for (const EntityId entity : conveyors)
+    {
+        const EntityId sequence = ecs.GetComponent<ConveyorComponent>(entity).m_Sequence;
+        if (sequence.IsValid())
+        {
+            vSequences.push_back(sequence);
+        }
+    }
+
+    std::ranges::sort(vSequences);
+    const auto [first, last] = std::ranges::unique(vSequences);
+    vSequences.erase(first, last);
+
+    for (const EntityId sequence : vSequences)
+    {
+        if (ecs.DoesEntityHaveComponent<SequenceComponent>(sequence))
+        {
+            SequenceFormationSystem::DissolveSequence(ecs, m_LookupGrid, sequence, vOutConveyors);
+        }
+    }
+}
+
+std::vector<atlas::scene::EntityId> cpp_conv::ChunkStreamer::GetChunkEntities(
+    atlas::scene::EcsManager& ecs,
+    const save_game::BlockKey& key,
+    const int32_t iBorder) const
+{
+    const auto [min, max] = GetChunkBounds(key, iBorder);
+
+    // Entities belong to the chunk their position is in, even when their footprint reaches into others.
+    std::vector<EntityId> vEntities = m_LookupGrid.GetEntitiesInRegion(min, max);
+    std::erase_if(vEntities, [&ecs, &min, &max](const EntityId entity)
+    {
+        if (!ecs.DoesEntityHaveComponent<PositionComponent>(entity))
+        {
+            return true;
+        }
+
+        const Eigen::Vector3i& position = ecs.GetComponent<PositionComponent>(entity).m_Position;
+        return (position.array() < min.array()).any() || (position.array() > max.array()).any();
+    });
+
+    return vEntities;
+}
+
+std::pair<Eigen::Vector3i, Eigen::Vector3i> cpp_conv::ChunkStreamer::GetChunkBounds(
+    const save_game::BlockKey& key,
+    const int32_t iBorder)
+{
+    const Eigen::Vector3i min{
+        (key.m_iChunkX << EntityLookupGrid::c_iChunkShift) - iBorder,
+        key.m_iFloor,
+        (key.m_iChunkZ << EntityLookupGrid::c_iChunkShift) - iBorder};
+    const Eigen::Vector3i max = min + Eigen::Vector3i{
+        EntityLookupGrid::c_iChunkSize - 1 + iBorder * 2,
+        0,
+        EntityLookupGrid::c_iChunkSize - 1 + iBorder * 2};
+
+    return {min, max};
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ChunkPageFile.h"
+#include "SaveGame.h"
+#include "AtlasScene/ECS/Entity.h"
+#include "Eigen/Core"
+
+namespace atlas::scene
+{
+    class EcsManager;
+}
+
+namespace cpp_conv
+{
+    class EntityLookupGrid;
+    class FactoryScheduler;
+
+    // Keeps only the grid chunks near a focus point resident. A chunk far from all of them is frozen: its entities are
+    // captured, paged out to disk and removed from the ECS and the grid, so memory and per-tick work follow the working
+    // set rather than everything ever built. A frozen chunk does not run, and items headed into it back up at its border.
+    // Thawing constructs its entities again, restores their state and reforms the conveyor sequences that cross its
+    // border, with factory timers moved on by the time the chunk spent frozen.
+    class ChunkStreamer
+    {
+    public:
+        struct Settings
+        {
+            // Distances are in chunks, on the floor plane, to the nearest focus point. Keep the freeze distance above the
+            // thaw distance so that chunks on the edge do not flip back and forth.
+            int32_t m_iThawDistance;
+            int32_t m_iFreezeDistance;
+            uint64_t m_uiUpdateIntervalTicks;
+            // Spreads the work of a large jump in focus over several updates.
+            size_t m_uiMaxTransitionsPerUpdate;
+            // Where frozen chunks are paged out to.
+            std::filesystem::path m_PageDirectory;
+        };
+
+        // Where a frozen chunk was paged out to, and when.
+        struct FrozenChunk
+        {
+            uint64_t m_uiFreezeTick;
+            ChunkPageFile::Page m_Page;
+        };
+
+        ChunkStreamer(EntityLookupGrid& grid, FactoryScheduler& scheduler, Settings settings);
+        ChunkStreamer(const ChunkStreamer&) = delete;
+        ChunkStreamer& operator=(const ChunkStreamer&) = delete;
+
+        // Call between ticks, while nothing else touches the ECS. Thaws the nearest frozen chunks within range of a focus
+        // point, then freezes the furthest resident ones out of range. Does nothing without any focus points.
+        void Update(atlas::scene::EcsManager& ecs, std::span<const Eigen::Vector3f> focusPoints);
+
+        bool Freeze(atlas::scene::EcsManager& ecs, const save_game::BlockKey& key);
+        bool Thaw(atlas::scene::EcsManager& ecs, const save_game::BlockKey& key);
+
+        // Appends the frozen chunks, with their layout, to a snapshot of the resident ones, so that saves cover the
+        // whole world. Fails if a page cannot be read back.
+        bool CaptureFrozenState(save_game::SimulationSnapshot& outSnapshot) const;
+
+        // Lists the frozen chunks and returns the file they are paged out to, which stays readable for as long as it is
+        // held, so that they can be read back on another thread while the streamer carries on.
+        std::shared_ptr<const ChunkPageFile> GetFrozenChunks(std::vector<FrozenChunk>& vOutChunks) const;
+
+        // Appends a frozen chunk's state and layout to a snapshot taken on uiTick, as if the chunk had been paused
+        // rather than frozen.
+        static bool ReadFrozenChunk(
+            const ChunkPageFile& pages,
+            const FrozenChunk& chunk,
+            uint64_t uiTick,
+            save_game::SimulationSnapshot& outSnapshot,
+            std::string* pErrors);
+
+        [[nodiscard]] bool IsFrozen(const save_game::BlockKey& key) const { return m_FrozenChunks.contains(key); }
+        [[nodiscard]] size_t GetFrozenChunkCount() const { return m_FrozenChunks.size(); }
+
+        [[nodiscard]] static save_game::BlockKey GetChunkKey(const Eigen::Vector3i& position);
+
+    private:
+        bool AppendFrozenChunk(
+            const save_game::BlockKey& key,
+            const FrozenChunk& chunk,
+            save_game::SimulationSnapshot& outSnapshot) const;
+
+        // Superseded pages are dropped by moving the live ones to a new file, once they outweigh them.
+        void CompactPages();
+        [[nodiscard]] std::filesystem::path GetNextPagePath() const;
+
+        // Breaks up the sequences running through the given conveyors, and appends all of their conveyors.
+        void DissolveSequences(
+            atlas::scene::EcsManager& ecs,
+            std::span<const atlas::scene::EntityId> conveyors,
+            std::vector<atlas::scene::EntityId>& vOutConveyors) const;
+
+        // The chunk's tiles widened by iBorder on x/z, inclusive on every axis.
+        [[nodiscard]] static std::pair<Eigen::Vector3i, Eigen::Vector3i> GetChunkBounds(
+            const save_game::BlockKey& key,
+            int32_t iBorder);
+        [[nodiscard]] std::vector<atlas::scene::EntityId> GetChunkEntities(
+            atlas::scene::EcsManager& ecs,
+            const save_game::BlockKey& key,
+            int32_t iBorder) const;
+
+        EntityLookupGrid& m_LookupGrid;
+        FactoryScheduler& m_Scheduler;
+        Settings m_Settings;
+        uint64_t m_uiNextUpdateTick = 0;
+
+        std::map<save_game::BlockKey, FrozenChunk> m_FrozenChunks;
+        std::shared_ptr<ChunkPageFile> m_pPages;
+        uint64_t m_uiLivePageSize = 0;
+
+        // Freeze and Thaw's working copy of a chunk, kept to reuse its buffers.
+        save_game::SimulationSnapshot m_Snapshot;
+    };
+}
@@ -16,6 +16,16 @@ atlas::scene::EntityId cpp_conv::conveyor_helper::findNextTailConveyor(
     const Eigen::Vector3i position,
     const Direction direction,
     RelativeDirection& outDirection)
+{
+    return findNextTailConveyor(ecs, grid.GetNeighbourhood(position, direction), position, direction, outDirection);
+}
+
+atlas::scene::EntityId cpp_conv::conveyor_helper::findNextTailConveyor(
+    const atlas::scene::EcsManager& ecs,
+    const EntityLookupGrid::Neighbourhood& neighbourhood,
+    const Eigen::Vector3i position,
+    const Direction direction,
+    RelativeDirection& outDirection)
 {
     using namespace components;
     using atlas::scene::EntityId;
@@ -35,7 +45,7 @@ atlas::scene::EntityId cpp_conv::conveyor_helper::findNextTailConveyor(
     EntityId pTargetConveyor = EntityId::Invalid();
     for (auto d : directionPriority)
     {
-        EntityId directionEntity = grid.GetEntity(vPositions[static_cast<int>(d)]);
+        EntityId directionEntity = neighbourhood.Get(d);
         if (directionEntity.IsInvalid() || !ecs.DoesEntityHaveComponents<
             atlas::game::scene::components::PositionComponent, DirectionComponent, WorldEntityInformationComponent>(directionEntity))
         {
@@ -6,14 +6,10 @@
 #include <Eigen/Core>
 
 #include "ConveyorComponent.h"
+#include "EntityLookupGrid.h"
 #include "SequenceComponent.h"
 #include "AtlasScene/ECS/Components/EcsManager.h"
 
-namespace cpp_conv
-{
-    class EntityLookupGrid;
-}
-
 namespace atlas::scene
 {
     class EcsManager;
@@ -23,13 +19,13 @@ namespace cpp_conv::conveyor_helper
 {
     struct InsertInfo
     {
-        ItemId m_Item{};
+        ItemIndex m_Item{};
         std::optional<Eigen::Vector2f> m_OriginPosition{};
     };
 
     struct ItemInformation
     {
-        ItemId m_Item;
+        ItemIndex m_Item;
         Eigen::Vector2f m_PreviousVisualLocation;
         bool m_bIsAnimated;
     };
@@ -41,6 +37,14 @@ namespace cpp_conv::conveyor_helper
         Direction direction,
         RelativeDirection& outDirection);
 
+    // As above, for callers which already hold the neighbourhood of the position.
+    atlas::scene::EntityId findNextTailConveyor(
+        const atlas::scene::EcsManager& ecs,
+        const EntityLookupGrid::Neighbourhood& neighbourhood,
+        Eigen::Vector3i position,
+        Direction direction,
+        RelativeDirection& outDirection);
+
     bool hasItemInSlot(
         const components::SequenceComponent& sequence,
         uint8_t sequenceIndex,
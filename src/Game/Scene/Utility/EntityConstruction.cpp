@@ -0,0 +1,410 @@
+#include "EntityConstruction.h"
+
+#include <algorithm>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "AssetRegistry.h"
+#include "BinaryMap.h"
+#include "CompiledRecipe.h"
+#include "Constants.h"
+#include "ConveyorComponent.h"
+#include "DescriptionComponent.h"
+#include "DirectionComponent.h"
+#include "EntityLookupGrid.h"
+#include "FactoryComponent.h"
+#include "FactoryRegistry.h"
+#include "ItemInputStaging.h"
+#include "Map.h"
+#include "ModelComponent.h"
+#include "NameComponent.h"
+#include "RecipeRegistry.h"
+#include "StorageComponent.h"
+#include "WorldEntityInformationComponent.h"
+#include "AtlasGame/Scene/Components/PositionComponent.h"
+#include "AtlasRender/AssetTypes/ModelAsset.h"
+#include "AtlasResource/ResourceLoader.h"
+#include "AtlasScene/ECS/Components/EcsManager.h"
+
+namespace
+{
+    using namespace cpp_conv::components;
+    using atlas::game::scene::components::PositionComponent;
+    using atlas::scene::EcsManager;
+    using atlas::scene::EntityId;
+    using cpp_conv::entity_construction::MapModels;
+    using cpp_conv::resources::BinaryMapSection;
+    using cpp_conv::resources::BinaryMapView;
+
+    // The entities of one section that are being constructed, as indices into its columns alongside their ECS ids.
+    struct SectionEntities
+    {
+        const BinaryMapSection* m_pSection;
+        std::vector<size_t> m_vIndices;
+        std::vector<EntityId> m_vEntities;
+    };
+
+    // Everything a factory's components need from its definition, resolved once per definition rather than per entity.
+    struct FactoryTemplate
+    {
+        const cpp_conv::FactoryDefinition* m_pDefinition;
+        cpp_conv::RecipeIndex m_Recipe;
+        std::optional<Eigen::Vector3i> m_OutputPipe;
+        uint32_t m_uiInputStacks;
+    };
+
+    using FactoryTemplates = std::unordered_map<uint64_t, std::optional<FactoryTemplate>>;
+
+    // Text maps are read through the same columns as binary ones, converted into the given buffer.
+    const BinaryMapView* getEntityColumns(
+        const cpp_conv::resources::Map& map,
+        std::vector<uint8_t>& vConvertedData,
+        std::optional<BinaryMapView>& convertedView)
+    {
+        if (const BinaryMapView* pView = map.GetBinaryView())
+        {
+            return pView;
+        }
+
+        vConvertedData = cpp_conv::resources::writeBinaryMap(map);
+        convertedView = BinaryMapView::Create(vConvertedData, nullptr);
+        return convertedView ? &*convertedView : nullptr;
+    }
+
+    bool isConstructedKind(const EntityKind kind)
+    {
+        return kind == EntityKind::Conveyor ||
+            kind == EntityKind::Producer ||
+            kind == EntityKind::Storage ||
+            kind == EntityKind::LaunchPad;
+    }
+
+    Eigen::Vector3i getPosition(const BinaryMapSection& section, const size_t uiIndex)
+    {
+        return {section.m_PositionX[uiIndex], section.m_PositionY[uiIndex], section.m_PositionZ[uiIndex]};
+    }
+
+    Direction getDirection(const BinaryMapSection& section, const size_t uiIndex)
+    {
+        return section.m_Direction.empty() ? Direction::Right : static_cast<Direction>(section.m_Direction[uiIndex]);
+    }
+
+    const FactoryTemplate* getFactoryTemplate(FactoryTemplates& templates, const uint64_t uiDefinition)
+    {
+        auto [it, bInserted] = templates.try_emplace(uiDefinition);
+        if (bInserted)
+        {
+            const cpp_conv::FactoryDefinition* pDefinition = cpp_conv::resources::getFactoryDefinition({uiDefinition});
+            if (pDefinition)
+            {
+                FactoryTemplate& factoryTemplate = it->second.emplace();
+                factoryTemplate.m_pDefinition = pDefinition;
+                factoryTemplate.m_Recipe = cpp_conv::resources::getRecipeIndex(pDefinition->GetProducedRecipe());
+                if (pDefinition->HasOwnOutputPipe())
+                {
+                    factoryTemplate.m_OutputPipe = pDefinition->GetOutputPipe();
+                }
+
+                // Inputs only ever hold what the recipe consumes, so size them to it. Outputs keep the default headroom
+                // so that a blocked factory can buffer more than one cycle.
+                const cpp_conv::CompiledRecipe* pRecipe = cpp_conv::resources::getCompiledRecipe(factoryTemplate.m_Recipe);
+                factoryTemplate.m_uiInputStacks = pRecipe ? std::max(pRecipe->m_uiInputStacks, 1U) : 0;
+            }
+        }
+
+        return it->second ? &*it->second : nullptr;
+    }
+
+    // The footprint an entity occupies, or nothing if it cannot be constructed.
+    std::optional<Eigen::Vector3i> getSize(
+        const BinaryMapSection& section,
+        const size_t uiIndex,
+        FactoryTemplates& factoryTemplates)
+    {
+        switch (section.m_Kind)
+        {
+        case EntityKind::Producer:
+            {
+                if (section.m_Definition.empty())
+                {
+                    return {};
+                }
+
+                const FactoryTemplate* pTemplate = getFactoryTemplate(factoryTemplates, section.m_Definition[uiIndex]);
+                return pTemplate ? std::optional{pTemplate->m_pDefinition->GetSize()} : std::nullopt;
+            }
+        case EntityKind::Storage:
+            return Eigen::Vector3i{1, 1, 1};
+        case EntityKind::LaunchPad:
+            return Eigen::Vector3i{10, 4, 10};
+        default:
+            break;
+        }
+
+        if (section.m_SizeX.empty())
+        {
+            return Eigen::Vector3i{1, 1, 1};
+        }
+
+        return Eigen::Vector3i{section.m_SizeX[uiIndex], section.m_SizeY[uiIndex], section.m_SizeZ[uiIndex]};
+    }
+
+    // Each helper writes one component type for every entity of a section, so that a pass only touches a single
+    // component store.
+    template <typename TComponent, typename TInitialise>
+    void addComponents(EcsManager& ecs, const SectionEntities& entities, TInitialise&& initialise)
+    {
+        for (size_t i = 0; i < entities.m_vEntities.size(); ++i)
+        {
+            initialise(ecs.AddComponent<TComponent>(entities.m_vEntities[i]), entities.m_vIndices[i]);
+        }
+    }
+
+    template <typename TComponent, typename TGetArgument>
+    void addComponentsFrom(EcsManager& ecs, const SectionEntities& entities, TGetArgument&& getArgument)
+    {
+        for (size_t i = 0; i < entities.m_vEntities.size(); ++i)
+        {
+            ecs.AddComponent<TComponent>(entities.m_vEntities[i], getArgument(entities.m_vIndices[i]));
+        }
+    }
+
+    template <typename TComponent, typename... TArgs>
+    void addComponentsWith(EcsManager& ecs, const SectionEntities& entities, const TArgs&... args)
+    {
+        for (const EntityId entity : entities.m_vEntities)
+        {
+            ecs.AddComponent<TComponent>(entity, args...);
+        }
+    }
+
+    void addConveyorComponents(EcsManager& ecs, const SectionEntities& entities)
+    {
+        addComponentsWith<NameComponent>(ecs, entities, "Basic Conveyor");
+        addComponentsWith<DescriptionComponent>(ecs, entities, "The wheels of invention");
+        addComponentsWith<ConveyorComponent>(ecs, entities);
+    }
+
+    void addFactoryComponents(
+        EcsManager& ecs,
+        const SectionEntities& entities,
+        FactoryTemplates& factoryTemplates,
+        const MapModels& models)
+    {
+        using namespace cpp_conv::constants::render_masks;
+
+        const BinaryMapSection& section = *entities.m_pSection;
+        const auto getTemplate = [&](const size_t uiIndex) -> const FactoryTemplate&
+        {
+            // Only factories with a known definition made it this far.
+            return *getFactoryTemplate(factoryTemplates, section.m_Definition[uiIndex]);
+        };
+
+        for (size_t i = 0; i < entities.m_vEntities.size(); ++i)
+        {
+            const auto modelIt = models.m_Factories.find(section.m_Definition[entities.m_vIndices[i]]);
+            if (modelIt != models.m_Factories.end() && modelIt->second)
+            {
+                ecs.AddComponent<ModelComponent>(entities.m_vEntities[i], modelIt->second, c_generalGeometry | c_shadowCaster);
+            }
+        }
+
+        addComponentsFrom<NameComponent>(ecs, entities, [&](const size_t uiIndex)
+        {
+            return getTemplate(uiIndex).m_pDefinition->GetName().c_str();
+        });
+
+        addComponentsWith<ItemInputStaging>(ecs, entities);
+        addComponents<FactoryComponent>(ecs, entities, [&](FactoryComponent& factory, const size_t uiIndex)
+        {
+            const FactoryTemplate& factoryTemplate = getTemplate(uiIndex);
+            factory.m_Definition = {section.m_Definition[uiIndex]};
+            factory.m_Size = factoryTemplate.m_pDefinition->GetSize();
+            factory.m_ProductionRate = factoryTemplate.m_pDefinition->GetProductionRate();
+            factory.m_OutputPipe = factoryTemplate.m_OutputPipe;
+            factory.m_Recipe = factoryTemplate.m_Recipe;
+            if (factoryTemplate.m_uiInputStacks != 0)
+            {
+                factory.m_InputItems.Initialise(
+                    factoryTemplate.m_uiInputStacks,
+                    cpp_conv::CompiledRecipe::c_uiStackSize,
+                    true);
+            }
+        });
+    }
+
+    void addStorageComponents(EcsManager& ecs, const SectionEntities& entities, const MapModels& models)
+    {
+        using namespace cpp_conv::constants::render_masks;
+
+        const BinaryMapSection& section = *entities.m_pSection;
+        addComponentsWith<NameComponent>(ecs, entities, "Storage");
+        addComponentsWith<ModelComponent>(
+            ecs,
+            entities,
+            models.m_Storage,
+            c_generalGeometry | c_shadowCaster);
+
+        addComponentsWith<ItemInputStaging>(ecs, entities);
+        addComponents<StorageComponent>(ecs, entities, [&section](StorageComponent& storage, const size_t uiIndex)
+        {
+            storage.m_ItemContainer.Initialise(
+                section.m_Capacity.empty() ? 16 : section.m_Capacity[uiIndex],
+                section.m_StackSize.empty() ? 256 : section.m_StackSize[uiIndex],
+                false);
+        });
+    }
+
+    void addLaunchPadComponents(EcsManager& ecs, const SectionEntities& entities, const MapModels& models)
+    {
+        using namespace cpp_conv::constants::render_masks;
+
+        addComponentsWith<NameComponent>(ecs, entities, "Launchpad");
+        addComponentsWith<ModelComponent>(
+            ecs,
+            entities,
+            models.m_LaunchPad,
+            c_generalGeometry | c_shadowCaster | c_clipCasterGeometry);
+    }
+}
+
+cpp_conv::entity_construction::MapModels cpp_conv::entity_construction::loadMapModels(const resources::Map& map)
+{
+    using namespace atlas::resource;
+    using namespace atlas::render;
+    using namespace resources::registry;
+
+    MapModels models;
+    models.m_Storage = ResourceLoader::LoadAsset<CoreBundle, ModelAsset>(core_bundle::assets::others::c_Barrel);
+    models.m_LaunchPad = ResourceLoader::LoadAsset<CoreBundle, ModelAsset>(core_bundle::assets::others::c_LaunchPad);
+
+    std::vector<uint8_t> vConvertedData;
+    std::optional<BinaryMapView> convertedView;
+    const BinaryMapView* pView = getEntityColumns(map, vConvertedData, convertedView);
+    if (!pView)
+    {
+        return models;
+    }
+
+    for (const BinaryMapSection& section : pView->GetSections())
+    {
+        if (section.m_Kind != EntityKind::Producer)
+        {
+            continue;
+        }
+
+        for (const uint64_t uiDefinition : section.m_Definition)
+        {
+            auto [it, bInserted] = models.m_Factories.try_emplace(uiDefinition);
+            if (bInserted)
+            {
+                const FactoryDefinition* pDefinition = resources::getFactoryDefinition({uiDefinition});
+                it->second = pDefinition ? pDefinition->GetModel() : nullptr;
+            }
+        }
+    }
+
+    return models;
+}
+
+size_t cpp_conv::entity_construction::constructMapEntities(
+    atlas::scene::EcsManager& ecs,
+    EntityLookupGrid& grid,
+    const resources::Map& map,
+    const MapModels& models)
+{
+    std::vector<uint8_t> vConvertedData;
+    std::optional<BinaryMapView> convertedView;
+    const BinaryMapView* pView = getEntityColumns(map, vConvertedData, convertedView);
+    if (!pView)
+    {
+        return 0;
+    }
+
+    FactoryTemplates factoryTemplates;
+    std::vector<SectionEntities> vSections;
+    std::vector<EntityLookupGrid::Placement> vPlacements;
+    vPlacements.reserve(pView->GetEntityCount());
+
+    for (const BinaryMapSection& section : pView->GetSections())
+    {
+        if (!isConstructedKind(section.m_Kind))
+        {
+            continue;
+        }
+
+        SectionEntities& entities = vSections.emplace_back();
+        entities.m_pSection = &section;
+        entities.m_vIndices.reserve(section.m_uiCount);
+        entities.m_vEntities.reserve(section.m_uiCount);
+
+        for (size_t uiIndex = 0; uiIndex < section.m_uiCount; ++uiIndex)
+        {
+            const std::optional<Eigen::Vector3i> size = getSize(section, uiIndex, factoryTemplates);
+            if (!size)
+            {
+                continue;
+            }
+
+            const EntityId entity = ecs.AddEntity();
+            entities.m_vIndices.push_back(uiIndex);
+            entities.m_vEntities.push_back(entity);
+            vPlacements.push_back({getPosition(section, uiIndex), *size, entity});
+        }
+    }
+
+    // Release whatever collided before it gets any components.
+    std::vector<EntityId> vRejected = grid.PlaceEntities(vPlacements);
+    if (!vRejected.empty())
+    {
+        std::ranges::sort(vRejected);
+        for (SectionEntities& entities : vSections)
+        {
+            size_t uiKept = 0;
+            for (size_t i = 0; i < entities.m_vEntities.size(); ++i)
+            {
+                if (std::ranges::binary_search(vRejected, entities.m_vEntities[i]))
+                {
+                    ecs.RemoveEntity(entities.m_vEntities[i]);
+                    continue;
+                }
+
+                entities.m_vIndices[uiKept] = entities.m_vIndices[i];
+                entities.m_vEntities[uiKept] = entities.m_vEntities[i];
+                uiKept++;
+            }
+
+            entities.m_vIndices.resize(uiKept);
+            entities.m_vEntities.resize(uiKept);
+        }
+    }
+
+    size_t uiConstructed = 0;
+    for (const SectionEntities& entities : vSections)
+    {
+        const BinaryMapSection& section = *entities.m_pSection;
+        addComponentsWith<WorldEntityInformationComponent>(ecs, entities, section.m_Kind);
+        addComponentsFrom<PositionComponent>(ecs, entities, [&section](const size_t uiIndex)
+        {
+            return getPosition(section, uiIndex);
+        });
+        addComponentsFrom<DirectionComponent>(ecs, entities, [&section](const size_t uiIndex)
+        {
+            return getDirection(section, uiIndex);
+        });
+
+        switch (section.m_Kind)
+        {
+        case EntityKind::Conveyor: addConveyorComponents(ecs, entities); break;
+        case EntityKind::Producer: addFactoryComponents(ecs, entities, factoryTemplates, models); break;
+        case EntityKind::Storage: addStorageComponents(ecs, entities, models); break;
+        case EntityKind::LaunchPad: addLaunchPadComponents(ecs, entities, models); break;
+        default: break;
+        }
+
+        uiConstructed += entities.m_vEntities.size();
+    }
+
+    return uiConstructed;
+}
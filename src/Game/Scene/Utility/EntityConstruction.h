@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+#include "AtlasResource/AssetPtr.h"
+
+namespace atlas::render
+{
+    class ModelAsset;
+}
+
+namespace atlas::scene
+{
+    class EcsManager;
+}
+
+namespace cpp_conv
+{
+    class EntityLookupGrid;
+
+    namespace resources
+    {
+        class Map;
+    }
+}
+
+namespace cpp_conv::entity_construction
+{
+    // The models used by a map's entities, keyed by factory definition for factories.
+    struct MapModels
+    {
+        atlas::resource::AssetPtr<atlas::render::ModelAsset> m_Storage;
+        atlas::resource::AssetPtr<atlas::render::ModelAsset> m_LaunchPad;
+        std::unordered_map<uint64_t, atlas::resource::AssetPtr<atlas::render::ModelAsset>> m_Factories;
+    };
+
+    // Loading a model can create GPU resources, so this must run on the main thread. Construction itself does not load
+    // any assets and can run anywhere.
+    MapModels loadMapModels(const resources::Map& map);
+
+    // Creates the ECS entities for everything in a map and places them in the grid, in bulk: all entities are reserved
+    // first, footprints go into the grid in a single sorted sweep, and components are then written one component type
+    // at a time. Entities the grid rejects are released before any components are written. Returns the number of
+    // entities constructed.
+    size_t constructMapEntities(
+        atlas::scene::EcsManager& ecs,
+        EntityLookupGrid& grid,
+        const resources::Map& map,
+        const MapModels& models);
+}
@@ -1,218 +1,500 @@
 #include "EntityLookupGrid.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
 #include <cassert>
-#include "Conveyor.h"
-#include "Map.h"
+#include <limits>
+#include <numeric>
+#include <ranges>
+#include <tuple>
 
-bool cpp_conv::EntityLookupGrid::CellCoordinate::IsInvalid() const
-{
-    return
-        m_CellX < 0 || m_CellY < 0 ||
-        m_CellX >= c_uiMaximumMapSize || m_CellY >= c_uiMaximumMapSize ||
-        m_CellSlotX < 0 || m_CellSlotY < 0 ||
-        m_CellSlotX >= c_uiCellSize || m_CellSlotY >= c_uiCellSize ||
-        m_Depth < 0 || m_Depth >= c_uiMaximumLevel;
-}
+#include "PositionHelper.h"
 
-bool cpp_conv::EntityLookupGrid::Cell::HasFloor(uint32_t uiFloor) const
+namespace
 {
-    if (uiFloor >= m_CellGrid.size())
+    std::atomic<uint64_t> g_uiNextCacheGeneration{1};
+
+    // Spreads the low 16 bits of a value out to the even bits
+    constexpr uint32_t spreadBits(uint32_t uiValue)
     {
-        return false;
+        uiValue &= 0x0000FFFF;
+        uiValue = (uiValue | (uiValue << 8)) & 0x00FF00FF;
+        uiValue = (uiValue | (uiValue << 4)) & 0x0F0F0F0F;
+        uiValue = (uiValue | (uiValue << 2)) & 0x33333333;
+        uiValue = (uiValue | (uiValue << 1)) & 0x55555555;
+        return uiValue;
+    }
+
+    bool isValidSize(const Eigen::Vector3i& size)
+    {
+        return size.x() > 0 && size.y() > 0 && size.z() > 0;
     }
 
-    return m_CellGrid[uiFloor] != nullptr;
+    // The half-open box PlaceEntity assigns to an entity of the given size, centred on x/z and growing up from y.
+    std::pair<Eigen::Vector3i, Eigen::Vector3i> getFootprintBounds(const Eigen::Vector3i& position, const Eigen::Vector3i& size)
+    {
+        return {
+            {position.x() - size.x() / 2, position.y(), position.z() - size.z() / 2},
+            {position.x() + (size.x() + 1) / 2, position.y() + size.y(), position.z() + (size.z() + 1) / 2}
+        };
+    }
 }
 
-cpp_conv::EntityLookupGrid::Cell::EntityGrid& cpp_conv::EntityLookupGrid::Cell::GetFloor(uint32_t uiFloor)
+size_t cpp_conv::EntityLookupGrid::ChunkKeyHash::operator()(const ChunkKey& key) const
 {
-    return *m_CellGrid[uiFloor];
+    uint64_t uiHash = static_cast<uint32_t>(key.m_iX) * 0x9E3779B97F4A7C15ULL;
+    uiHash ^= static_cast<uint32_t>(key.m_iY) * 0xC2B2AE3D27D4EB4FULL;
+    uiHash ^= static_cast<uint32_t>(key.m_iFloor) * 0x165667B19E3779F9ULL;
+    return static_cast<size_t>(uiHash ^ (uiHash >> 29));
 }
 
-const cpp_conv::EntityLookupGrid::Cell::EntityGrid& cpp_conv::EntityLookupGrid::Cell::GetFloor(uint32_t uiFloor) const
+cpp_conv::EntityLookupGrid::EntityLookupGrid()
+    : m_uiCacheGeneration{g_uiNextCacheGeneration++}
 {
-    return *m_CellGrid[uiFloor];
 }
 
-bool cpp_conv::EntityLookupGrid::Cell::CreateFloor(uint32_t uiFloor)
+cpp_conv::EntityLookupGrid::ChunkKey cpp_conv::EntityLookupGrid::ToChunkKey(const Eigen::Vector3i& position)
 {
-    if (uiFloor >= m_CellGrid.size())
-    {
-        return false;
-    }
+    // Arithmetic shifts, so negative coordinates round down into the chunk to their left
+    return {position.x() >> c_iChunkShift, position.z() >> c_iChunkShift, position.y()};
+}
+
+uint32_t cpp_conv::EntityLookupGrid::ToSlotIndex(const Eigen::Vector3i& position)
+{
+    constexpr int32_t c_iSlotMask = c_iChunkSize - 1;
+    const auto uiSlotX = static_cast<uint32_t>(position.x() & c_iSlotMask);
+    const auto uiSlotY = static_cast<uint32_t>(position.z() & c_iSlotMask);
+    return spreadBits(uiSlotX) | (spreadBits(uiSlotY) << 1);
+}
 
-    m_bHasFloors = true;
-    if (m_CellGrid[uiFloor] != nullptr)
+template <typename TCallback>
+bool cpp_conv::EntityLookupGrid::ForEachChunkRow(const Eigen::Vector3i& min, const Eigen::Vector3i& max, TCallback&& callback)
+{
+    for (int32_t iFloor = min.y(); iFloor < max.y(); ++iFloor)
     {
-        return true;
+        for (int32_t iY = min.z(); iY < max.z(); ++iY)
+        {
+            int32_t iX = min.x();
+            while (iX < max.x())
+            {
+                const int32_t iChunkEnd = ((iX >> c_iChunkShift) + 1) << c_iChunkShift;
+                const int32_t iSpanEnd = std::min(max.x(), iChunkEnd);
+                const int32_t iFirstBit = iX & (c_iChunkSize - 1);
+                const int32_t iSpanLength = iSpanEnd - iX;
+
+                const RowMask mask = iSpanLength == c_iChunkSize
+                    ? ~RowMask{0}
+                    : static_cast<RowMask>(((RowMask{1} << iSpanLength) - 1) << iFirstBit);
+
+                const Eigen::Vector3i rowStart{iX - iFirstBit, iFloor, iY};
+                if (!callback(ToChunkKey(rowStart), rowStart, mask))
+                {
+                    return false;
+                }
+
+                iX = iSpanEnd;
+            }
+        }
     }
 
-    m_CellGrid[uiFloor] = std::make_unique<EntityGrid>();
     return true;
 }
 
-atlas::scene::EntityId cpp_conv::EntityLookupGrid::Cell::GetEntity(CellCoordinate coord) const
+const cpp_conv::EntityLookupGrid::Chunk* cpp_conv::EntityLookupGrid::FindChunk(const ChunkKey& key) const
 {
-    if (coord.IsInvalid())
+    // Neighbouring lookups overwhelmingly land in the same chunk, so remember the last hit. The cache is per thread
+    // so that concurrent readers do not race on it.
+    struct LookupCache
     {
-        return atlas::scene::EntityId::Invalid();
+        uint64_t m_uiGeneration = 0;
+        ChunkKey m_Key{};
+        const Chunk* m_pChunk = nullptr;
+    };
+    static thread_local LookupCache t_Cache;
+
+    if (t_Cache.m_uiGeneration == m_uiCacheGeneration && t_Cache.m_Key == key)
+    {
+        return t_Cache.m_pChunk;
     }
 
-    if (!HasFloor(coord.m_Depth))
+    const auto it = m_Chunks.find(key);
+    if (it == m_Chunks.end())
     {
-        return atlas::scene::EntityId::Invalid();
+        return nullptr;
     }
 
-    const EntityGrid& rFloor = GetFloor(coord.m_Depth);
-    return rFloor[coord.m_CellSlotY][coord.m_CellSlotX];
+    t_Cache = {m_uiCacheGeneration, key, it->second.get()};
+    return it->second.get();
 }
 
-bool cpp_conv::EntityLookupGrid::Cell::SetEntity(const CellCoordinate coord, atlas::scene::EntityId entity)
+cpp_conv::EntityLookupGrid::Chunk& cpp_conv::EntityLookupGrid::GetOrCreateChunk(const ChunkKey& key)
 {
-    if (coord.IsInvalid())
+    std::unique_ptr<Chunk>& pChunk = m_Chunks[key];
+    if (!pChunk)
     {
-        return false;
+        pChunk = std::make_unique<Chunk>();
     }
 
-    if (!CreateFloor(coord.m_Depth))
+    return *pChunk;
+}
+
+cpp_conv::EntityLookupGrid::Chunk& cpp_conv::EntityLookupGrid::GetOrCreateChunk(const ChunkKey& key, ChunkCursor& cursor)
+{
+    // Chunks only go away when they are emptied, which a write never does, so the chunk is reused until the key changes.
+    if (!cursor.m_pChunk || !(cursor.m_Key == key))
     {
-        return false;
+        cursor = {key, &GetOrCreateChunk(key)};
     }
 
-    EntityGrid& rFloor = GetFloor(coord.m_Depth);
-    if (rFloor[coord.m_CellSlotY][coord.m_CellSlotX] != atlas::scene::EntityId::Invalid())
+    return *cursor.m_pChunk;
+}
+
+atlas::scene::EntityId cpp_conv::EntityLookupGrid::GetEntity(const Eigen::Vector3i position) const
+{
+    const Chunk* pChunk = FindChunk(ToChunkKey(position));
+    if (!pChunk)
     {
-        return false;
+        return atlas::scene::EntityId::Invalid();
     }
 
-    rFloor[coord.m_CellSlotY][coord.m_CellSlotX] = entity;
-    return true;
+    return pChunk->m_Slots[ToSlotIndex(position)];
 }
 
-cpp_conv::EntityLookupGrid::CellCoordinate cpp_conv::EntityLookupGrid::ToCellSpace(Eigen::Vector3i position)
+cpp_conv::EntityLookupGrid::Neighbourhood cpp_conv::EntityLookupGrid::GetNeighbourhood(
+    const Eigen::Vector3i position, const Direction direction) const
 {
-    constexpr int32_t worldToGridSpaceValue = (c_uiMaximumMapSize / 2) * c_uiCellSize;
-    const Eigen::Vector3i worldToGridSpaceTransform = {worldToGridSpaceValue, 0, worldToGridSpaceValue};
-    position += worldToGridSpaceTransform;
-
-    constexpr int32_t axisSize = c_uiMaximumMapSize * c_uiCellSize;
-    if (position.x() < 0 || position.z() < 0 || position.x() >= axisSize || position.z() >= axisSize)
+    using position_helper::getForwardPosition;
+    using position_helper::getBackwardsPosition;
+    using position_helper::getLeftPosition;
+    using position_helper::getRightPosition;
+
+    const Eigen::Vector3i forwardPosition = getForwardPosition(position, direction);
+    const Eigen::Vector3i backPosition = getBackwardsPosition(position, direction);
+    const Eigen::Vector3i leftPosition = getLeftPosition(position, direction);
+    const Eigen::Vector3i rightPosition = getRightPosition(position, direction);
+
+    // The floors above and below are looked up directly rather than through FindChunk, so they do not evict the
+    // centre's chunk from the lookup cache.
+    const auto getVerticalEntity = [this](const Eigen::Vector3i& verticalPosition)
+    {
+        const auto it = m_Chunks.find(ToChunkKey(verticalPosition));
+        return it == m_Chunks.end() ? atlas::scene::EntityId::Invalid() : it->second->m_Slots[ToSlotIndex(verticalPosition)];
+    };
+
+    Neighbourhood neighbourhood;
+    neighbourhood.m_Up = getVerticalEntity(position + Eigen::Vector3i{0, 1, 0});
+    neighbourhood.m_Down = getVerticalEntity(position + Eigen::Vector3i{0, -1, 0});
+
+    // Away from the chunk border all four horizontal neighbours share the centre's chunk, so it only has to be found once.
+    constexpr int32_t c_iSlotMask = c_iChunkSize - 1;
+    const int32_t iSlotX = position.x() & c_iSlotMask;
+    const int32_t iSlotY = position.z() & c_iSlotMask;
+    if (iSlotX == 0 || iSlotX == c_iSlotMask || iSlotY == 0 || iSlotY == c_iSlotMask)
     {
-        return {-1, -1, -1, -1, position.y()};
+        neighbourhood.m_Forward = GetEntity(forwardPosition);
+        neighbourhood.m_Back = GetEntity(backPosition);
+        neighbourhood.m_Left = GetEntity(leftPosition);
+        neighbourhood.m_Right = GetEntity(rightPosition);
+        return neighbourhood;
     }
 
-    const auto iHorizontalCell = position.x() / c_uiCellSize;
-    const auto iHorizontalSlot = position.x() % c_uiCellSize;
+    const Chunk* pChunk = FindChunk(ToChunkKey(position));
+    if (!pChunk)
+    {
+        return neighbourhood;
+    }
 
-    const auto iVerticalCell = position.z() / c_uiCellSize;
-    const auto iVerticalSlot = position.z() % c_uiCellSize;
+    neighbourhood.m_Forward = pChunk->m_Slots[ToSlotIndex(forwardPosition)];
+    neighbourhood.m_Back = pChunk->m_Slots[ToSlotIndex(backPosition)];
+    neighbourhood.m_Left = pChunk->m_Slots[ToSlotIndex(leftPosition)];
+    neighbourhood.m_Right = pChunk->m_Slots[ToSlotIndex(rightPosition)];
+    return neighbourhood;
+}
 
-    return {iHorizontalCell, iVerticalCell, iHorizontalSlot, iVerticalSlot, position.y()};
+void cpp_conv::EntityLookupGrid::WriteFootprint(const Footprint& footprint, const atlas::scene::EntityId entity)
+{
+    ChunkCursor cursor;
+    [[maybe_unused]] const bool bWritten = TryWriteFootprint(footprint, entity, cursor);
+    assert(bWritten);
 }
 
-atlas::scene::EntityId cpp_conv::EntityLookupGrid::GetEntity(const Eigen::Vector3i position) const
+bool cpp_conv::EntityLookupGrid::TryWriteFootprint(const Footprint& footprint, const atlas::scene::EntityId entity,
+                                                   ChunkCursor& cursor)
 {
-    const CellCoordinate coord = ToCellSpace(position);
-    if (coord.IsInvalid())
+    // Each span is checked just before it is written, so the footprint is walked once unless it collides part way.
+    const auto [min, max] = getFootprintBounds(footprint.m_Position, footprint.m_Size);
+    size_t uiWrittenSpans = 0;
+    const bool bWritten = ForEachChunkRow(min, max, [this, entity, &cursor, &uiWrittenSpans](const ChunkKey& key, const Eigen::Vector3i& rowStart, const RowMask mask)
     {
-        return atlas::scene::EntityId::Invalid();
-    }
+        Chunk& rChunk = GetOrCreateChunk(key, cursor);
+        RowMask& rRow = rChunk.m_OccupiedRows[rowStart.z() & (c_iChunkSize - 1)];
+        if ((rRow & mask) != 0)
+        {
+            return false;
+        }
+
+        rRow |= mask;
+        for (RowMask remaining = mask; remaining != 0; remaining &= remaining - 1)
+        {
+            const int32_t iBit = std::countr_zero(remaining);
+            rChunk.m_Slots[ToSlotIndex(rowStart + Eigen::Vector3i{iBit, 0, 0})] = entity;
+        }
 
-    const Cell* pCell = GetCell(coord);
-    if (!pCell)
+        rChunk.m_uiOccupiedSlots += static_cast<uint32_t>(std::popcount(mask));
+        ++uiWrittenSpans;
+        return true;
+    });
+
+    if (!bWritten)
     {
-        return atlas::scene::EntityId::Invalid();
+        // Undo the spans already written. Chunks this created are released again, so the cursor may not outlive them.
+        EraseSpans(min, max, uiWrittenSpans);
+        cursor = {};
     }
 
-    return pCell->GetEntity(coord);
+    return bWritten;
+}
+
+void cpp_conv::EntityLookupGrid::EraseFootprint(const Footprint& footprint)
+{
+    const auto [min, max] = getFootprintBounds(footprint.m_Position, footprint.m_Size);
+    EraseSpans(min, max, std::numeric_limits<size_t>::max());
+}
+
+void cpp_conv::EntityLookupGrid::EraseSpans(const Eigen::Vector3i& min, const Eigen::Vector3i& max, size_t uiSpanCount)
+{
+    bool bReleasedChunk = false;
+
+    ForEachChunkRow(min, max, [this, &bReleasedChunk, &uiSpanCount](const ChunkKey& key, const Eigen::Vector3i& rowStart, const RowMask mask)
+    {
+        if (uiSpanCount-- == 0)
+        {
+            return false;
+        }
+
+        const auto it = m_Chunks.find(key);
+        assert(it != m_Chunks.end());
+
+        Chunk& rChunk = *it->second;
+        RowMask& rRow = rChunk.m_OccupiedRows[rowStart.z() & (c_iChunkSize - 1)];
+        assert((rRow & mask) == mask);
+        rRow &= ~mask;
+
+        for (RowMask remaining = mask; remaining != 0; remaining &= remaining - 1)
+        {
+            const int32_t iBit = std::countr_zero(remaining);
+            rChunk.m_Slots[ToSlotIndex(rowStart + Eigen::Vector3i{iBit, 0, 0})] = atlas::scene::EntityId::Invalid();
+        }
+
+        rChunk.m_uiOccupiedSlots -= static_cast<uint32_t>(std::popcount(mask));
+        if (rChunk.m_uiOccupiedSlots == 0)
+        {
+            m_Chunks.erase(it);
+            bReleasedChunk = true;
+        }
+
+        return true;
+    });
+
+    // A released chunk may still be remembered by some thread's lookup cache.
+    if (bReleasedChunk)
+    {
+        m_uiCacheGeneration = g_uiNextCacheGeneration++;
+    }
 }
 
 bool cpp_conv::EntityLookupGrid::PlaceEntity(Eigen::Vector3i position, Eigen::Vector3i size,
                                              atlas::scene::EntityId entity)
 {
-    if (!ValidateCanPlaceEntity(position, size, entity))
+    if (m_Footprints.contains(entity) || !isValidSize(size))
+    {
+        return false;
+    }
+
+    const Footprint footprint{position, size};
+    ChunkCursor cursor;
+    if (!TryWriteFootprint(footprint, entity, cursor))
     {
         return false;
     }
 
-    for (int32_t iXPosition = position.x() - size.x() / 2; iXPosition < (position.x() + (size.x() + 1) / 2); ++iXPosition)
+    m_Footprints.emplace(entity, footprint);
+    return true;
+}
+
+std::vector<atlas::scene::EntityId> cpp_conv::EntityLookupGrid::PlaceEntities(const std::vector<Placement>& vPlacements)
+{
+    m_Footprints.reserve(m_Footprints.size() + vPlacements.size());
+
+    // Places the entries in the given order, and returns whether all of them went in.
+    std::vector<atlas::scene::EntityId> vRejected;
+    std::vector<uint32_t> vPlaced;
+    const auto placeInOrder = [this, &vPlacements, &vRejected, &vPlaced](const auto& order)
     {
-        for (int32_t iYPosition = position.z() - size.z() / 2; iYPosition < (position.z() + (size.z() + 1) / 2); ++iYPosition)
+        ChunkCursor cursor;
+        for (const uint32_t uiIndex : order)
         {
-            for (int32_t iDepthPosition = position.y(); iDepthPosition < position.y() + size.y(); ++iDepthPosition)
+            const Placement& placement = vPlacements[uiIndex];
+            const Footprint footprint{placement.m_Position, placement.m_Size};
+            if (!isValidSize(placement.m_Size) || !m_Footprints.try_emplace(placement.m_Entity, footprint).second)
             {
-                CellCoordinate coord = ToCellSpace({iXPosition, iDepthPosition, iYPosition});
-                assert(!coord.IsInvalid());
-
-                Cell* pCell = GetOrCreateCell(coord);
-                assert(pCell != nullptr);
+                vRejected.push_back(placement.m_Entity);
+                continue;
+            }
 
-                assert(pCell->SetEntity(coord, entity));
+            if (!TryWriteFootprint(footprint, placement.m_Entity, cursor))
+            {
+                m_Footprints.erase(placement.m_Entity);
+                vRejected.push_back(placement.m_Entity);
+                continue;
             }
+
+            vPlaced.push_back(uiIndex);
         }
+
+        return vRejected.empty();
+    };
+
+    // Sweep in chunk order so that consecutive placements land in the chunk just written, and each chunk is looked up
+    // once rather than once per entity.
+    const auto getSortKey = [&vPlacements](const uint32_t uiIndex)
+    {
+        const Placement& placement = vPlacements[uiIndex];
+        const Eigen::Vector3i min = getFootprintBounds(placement.m_Position, placement.m_Size).first;
+        const ChunkKey key = ToChunkKey(min);
+        return std::tuple{key.m_iFloor, key.m_iY, key.m_iX, min.z(), min.x(), uiIndex};
+    };
+
+    std::vector<uint32_t> vSweepOrder(vPlacements.size());
+    std::iota(vSweepOrder.begin(), vSweepOrder.end(), 0u);
+    std::ranges::sort(vSweepOrder, {}, getSortKey);
+
+    if (placeInOrder(vSweepOrder))
+    {
+        return vRejected;
     }
 
+    // Something collided, and the sweep may have picked a different survivor than placing in map order would have.
+    // Take the batch back out and place it again in map order. A valid map loaded into an empty grid never gets here.
+    for (const uint32_t uiIndex : vPlaced)
+    {
+        const auto it = m_Footprints.find(vPlacements[uiIndex].m_Entity);
+        EraseFootprint(it->second);
+        m_Footprints.erase(it);
+    }
+
+    vRejected.clear();
+    vPlaced.clear();
+    placeInOrder(std::views::iota(0u, static_cast<uint32_t>(vPlacements.size())));
+    return vRejected;
+}
+
+bool cpp_conv::EntityLookupGrid::RemoveEntity(const atlas::scene::EntityId entity)
+{
+    const auto it = m_Footprints.find(entity);
+    if (it == m_Footprints.end())
+    {
+        return false;
+    }
+
+    EraseFootprint(it->second);
+    m_Footprints.erase(it);
     return true;
 }
 
-bool cpp_conv::EntityLookupGrid::ValidateCanPlaceEntity(Eigen::Vector3i position, Eigen::Vector3i size,
-                                                        atlas::scene::EntityId pEntity) const
+bool cpp_conv::EntityLookupGrid::MoveEntity(const atlas::scene::EntityId entity, const Eigen::Vector3i position)
 {
-    if (size.x() <= 0 || size.y() <= 0 || size.z() <= 0)
+    const auto it = m_Footprints.find(entity);
+    if (it == m_Footprints.end())
     {
         return false;
     }
 
-    for (int32_t iXPosition = position.x() - size.x() / 2; iXPosition < (position.x() + (size.x() + 1) / 2); ++iXPosition)
+    return MoveEntity(entity, position, it->second.m_Size);
+}
+
+bool cpp_conv::EntityLookupGrid::MoveEntity(const atlas::scene::EntityId entity, const Eigen::Vector3i position,
+                                            const Eigen::Vector3i size)
+{
+    const auto it = m_Footprints.find(entity);
+    if (it == m_Footprints.end())
     {
-        for (int32_t iYPosition = position.z() - size.z() / 2; iYPosition < (position.z() + (size.z() + 1) / 2); ++iYPosition)
-        {
-            for (int32_t iDepthPosition = position.y(); iDepthPosition < position.y() + size.y(); ++iDepthPosition)
-            {
-                const Eigen::Vector3i checkPosition = {iXPosition, iDepthPosition, iYPosition};
-                CellCoordinate coord = ToCellSpace(checkPosition);
-                if (coord.IsInvalid())
-                {
-                    return false;
-                }
+        return false;
+    }
 
-                const Cell* pCell = GetCell(coord);
-                if (!pCell)
-                {
-                    continue;
-                }
+    // Lift the entity out first so that it does not collide with itself.
+    const Footprint previous = it->second;
+    EraseFootprint(previous);
 
-                if (pCell->GetEntity(coord).IsValid())
-                {
-                    return false;
-                }
-            }
-        }
+    const Footprint footprint{position, size};
+    ChunkCursor cursor;
+    if (!isValidSize(size) || !TryWriteFootprint(footprint, entity, cursor))
+    {
+        WriteFootprint(previous, entity);
+        return false;
     }
 
+    it->second = footprint;
     return true;
 }
 
-cpp_conv::EntityLookupGrid::Cell* cpp_conv::EntityLookupGrid::GetCell(const CellCoordinate coord) const
+bool cpp_conv::EntityLookupGrid::ValidateCanPlaceEntity(Eigen::Vector3i position, Eigen::Vector3i size,
+                                                        atlas::scene::EntityId pEntity) const
 {
-    if (coord.IsInvalid())
+    if (!isValidSize(size))
     {
-        return nullptr;
+        return false;
     }
 
-    return m_EntityLookupGrid[coord.m_CellY][coord.m_CellX].get();
+    const auto [min, max] = getFootprintBounds(position, size);
+    return IsRegionEmpty(min, max - Eigen::Vector3i::Ones());
 }
 
-cpp_conv::EntityLookupGrid::Cell* cpp_conv::EntityLookupGrid::GetOrCreateCell(const CellCoordinate coord)
+bool cpp_conv::EntityLookupGrid::IsRegionEmpty(const Eigen::Vector3i min, const Eigen::Vector3i max) const
 {
-    if (coord.IsInvalid())
+    return ForEachChunkRow(min, max + Eigen::Vector3i::Ones(), [this](const ChunkKey& key, const Eigen::Vector3i& rowStart, const RowMask mask)
     {
-        return nullptr;
-    }
+        const Chunk* pChunk = FindChunk(key);
+        return !pChunk || (pChunk->m_OccupiedRows[rowStart.z() & (c_iChunkSize - 1)] & mask) == 0;
+    });
+}
 
-    if (!m_EntityLookupGrid[coord.m_CellY][coord.m_CellX])
+std::vector<atlas::scene::EntityId> cpp_conv::EntityLookupGrid::GetEntitiesInRegion(const Eigen::Vector3i min,
+                                                                                     const Eigen::Vector3i max) const
+{
+    std::vector<atlas::scene::EntityId> vEntities;
+    ForEachChunkRow(min, max + Eigen::Vector3i::Ones(), [this, &vEntities](const ChunkKey& key, const Eigen::Vector3i& rowStart, const RowMask mask)
+    {
+        const Chunk* pChunk = FindChunk(key);
+        if (!pChunk)
+        {
+            return true;
+        }
+
+        for (RowMask remaining = pChunk->m_OccupiedRows[rowStart.z() & (c_iChunkSize - 1)] & mask; remaining != 0; remaining &= remaining - 1)
+        {
+            const int32_t iBit = std::countr_zero(remaining);
+            vEntities.push_back(pChunk->m_Slots[ToSlotIndex(rowStart + Eigen::Vector3i{iBit, 0, 0})]);
+        }
+
+        return true;
+    });
+
+    // Entities larger than a tile show up once per covered slot.
+    std::ranges::sort(vEntities);
+    const auto [first, last] = std::ranges::unique(vEntities);
+    vEntities.erase(first, last);
+    return vEntities;
+}
+
+std::vector<Eigen::Vector3i> cpp_conv::EntityLookupGrid::GetChunkOrigins() const
+{
+    std::vector<Eigen::Vector3i> vOrigins;
+    vOrigins.reserve(m_Chunks.size());
+    for (const auto& key : m_Chunks | std::views::keys)
     {
-        m_EntityLookupGrid[coord.m_CellY][coord.m_CellX] = std::make_unique<Cell>();
+        vOrigins.emplace_back(key.m_iX << c_iChunkShift, key.m_iFloor, key.m_iY << c_iChunkShift);
     }
 
-    return m_EntityLookupGrid[coord.m_CellY][coord.m_CellX].get();
+    return vOrigins;
 }
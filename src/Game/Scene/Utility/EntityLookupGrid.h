@@ -2,66 +2,157 @@
 #include <array>
 #include <cstdint>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 #include "Conveyor.h"
+#include "Enums.h"
 #include "AtlasScene/ECS/Entity.h"
 #include "Eigen/Core"
 
 namespace cpp_conv
 {
+    // Sparse position -> entity lookup. The world is split into square chunks per floor, allocated on first placement
+    // and found through a hash of their coordinate, so coordinates and floors are unbounded and memory follows the
+    // built area. Slots within a chunk are Morton ordered to keep neighbouring tiles close together in memory, and each
+    // chunk row keeps an occupancy bitmask so footprint and region checks test a whole row span at once.
     class EntityLookupGrid
     {
     public:
-        static inline constexpr int32_t c_uiMaximumMapSize = 128;
-        static inline constexpr int32_t c_uiCellSize = 64;
-        static inline constexpr int32_t c_uiMaximumLevel = 4;
+        static inline constexpr int32_t c_iChunkShift = 5;
+        static inline constexpr int32_t c_iChunkSize = 1 << c_iChunkShift;
+        static inline constexpr int32_t c_iChunkSlotCount = c_iChunkSize * c_iChunkSize;
 
-        struct CellCoordinate
+        // The entities surrounding a position, relative to a facing direction. Up and down are the floors above and below.
+        struct Neighbourhood
         {
-            int32_t m_CellX;
-            int32_t m_CellY;
-            int32_t m_CellSlotX;
-            int32_t m_CellSlotY;
-            int32_t m_Depth;
+            atlas::scene::EntityId m_Forward;
+            atlas::scene::EntityId m_Back;
+            atlas::scene::EntityId m_Left;
+            atlas::scene::EntityId m_Right;
+            atlas::scene::EntityId m_Up;
+            atlas::scene::EntityId m_Down;
 
-            [[nodiscard]] bool IsInvalid() const;
+            [[nodiscard]] atlas::scene::EntityId Get(const RelativeDirection direction) const
+            {
+                switch (direction)
+                {
+                case RelativeDirection::Forward: return m_Forward;
+                case RelativeDirection::Backwards: return m_Back;
+                case RelativeDirection::Right: return m_Right;
+                case RelativeDirection::Left: return m_Left;
+                }
+                return atlas::scene::EntityId::Invalid();
+            }
         };
 
-        struct Cell
+        // One entity of a bulk placement.
+        struct Placement
         {
-            using GridRow = std::array<atlas::scene::EntityId, c_uiCellSize>;
-            using EntityGrid = std::array<GridRow, c_uiCellSize>;
-            using CellFloors = std::array<std::unique_ptr<EntityGrid>, c_uiMaximumLevel>;
-
-            CellFloors m_CellGrid;
-            bool m_bHasFloors = false;
-
-            [[nodiscard]] bool HasFloor(uint32_t uiFloor) const;
-            bool CreateFloor(uint32_t uiFloor);
-            EntityGrid& GetFloor(uint32_t uiFloor);
-            [[nodiscard]] const EntityGrid& GetFloor(uint32_t uiFloor) const;
-            [[nodiscard]] atlas::scene::EntityId GetEntity(CellCoordinate coord) const;
-            bool SetEntity(CellCoordinate coord, atlas::scene::EntityId entity);
+            Eigen::Vector3i m_Position;
+            Eigen::Vector3i m_Size;
+            atlas::scene::EntityId m_Entity;
         };
 
-    public:
-        static CellCoordinate ToCellSpace(Eigen::Vector3i position);
+        EntityLookupGrid();
+        EntityLookupGrid(const EntityLookupGrid&) = delete;
+        EntityLookupGrid& operator=(const EntityLookupGrid&) = delete;
 
         [[nodiscard]] atlas::scene::EntityId GetEntity(Eigen::Vector3i position) const;
-        [[nodiscard]] Cell* GetCell(CellCoordinate coord) const;
+        [[nodiscard]] Neighbourhood GetNeighbourhood(Eigen::Vector3i position, Direction direction) const;
 
         bool PlaceEntity(Eigen::Vector3i position, Eigen::Vector3i size, atlas::scene::EntityId entity);
+        // Places a batch of entities in one sweep ordered by chunk, for loading large numbers of them at once. Entries
+        // that are already placed, or that overlap the grid or an earlier entry of the batch, are skipped and returned.
+        // Overlaps are resolved as if the entries were placed one at a time in the given order.
+        std::vector<atlas::scene::EntityId> PlaceEntities(const std::vector<Placement>& vPlacements);
+        bool RemoveEntity(atlas::scene::EntityId entity);
+        // Relocates a placed entity, optionally with a new size (e.g. after a rotation). The entity's own footprint does
+        // not block the destination. On failure the entity stays where it was.
+        bool MoveEntity(atlas::scene::EntityId entity, Eigen::Vector3i position);
+        bool MoveEntity(atlas::scene::EntityId entity, Eigen::Vector3i position, Eigen::Vector3i size);
         bool ValidateCanPlaceEntity(Eigen::Vector3i position, Eigen::Vector3i size,
                                     atlas::scene::EntityId entity) const;
 
+        // Region bounds are inclusive on every axis.
+        [[nodiscard]] bool IsRegionEmpty(Eigen::Vector3i min, Eigen::Vector3i max) const;
+        // Each entity overlapping the region is returned once, in entity id order.
+        [[nodiscard]] std::vector<atlas::scene::EntityId> GetEntitiesInRegion(Eigen::Vector3i min, Eigen::Vector3i max) const;
+
+        [[nodiscard]] size_t GetChunkCount() const { return m_Chunks.size(); }
+        // The minimum corner of every chunk that holds an entity, in no particular order.
+        [[nodiscard]] std::vector<Eigen::Vector3i> GetChunkOrigins() const;
+        [[nodiscard]] size_t GetEntityCount() const { return m_Footprints.size(); }
+
     private:
-        using CellPtr = std::unique_ptr<Cell>;
-        using EntityLookupGridRow = std::array<CellPtr, c_uiMaximumMapSize>;
-        using EntityLookupGridStore = std::array<EntityLookupGridRow, c_uiMaximumMapSize>;
+        struct ChunkKey
+        {
+            int32_t m_iX;
+            int32_t m_iY;
+            int32_t m_iFloor;
+
+            bool operator==(const ChunkKey& other) const = default;
+        };
+
+        struct ChunkKeyHash
+        {
+            size_t operator()(const ChunkKey& key) const;
+        };
+
+        // Where an entity was placed, so it can be lifted back out without searching the grid.
+        struct Footprint
+        {
+            Eigen::Vector3i m_Position;
+            Eigen::Vector3i m_Size;
+        };
+
+        struct EntityIdHash
+        {
+            size_t operator()(const atlas::scene::EntityId& entity) const { return std::hash<uint64_t>{}(entity.m_Value); }
+        };
+
+        using RowMask = uint32_t;
+        static_assert(c_iChunkSize <= sizeof(RowMask) * 8, "A chunk row must fit in a row mask");
+
+        struct Chunk
+        {
+            std::array<atlas::scene::EntityId, c_iChunkSlotCount> m_Slots;
+            // Bit x of row y is set when the slot at local (x, y) holds an entity.
+            std::array<RowMask, c_iChunkSize> m_OccupiedRows{};
+            uint32_t m_uiOccupiedSlots = 0;
+        };
+
+        // The chunk last written through, so that runs of writes into the same chunk skip the hash lookup.
+        struct ChunkCursor
+        {
+            ChunkKey m_Key{};
+            Chunk* m_pChunk = nullptr;
+        };
+
+        // World x/z map to the chunk plane, world y to the floor.
+        static ChunkKey ToChunkKey(const Eigen::Vector3i& position);
+        static uint32_t ToSlotIndex(const Eigen::Vector3i& position);
+
+        // Splits the half-open box [min, max) into spans of chunk rows and calls back with (key, world position of the
+        // row's first slot, mask of the span) until the callback returns false.
+        template <typename TCallback>
+        static bool ForEachChunkRow(const Eigen::Vector3i& min, const Eigen::Vector3i& max, TCallback&& callback);
+
+        [[nodiscard]] const Chunk* FindChunk(const ChunkKey& key) const;
+        Chunk& GetOrCreateChunk(const ChunkKey& key);
+        Chunk& GetOrCreateChunk(const ChunkKey& key, ChunkCursor& cursor);
 
-        Cell* GetOrCreateCell(CellCoordinate coord);
+        // Writes a footprint known to fit.
+        void WriteFootprint(const Footprint& footprint, atlas::scene::EntityId entity);
+        // Writes the footprint unless it overlaps something, checking and writing each row in the same pass.
+        bool TryWriteFootprint(const Footprint& footprint, atlas::scene::EntityId entity, ChunkCursor& cursor);
+        void EraseFootprint(const Footprint& footprint);
+        // Clears the first uiSpanCount spans ForEachChunkRow visits in [min, max).
+        void EraseSpans(const Eigen::Vector3i& min, const Eigen::Vector3i& max, size_t uiSpanCount);
 
-        bool m_bSuppressAssess = false;
+        std::unordered_map<ChunkKey, std::unique_ptr<Chunk>, ChunkKeyHash> m_Chunks;
+        std::unordered_map<atlas::scene::EntityId, Footprint, EntityIdHash> m_Footprints;
 
-        EntityLookupGridStore m_EntityLookupGrid;
+        // Identifies this grid's chunk set to the per-thread lookup cache; changes whenever a chunk could have gone away.
+        uint64_t m_uiCacheGeneration;
     };
 }
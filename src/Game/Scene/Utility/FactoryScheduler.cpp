@@ -0,0 +1,20 @@
+#include "FactoryScheduler.h"
+
+void cpp_conv::FactoryScheduler::Reset(const uint64_t uiTick)
+{
+    m_Wheel.Reset(uiTick);
+
+    std::lock_guard lock(m_WakeMutex);
+    m_vPendingWakes.clear();
+}
+
+void cpp_conv::FactoryScheduler::Schedule(const atlas::scene::EntityId entity, const uint64_t uiTick)
+{
+    m_Wheel.Schedule(uiTick, entity);
+}
+
+void cpp_conv::FactoryScheduler::Wake(const atlas::scene::EntityId entity)
+{
+    std::lock_guard lock(m_WakeMutex);
+    m_vPendingWakes.push_back(entity);
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "TimerWheel.h"
+#include "AtlasScene/ECS/Entity.h"
+
+namespace cpp_conv
+{
+    // Decides which factories need to be visited on a given tick. Factories with a known completion time sit in the
+    // timer wheel, while starved or blocked factories are parked and only come back when something calls Wake for them.
+    class FactoryScheduler
+    {
+    public:
+        [[nodiscard]] uint64_t GetCurrentTick() const { return m_Wheel.GetCurrentTick(); }
+
+        // Drops all timers and wake requests and continues from the given tick. Not safe to call alongside Wake.
+        void Reset(uint64_t uiTick);
+
+        void Schedule(atlas::scene::EntityId entity, uint64_t uiTick);
+
+        // Requests that the factory is visited on the next tick, e.g. because an input arrived or an output freed up.
+        // Safe to call from any thread.
+        void Wake(atlas::scene::EntityId entity);
+
+        // Advances a tick and invokes callback(EntityId, uint64_t uiScheduledTick) for each due timer, then
+        // callback(EntityId, c_uiWakeTick) for each wake request. Stale or duplicate entries are left to the caller.
+        template <typename TCallback>
+        void Advance(TCallback&& callback)
+        {
+            m_Wheel.Advance([&callback](const TimerWheel<atlas::scene::EntityId>::Timer& timer)
+            {
+                callback(timer.m_Value, timer.m_uiTick);
+            });
+
+            {
+                std::lock_guard lock(m_WakeMutex);
+                m_vProcessingWakes.swap(m_vPendingWakes);
+            }
+
+            // Wakes can be filed from several threads, so they are put into a stable order before being handed out.
+            std::sort(m_vProcessingWakes.begin(), m_vProcessingWakes.end());
+            for (const atlas::scene::EntityId entity : m_vProcessingWakes)
+            {
+                callback(entity, c_uiWakeTick);
+            }
+
+            m_vProcessingWakes.clear();
+        }
+
+        static constexpr uint64_t c_uiWakeTick = 0;
+
+    private:
+        TimerWheel<atlas::scene::EntityId> m_Wheel;
+        std::mutex m_WakeMutex;
+        std::vector<atlas::scene::EntityId> m_vPendingWakes;
+        std::vector<atlas::scene::EntityId> m_vProcessingWakes;
+    };
+}
@@ -1,6 +1,8 @@
 #include "GeneralItemContainer.h"
-#include <map>
-#include "AtlasResource/AssetPtr.h"
+#include <algorithm>
+#include <cassert>
+#include <format>
+#include <limits>
 #include "DataId.h"
 #include "ItemDefinition.h"
 #include "ItemRegistry.h"
@@ -10,10 +12,9 @@ cpp_conv::GeneralItemContainer::GeneralItemContainer(
     const uint32_t uiMaxCapacity,
     const uint32_t uiMaxStackSize,
     const bool bUniqueStacksOnly)
-    : m_uiMaxCapacity(uiMaxCapacity)
-      , m_uiMaxStackSize(uiMaxStackSize)
-      , m_bUniqueStacksOnly(bUniqueStacksOnly)
+    : GeneralItemContainer()
 {
+    Initialise(uiMaxCapacity, uiMaxStackSize, bUniqueStacksOnly);
 }
 
 void cpp_conv::GeneralItemContainer::Initialise(const uint32_t uiMaxCapacity, const uint32_t uiMaxStackSize, const bool bUniqueStacksOnly)
@@ -21,207 +22,177 @@ void cpp_conv::GeneralItemContainer::Initialise(const uint32_t uiMaxCapacity, co
     m_uiMaxCapacity = uiMaxCapacity;
     m_uiMaxStackSize = uiMaxStackSize;
     m_bUniqueStacksOnly = bUniqueStacksOnly;
+    m_uiStackCount = 0;
+
+    const uint32_t uiItemIndexCount = resources::getItemIndexCount();
+    m_vItemCounts.assign(uiItemIndexCount, 0);
+    m_vStoredItemSlots.assign(uiItemIndexCount, c_uiNotStored);
+
+    m_vStoredItems.clear();
+    m_vStoredItems.reserve(std::min(uiMaxCapacity, uiItemIndexCount));
 }
 
-bool cpp_conv::GeneralItemContainer::TryTake(bool bSingle, std::tuple<ItemId, uint32_t>& outItem)
+bool cpp_conv::GeneralItemContainer::TryTake(const bool bSingle, std::tuple<ItemIndex, uint32_t>& outItem)
 {
-    if (m_vItemEntries.empty())
+    if (m_vStoredItems.empty())
     {
         return false;
     }
 
-    uint32_t uiCount = 1;
-    if (bSingle)
-    {
-        uiCount = m_vItemEntries[0].m_pCount;
-    }
+    const ItemIndex item = m_vStoredItems.front();
+    const uint32_t uiCount = bSingle ? 1 : std::min(GetItemCount(item), m_uiMaxStackSize);
 
-    outItem = std::make_tuple(m_vItemEntries[0].m_pItem, m_vItemEntries[0].m_pCount);
+    outItem = std::make_tuple(item, uiCount);
+    return TryTake(item, uiCount);
+}
 
-    m_vItemEntries[0].m_pCount -= uiCount;
-    if (m_vItemEntries[0].m_pCount == 0)
+bool cpp_conv::GeneralItemContainer::TryTake(const ItemIndex item, const uint32_t count /*= 1*/)
+{
+    if (item.IsEmpty() || !IsTracked(item) || !HasItems(item, count))
     {
-        m_vItemEntries.erase(m_vItemEntries.begin());
+        return false;
     }
 
+    SetItemCount(item, m_vItemCounts[item.m_uiIndex] - count);
     return true;
 }
 
-bool cpp_conv::GeneralItemContainer::TryTake(ItemId item, uint32_t count /*= 1*/)
+bool cpp_conv::GeneralItemContainer::TryInsert(const ItemIndex pItem, const uint32_t count)
 {
-    if (!HasItems(item, count))
+    PROFILE_FUNC();
+    if (!CouldInsert(pItem, count))
     {
         return false;
     }
 
-    auto itItems = m_vItemEntries.begin();
-    while (itItems != m_vItemEntries.end())
-    {
-        if (itItems->m_pItem != item)
-        {
-            ++itItems;
-            continue;
-        }
-
-        if (itItems->m_pCount >= count)
-        {
-            itItems->m_pCount -= count;
-            return true;
-        }
-
-        count -= itItems->m_pCount;
-        itItems = m_vItemEntries.erase(itItems);
-    }
-
-    return false;
+    SetItemCount(pItem, m_vItemCounts[pItem.m_uiIndex] + count);
+    return true;
 }
 
-bool cpp_conv::GeneralItemContainer::TryInsert(ItemId pItem, uint32_t count)
+bool cpp_conv::GeneralItemContainer::CouldInsert(const ItemIndex pItem, const uint32_t count /*= 1*/) const
 {
-    PROFILE_FUNC();
-    if (!CouldInsert(pItem, count))
+    if (pItem.IsEmpty() || !IsTracked(pItem) || m_uiMaxStackSize == 0)
     {
         return false;
     }
 
-    for (auto& rItemEntry : m_vItemEntries)
+    const uint32_t uiCurrentCount = m_vItemCounts[pItem.m_uiIndex];
+    const uint32_t uiNewCount = uiCurrentCount + count;
+    if (m_bUniqueStacksOnly && uiNewCount > m_uiMaxStackSize)
     {
-        if (rItemEntry.m_pItem == pItem)
-        {
-            if ((rItemEntry.m_pCount + count) < m_uiMaxStackSize)
-            {
-                rItemEntry.m_pCount += count;
-                return true;
-            }
-
-            const uint32_t uiSpace = m_uiMaxStackSize - rItemEntry.m_pCount;
-            count -= uiSpace;
-            rItemEntry.m_pCount += uiSpace;
-        }
+        return false;
     }
 
-    const uint32_t remainingFullStacks = count / m_uiMaxStackSize;
-    uint32_t remainingPartialStack = count % m_uiMaxStackSize;
+    const uint32_t uiExtraStacks = GetStacksForCount(uiNewCount) - GetStacksForCount(uiCurrentCount);
+    return (m_uiStackCount + uiExtraStacks) <= m_uiMaxCapacity;
+}
 
-    for (uint32_t i = 0; i < remainingFullStacks; i++)
+uint32_t cpp_conv::GeneralItemContainer::GetInsertableCount(const ItemIndex item) const
+{
+    if (item.IsEmpty() || !IsTracked(item) || m_uiMaxStackSize == 0)
     {
-        m_vItemEntries.emplace_back(pItem, m_uiMaxStackSize);
+        return 0;
     }
 
-    if (remainingPartialStack != 0)
+    const uint32_t uiCurrentCount = m_vItemCounts[item.m_uiIndex];
+    const uint32_t uiHeldStacks = GetStacksForCount(uiCurrentCount);
+    const uint32_t uiFreeStacks = m_uiStackCount < m_uiMaxCapacity ? m_uiMaxCapacity - m_uiStackCount : 0;
+
+    // Room left in the item's last, partially filled stack
+    const uint32_t uiPartialRoom = uiHeldStacks * m_uiMaxStackSize - uiCurrentCount;
+    if (m_bUniqueStacksOnly)
     {
-        m_vItemEntries.emplace_back(pItem, remainingPartialStack);
+        return uiHeldStacks == 0 && uiFreeStacks > 0 ? m_uiMaxStackSize : uiPartialRoom;
     }
 
-    return true;
+    const uint64_t uiInsertable = uiPartialRoom + static_cast<uint64_t>(uiFreeStacks) * m_uiMaxStackSize;
+    return static_cast<uint32_t>(std::min<uint64_t>(uiInsertable, std::numeric_limits<uint32_t>::max()));
 }
 
-bool cpp_conv::GeneralItemContainer::CouldInsert(ItemId pItem, uint32_t count /*= 1*/)
+bool cpp_conv::GeneralItemContainer::HasItems(const ItemIndex item, const uint32_t count) const
 {
-    bool bIsMet = true;
-    for (auto& rItem : m_vItemEntries)
-    {
-        if (rItem.m_pItem == pItem)
-        {
-            if ((rItem.m_pCount + count) > m_uiMaxStackSize)
-            {
-                if (m_bUniqueStacksOnly)
-                {
-                    bIsMet = false;
-                    break;
-                }
-
-                count -= m_uiMaxStackSize - rItem.m_pCount;
-            }
-            else
-            {
-                return true;
-            }
-        }
-    }
+    return GetItemCount(item) >= count;
+}
 
-    if (!bIsMet)
+bool cpp_conv::GeneralItemContainer::IsEmpty() const
+{
+    return m_vStoredItems.empty();
+}
+
+uint32_t cpp_conv::GeneralItemContainer::GetItemCount(const ItemIndex item) const
+{
+    if (!IsTracked(item))
     {
-        return false;
+        return 0;
     }
 
-    const uint32_t extraSlotsRequired = count / m_uiMaxStackSize + ((count % m_uiMaxStackSize) == 0 ? 0 : 1);
-    return (m_vItemEntries.size() + extraSlotsRequired) <= m_uiMaxCapacity;
+    return m_vItemCounts[item.m_uiIndex];
 }
 
-bool cpp_conv::GeneralItemContainer::HasItems(ItemId item, uint32_t count)
+uint32_t cpp_conv::GeneralItemContainer::GetStacksForCount(const uint32_t uiCount) const
 {
-    PROFILE_FUNC();
-    for (auto& rItemEntry : m_vItemEntries)
+    if (m_uiMaxStackSize == 0)
     {
-        if (rItemEntry.m_pItem != item)
-        {
-            continue;
-        }
-
-        if (rItemEntry.m_pCount >= count)
-        {
-            return true;
-        }
-
-        if (!m_bUniqueStacksOnly)
-        {
-            count -= rItemEntry.m_pCount;
-        }
-        else
-        {
-            return false;
-        }
+        return 0;
     }
 
-    return false;
+    return (uiCount + m_uiMaxStackSize - 1) / m_uiMaxStackSize;
 }
 
-bool cpp_conv::GeneralItemContainer::IsEmpty() const
+void cpp_conv::GeneralItemContainer::SetItemCount(const ItemIndex item, const uint32_t uiCount)
 {
-    return m_vItemEntries.empty();
+    assert(IsTracked(item) && !item.IsEmpty());
+
+    uint32_t& uiCurrentCount = m_vItemCounts[item.m_uiIndex];
+    m_uiStackCount = m_uiStackCount - GetStacksForCount(uiCurrentCount) + GetStacksForCount(uiCount);
+
+    uint16_t& uiSlot = m_vStoredItemSlots[item.m_uiIndex];
+    if (uiCurrentCount == 0 && uiCount != 0)
+    {
+        uiSlot = static_cast<uint16_t>(m_vStoredItems.size());
+        m_vStoredItems.push_back(item);
+    }
+    else if (uiCurrentCount != 0 && uiCount == 0)
+    {
+        // Swap-remove, keeping the moved entry's slot up to date
+        const ItemIndex lastItem = m_vStoredItems.back();
+        m_vStoredItems[uiSlot] = lastItem;
+        m_vStoredItemSlots[lastItem.m_uiIndex] = uiSlot;
+        m_vStoredItems.pop_back();
+        uiSlot = c_uiNotStored;
+    }
+
+    uiCurrentCount = uiCount;
 }
 
 std::string cpp_conv::GeneralItemContainer::GetDescription() const
 {
-    std::map<ItemId, int> storedItems;
+    std::vector<ItemIndex> vSortedItems = m_vStoredItems;
+    std::sort(vSortedItems.begin(), vSortedItems.end());
 
-    for (const ItemEntry& itemEntry : m_vItemEntries)
+    std::string str = "";
+    bool bFirst = true;
+    for (const ItemIndex item : vSortedItems)
     {
-        ItemId item = itemEntry.m_pItem;
-        if (!item.IsEmpty())
+        if (bFirst)
         {
-            storedItems.try_emplace(item, 0);
-            storedItems[item] += itemEntry.m_pCount;
+            bFirst = false;
+        }
+        else
+        {
+            str += ", ";
         }
-    }
 
-    std::string str = "";
-    bool bFirst = true;
-    if (!storedItems.empty())
-    {
-        for (auto& item : storedItems)
+        const ItemDefinition* pItem = resources::getItemDefinition(item);
+        if (pItem)
+        {
+            str += std::format("{} {}", GetItemCount(item), pItem->GetName());
+        }
+        else
         {
-            if (bFirst)
-            {
-                bFirst = false;
-            }
-            else
-            {
-                str += ", ";
-            }
-
-            atlas::resource::AssetPtr<ItemDefinition> pItem = resources::getItemDefinition(item.first);
-            if (pItem)
-            {
-                str += std::format("{} {}", item.second, pItem->GetName());
-            }
-            else
-            {
-                str += std::format("{} Unknown Items", item.second);
-            }
+            str += std::format("{} Unknown Items", GetItemCount(item));
         }
     }
 
-    return std::format("{}/{} - {}", m_vItemEntries.size(), m_uiMaxCapacity, str);
+    return std::format("{}/{} - {}", m_uiStackCount, m_uiMaxCapacity, str);
 }
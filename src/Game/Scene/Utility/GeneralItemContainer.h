@@ -2,10 +2,15 @@
 #include "DataId.h"
 
 #include <cstdint>
+#include <string>
+#include <tuple>
 #include <vector>
 
 namespace cpp_conv
 {
+    // Item container tracked as per-item totals rather than individual stacks. Stacks are always considered fully
+    // compacted, so the number of stacks an item occupies is derived from its total. All queries and mutations are O(1)
+    // and allocation free; the per-item tables are sized once from the item registry when the container is initialised.
     class GeneralItemContainer
     {
     public:
@@ -13,26 +18,25 @@ namespace cpp_conv
             : m_uiMaxCapacity{0}
             , m_uiMaxStackSize{0}
             , m_bUniqueStacksOnly{false}
+            , m_uiStackCount{0}
         {
         }
         GeneralItemContainer(uint32_t uiMaxCapacity, uint32_t uiMaxStackSize, bool bUniqueStacksOnly);
         void Initialise(uint32_t uiMaxCapacity, uint32_t uiMaxStackSize, bool bUniqueStacksOnly);
 
-        struct ItemEntry
-        {
-            ItemId m_pItem;
-            uint32_t m_pCount;
-        };
+        bool TryTake(bool bSingle, std::tuple<ItemIndex, uint32_t>& outItem);
+        bool TryTake(ItemIndex item, uint32_t count = 1);
+        bool TryInsert(ItemIndex pItem, uint32_t count = 1);
+        [[nodiscard]] bool CouldInsert(ItemIndex pItem, uint32_t count = 1) const;
+        [[nodiscard]] uint32_t GetInsertableCount(ItemIndex item) const;
+        [[nodiscard]] bool HasItems(ItemIndex item, uint32_t count = 1) const;
+        [[nodiscard]] bool IsEmpty() const;
 
-        bool TryTake(bool bSingle, std::tuple<ItemId, uint32_t>& outItem);
-        bool TryTake(ItemId item, uint32_t count = 1);
-        bool TryInsert(ItemId pItem, uint32_t count = 1);
-        bool CouldInsert(ItemId pItem, uint32_t count = 1);
-        bool HasItems(ItemId item, uint32_t count = 1);
-        bool IsEmpty() const;
+        [[nodiscard]] uint32_t GetItemCount(ItemIndex item) const;
+        [[nodiscard]] uint32_t GetStackCount() const { return m_uiStackCount; }
 
-        std::vector<ItemEntry>& GetItems() { return m_vItemEntries; }
-        [[nodiscard]] const std::vector<ItemEntry>& GetItems() const { return m_vItemEntries; }
+        // The distinct items currently held, in no particular order.
+        [[nodiscard]] const std::vector<ItemIndex>& GetStoredItems() const { return m_vStoredItems; }
 
         [[nodiscard]] std::string GetDescription() const;
 
@@ -41,10 +45,22 @@ namespace cpp_conv
         [[nodiscard]] bool OnlyAllowsUniqueStacks() const { return m_bUniqueStacksOnly; }
 
     private:
+        static constexpr uint16_t c_uiNotStored = 0xFFFF;
+
+        [[nodiscard]] bool IsTracked(ItemIndex item) const { return item.m_uiIndex < m_vItemCounts.size(); }
+        [[nodiscard]] uint32_t GetStacksForCount(uint32_t uiCount) const;
+        void SetItemCount(ItemIndex item, uint32_t uiCount);
+
         uint32_t m_uiMaxCapacity;
         uint32_t m_uiMaxStackSize;
         bool m_bUniqueStacksOnly;
 
-        std::vector<ItemEntry> m_vItemEntries;
+        uint32_t m_uiStackCount;
+
+        // Both indexed by ItemIndex
+        std::vector<uint32_t> m_vItemCounts;
+        std::vector<uint16_t> m_vStoredItemSlots;
+
+        std::vector<ItemIndex> m_vStoredItems;
     };
 }
@@ -1,10 +1,12 @@
 #include "ItemPassingUtility.h"
+#include <algorithm>
 #include <AtlasScene/ECS/Components/EcsManager.h>
 
 #include "ConveyorComponent.h"
 #include "ConveyorHelper.h"
 #include "DirectionComponent.h"
 #include "FactoryComponent.h"
+#include "ItemInputStaging.h"
 #include "StorageComponent.h"
 #include "WorldEntityInformationComponent.h"
 #include "AtlasGame/Scene/Components/PositionComponent.h"
@@ -143,7 +145,7 @@ bool tryInsertItemConveyor(
     const cpp_conv::EntityLookupGrid& grid,
     const atlas::scene::EntityId sourceEntity,
     const atlas::scene::EntityId targetEntity,
-    const cpp_conv::ItemId& itemId,
+    const cpp_conv::ItemIndex& item,
     const std::optional<int> sourceChannel = {},
     const std::optional<Eigen::Vector2f>& sourcePosition = {})
 {
@@ -175,40 +177,66 @@ bool tryInsertItemConveyor(
         pTargetChannel->m_ChannelLane,
         forwardTargetItemSlot,
         {
-            itemId,
+            item,
             sourcePosition
         });
     return true;
 }
 
-bool tryInsertItemFactory(
+// Each channel only has a single entry slot, so a batch can place at most one item per channel. Items only ever
+// enter the lane they come from; sources that are not on a lane are offered every lane in turn from iFirstChannel.
+uint32_t tryInsertItemsConveyor(
     atlas::scene::EcsManager& ecs,
     const cpp_conv::EntityLookupGrid& grid,
     const atlas::scene::EntityId sourceEntity,
     const atlas::scene::EntityId targetEntity,
-    const cpp_conv::ItemId& itemId,
-    std::optional<int> sourceChannel,
-    const std::optional<Eigen::Vector2f>& startPosition)
+    const cpp_conv::ItemIndex& item,
+    const uint32_t uiCount,
+    const std::optional<int> sourceChannel,
+    const std::optional<Eigen::Vector2f>& sourcePosition,
+    const int iFirstChannel = 0)
 {
-    return false;
+    if (sourceChannel.has_value())
+    {
+        return tryInsertItemConveyor(ecs, grid, sourceEntity, targetEntity, item, sourceChannel, sourcePosition) ? 1 : 0;
+    }
+
+    uint32_t uiInserted = 0;
+    for (int iChannel = 0; iChannel < cpp_conv::components::c_conveyorChannels && uiInserted < uiCount; ++iChannel)
+    {
+        const int channel = (iFirstChannel + iChannel) % cpp_conv::components::c_conveyorChannels;
+        if (tryInsertItemConveyor(ecs, grid, sourceEntity, targetEntity, item, channel, sourcePosition))
+        {
+            uiInserted++;
+        }
+    }
+
+    return uiInserted;
 }
 
-bool tryInsertItemStorage(
+// The target's container is only read here; items are pushed to its staging and moved across when the target drains
+// it in its own update. Entities without staging take the items directly.
+uint32_t stageItems(
     atlas::scene::EcsManager& ecs,
-    const cpp_conv::EntityLookupGrid& grid,
-    const atlas::scene::EntityId sourceEntity,
     const atlas::scene::EntityId targetEntity,
-    const cpp_conv::ItemId& itemId,
-    std::optional<int> sourceChannel,
-    const std::optional<Eigen::Vector2f>& startPosition)
+    cpp_conv::GeneralItemContainer& container,
+    const cpp_conv::ItemIndex& item,
+    const uint32_t uiCount)
 {
-    auto& storage = ecs.GetComponent<cpp_conv::components::StorageComponent>(targetEntity);
-    if (!storage.m_ItemContainer.TryInsert(itemId))
+    const uint32_t uiAccepted = std::min(uiCount, container.GetInsertableCount(item));
+    if (uiAccepted == 0)
     {
-        return false;
+        return 0;
     }
 
-    return true;
+    if (ecs.DoesEntityHaveComponent<cpp_conv::components::ItemInputStaging>(targetEntity))
+    {
+        auto& staging = ecs.GetComponent<cpp_conv::components::ItemInputStaging>(targetEntity);
+        return staging.TryPush(item, uiAccepted) ? uiAccepted : 0;
+    }
+
+    container.TryInsert(item, uiAccepted);
+    return uiAccepted;
 }
 
 bool cpp_conv::item_passing_utility::entitySupportsInsertion(
@@ -226,24 +254,66 @@ bool cpp_conv::item_passing_utility::tryInsertItem(
     const EntityLookupGrid& grid,
     const atlas::scene::EntityId sourceEntity,
     const atlas::scene::EntityId targetEntity,
-    const ItemId itemId,
+    const ItemIndex item,
+    const std::optional<int> sourceChannel,
+    const std::optional<Eigen::Vector2f> startPosition)
+{
+    if (ecs.DoesEntityHaveComponent<components::ConveyorComponent>(targetEntity))
+    {
+        return !item.IsEmpty() && tryInsertItemConveyor(ecs, grid, sourceEntity, targetEntity, item, sourceChannel, startPosition);
+    }
+
+    return tryInsertItems(ecs, grid, sourceEntity, targetEntity, item, 1, sourceChannel, startPosition) == 1;
+}
+
+uint32_t cpp_conv::item_passing_utility::tryInsertItems(
+    atlas::scene::EcsManager& ecs,
+    const EntityLookupGrid& grid,
+    const atlas::scene::EntityId sourceEntity,
+    const atlas::scene::EntityId targetEntity,
+    const ItemIndex item,
+    const uint32_t uiCount,
     const std::optional<int> sourceChannel,
     const std::optional<Eigen::Vector2f> startPosition)
 {
+    if (uiCount == 0 || item.IsEmpty())
+    {
+        return 0;
+    }
+
     if (ecs.DoesEntityHaveComponent<components::ConveyorComponent>(targetEntity))
     {
-        return tryInsertItemConveyor(ecs, grid, sourceEntity, targetEntity, itemId, sourceChannel, startPosition);
+        return tryInsertItemsConveyor(ecs, grid, sourceEntity, targetEntity, item, uiCount, sourceChannel, startPosition);
     }
 
     if (ecs.DoesEntityHaveComponent<components::FactoryComponent>(targetEntity))
     {
-        return tryInsertItemFactory(ecs, grid, sourceEntity, targetEntity, itemId, sourceChannel, startPosition);
+        auto& factory = ecs.GetComponent<components::FactoryComponent>(targetEntity);
+        return stageItems(ecs, targetEntity, factory.m_InputItems, item, uiCount);
     }
 
     if (ecs.DoesEntityHaveComponent<components::StorageComponent>(targetEntity))
     {
-        return tryInsertItemStorage(ecs, grid, sourceEntity, targetEntity, itemId, sourceChannel, startPosition);
+        auto& storage = ecs.GetComponent<components::StorageComponent>(targetEntity);
+        return stageItems(ecs, targetEntity, storage.m_ItemContainer, item, uiCount);
+    }
+
+    return 0;
+}
+
+uint32_t cpp_conv::item_passing_utility::tryInsertItemsFromAnyChannel(
+    atlas::scene::EcsManager& ecs,
+    const EntityLookupGrid& grid,
+    const atlas::scene::EntityId sourceEntity,
+    const atlas::scene::EntityId targetEntity,
+    const ItemIndex item,
+    const uint32_t uiCount,
+    const int iFirstChannel)
+{
+    if (uiCount != 0 && !item.IsEmpty() && ecs.DoesEntityHaveComponent<components::ConveyorComponent>(targetEntity))
+    {
+        return tryInsertItemsConveyor(ecs, grid, sourceEntity, targetEntity, item, uiCount, {}, {}, iFirstChannel);
     }
 
-    return false;
+    return tryInsertItems(ecs, grid, sourceEntity, targetEntity, item, uiCount, {}, {});
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+#include <optional>
 #include <AtlasScene/ECS/Entity.h>
 #include "DataId.h"
 #include "Eigen/Core"
@@ -25,7 +27,31 @@ namespace cpp_conv::item_passing_utility
         const EntityLookupGrid& grid,
         atlas::scene::EntityId sourceEntity,
         atlas::scene::EntityId targetEntity,
-        ItemId itemId,
+        ItemIndex item,
         std::optional<int> sourceChannel,
         std::optional<Eigen::Vector2f> startPosition);
+
+    // Moves up to uiCount items of one type into the target, returning how many were accepted. Conveyors take at most
+    // one item, into the lane matching sourceChannel; storage and factories take as much of the batch as their
+    // containers can hold.
+    uint32_t tryInsertItems(
+        atlas::scene::EcsManager& ecs,
+        const EntityLookupGrid& grid,
+        atlas::scene::EntityId sourceEntity,
+        atlas::scene::EntityId targetEntity,
+        ItemIndex item,
+        uint32_t uiCount,
+        std::optional<int> sourceChannel,
+        std::optional<Eigen::Vector2f> startPosition);
+
+    // As tryInsertItems, for sources that are not on a lane, such as factory outputs. Conveyors take one item per free
+    // lane, offered in turn from iFirstChannel.
+    uint32_t tryInsertItemsFromAnyChannel(
+        atlas::scene::EcsManager& ecs,
+        const EntityLookupGrid& grid,
+        atlas::scene::EntityId sourceEntity,
+        atlas::scene::EntityId targetEntity,
+        ItemIndex item,
+        uint32_t uiCount,
+        int iFirstChannel);
 }
@@ -0,0 +1,283 @@
+#include "MapLoadJob.h"
+
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <system_error>
+
+#include "Autosaver.h"
+#include "BinaryMap.h"
+#include "Constants.h"
+#include "ConveyorComponent.h"
+#include "ConveyorStateDeterminationSystem.h"
+#include "SequenceFormationSystem.h"
+#include "AtlasGame/Scene/Components/PositionComponent.h"
+
+namespace
+{
+    std::filesystem::path getTopologyCachePath(const uint64_t uiLayoutHash)
+    {
+        return std::filesystem::path{cpp_conv::constants::topology_cache::c_szDirectory} /
+            std::format("{:016x}.cptp", uiLayoutHash);
+    }
+
+    std::vector<uint8_t> readFile(const std::filesystem::path& path)
+    {
+        std::ifstream input(path, std::ios::binary);
+        if (!input)
+        {
+            return {};
+        }
+
+        return {std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+    }
+}
+
+cpp_conv::MapLoadJob::MapLoadJob(const atlas::resource::BundleRegistryId mapId)
+    : m_MapId{mapId}
+    , m_Worker{[this](const std::stop_token& stopToken) { Run(stopToken); }}
+{
+}
+
+cpp_conv::MapLoadJob::MapLoadJob(std::filesystem::path savePath)
+    : m_MapId{}
+    , m_SavePath{std::move(savePath)}
+    , m_Worker{[this](const std::stop_token& stopToken) { Run(stopToken); }}
+{
+}
+
+void cpp_conv::MapLoadJob::Update()
+{
+    if (GetStage() != Stage::LoadingModels)
+    {
+        return;
+    }
+
+    {
+        std::scoped_lock lock{m_ModelsMutex};
+        if (m_bModelsLoaded)
+        {
+            return;
+        }
+    }
+
+    // The worker is parked until this is done, so the map is safe to read.
+    m_Models = entity_construction::loadMapModels(*m_pMap);
+
+    {
+        std::scoped_lock lock{m_ModelsMutex};
+        m_bModelsLoaded = true;
+    }
+
+    m_ModelsLoaded.notify_all();
+}
+
+float cpp_conv::MapLoadJob::GetProgress() const
+{
+    const Stage stage = GetStage();
+    if (stage == Stage::Failed)
+    {
+        return 0.0f;
+    }
+
+    return static_cast<float>(stage) / static_cast<float>(Stage::Complete);
+}
+
+const char* cpp_conv::MapLoadJob::GetStageName(const Stage stage)
+{
+    switch (stage)
+    {
+    case Stage::LoadingMap: return "Loading map";
+    case Stage::LoadingModels: return "Loading models";
+    case Stage::ConstructingEntities: return "Constructing entities";
+    case Stage::DeterminingConveyorState: return "Determining conveyor state";
+    case Stage::FormingSequences: return "Forming conveyor sequences";
+    case Stage::RestoringSimulation: return "Restoring simulation";
+    case Stage::Complete: return "Complete";
+    case Stage::Failed: return "Failed";
+    }
+
+    return "";
+}
+
+std::shared_ptr<cpp_conv::PreparedGameState> cpp_conv::MapLoadJob::TakeState()
+{
+    if (GetStage() != Stage::Complete)
+    {
+        return nullptr;
+    }
+
+    return std::move(m_pState);
+}
+
+void cpp_conv::MapLoadJob::Run(const std::stop_token& stopToken)
+{
+    if (!m_SavePath.empty())
+    {
+        if (!LoadSaveGame())
+        {
+            SetStage(Stage::Failed);
+            return;
+        }
+    }
+    else
+    {
+        m_pMap = atlas::resource::ResourceLoader::LoadAssetUncached<resources::Map>(m_MapId);
+    }
+
+    if (!m_pMap)
+    {
+        std::cerr << "Failed to load map\n";
+        SetStage(Stage::Failed);
+        return;
+    }
+
+    // Text maps are converted once here, so that loading models and construction share the same columns.
+    if (!m_pMap->GetBinaryView())
+    {
+        m_pMap->AdoptBinaryData(resources::writeBinaryMap(*m_pMap), nullptr);
+    }
+
+    SetStage(Stage::LoadingModels);
+    if (!WaitForModels(stopToken))
+    {
+        return;
+    }
+
+    SetStage(Stage::ConstructingEntities);
+    auto pState = std::make_shared<PreparedGameState>();
+    pState->m_pLookupGrid = std::make_unique<EntityLookupGrid>();
+    entity_construction::constructMapEntities(pState->m_Ecs, *pState->m_pLookupGrid, *m_pMap, m_Models);
+    const uint64_t uiLayoutHash = topology::hashLayout(m_pMap->GetBinaryData());
+    m_pMap.reset();
+
+    if (stopToken.stop_requested())
+    {
+        return;
+    }
+
+    // The same work the systems would otherwise do in their Initialise on entering the scene, unless it was done for
+    // this layout before. Saves carry the corner state of their conveyors, and maps keep their whole topology in a
+    // cache beside the game.
+    SetStage(Stage::DeterminingConveyorState);
+    const bool bTopologyApplied = ApplyTopology(
+        *pState,
+        m_SaveGame ? m_SaveGame->m_vTopologyData : readFile(getTopologyCachePath(uiLayoutHash)),
+        uiLayoutHash);
+    if (!bTopologyApplied)
+    {
+        ConveyorStateDeterminationSystem{*pState->m_pLookupGrid}.Initialise(pState->m_Ecs);
+    }
+
+    if (stopToken.stop_requested())
+    {
+        return;
+    }
+
+    if (m_SaveGame)
+    {
+        // The save's sequences are rebuilt as they were, so they are not formed again.
+        SetStage(Stage::RestoringSimulation);
+        std::string errors;
+        if (!save_game::restoreSimulationState(*m_SaveGame, pState->m_Ecs, *pState->m_pLookupGrid, &errors))
+        {
+            std::cerr << errors;
+            SetStage(Stage::Failed);
+            return;
+        }
+
+        pState->m_uiTick = m_SaveGame->m_uiTick;
+        m_SaveGame.reset();
+    }
+    else if (!bTopologyApplied)
+    {
+        SetStage(Stage::FormingSequences);
+        SequenceFormationSystem{*pState->m_pLookupGrid}.Initialise(pState->m_Ecs);
+        WriteTopologyCache(pState->m_Ecs, uiLayoutHash);
+    }
+
+    m_pState = std::move(pState);
+    SetStage(Stage::Complete);
+}
+
+bool cpp_conv::MapLoadJob::LoadSaveGame()
+{
+    std::ifstream input(m_SavePath, std::ios::binary);
+    if (!input)
+    {
+        std::cerr << std::format("Could not open {}\n", m_SavePath.string());
+        return false;
+    }
+
+    const std::vector<uint8_t> vData{std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+
+    std::string errors;
+    m_SaveGame = save_game::isAutosave(vData)
+        ? save_game::readAutosave(vData, &errors)
+        : save_game::readSaveGame(vData, &errors);
+    if (!m_SaveGame)
+    {
+        std::cerr << errors;
+        return false;
+    }
+
+    // The layout loads like any other binary map.
+    atlas::resource::AssetPtr<resources::Map> pMap{new resources::Map()};
+    if (!pMap->AdoptBinaryData(std::move(m_SaveGame->m_vMapData), &errors))
+    {
+        std::cerr << errors;
+        return false;
+    }
+
+    m_pMap = std::move(pMap);
+    return true;
+}
+
+bool cpp_conv::MapLoadJob::ApplyTopology(
+    PreparedGameState& state,
+    const std::span<const uint8_t> data,
+    const uint64_t uiLayoutHash)
+{
+    if (data.empty())
+    {
+        return false;
+    }
+
+    std::string errors;
+    const std::optional<topology::Topology> recorded = topology::decodeTopology(data, uiLayoutHash, &errors);
+    const size_t uiConveyorCount = state.m_Ecs.GetEntitiesWithComponents<
+        atlas::game::scene::components::PositionComponent, components::ConveyorComponent>().size();
+    if (!recorded ||
+        recorded->m_vConveyors.size() != uiConveyorCount ||
+        !topology::applyTopology(*recorded, state.m_Ecs, *state.m_pLookupGrid, &errors))
+    {
+        // Only a nuisance, as the topology is determined from scratch instead.
+        std::cerr << errors;
+        return false;
+    }
+
+    return true;
+}
+
+void cpp_conv::MapLoadJob::WriteTopologyCache(atlas::scene::EcsManager& ecs, const uint64_t uiLayoutHash)
+{
+    const std::vector<uint8_t> vData = topology::encodeTopology(topology::captureTopology(ecs, true), uiLayoutHash);
+
+    // A cache that cannot be written costs the next load some time, and nothing more.
+    std::error_code error;
+    std::filesystem::create_directories(constants::topology_cache::c_szDirectory, error);
+    std::ofstream output(getTopologyCachePath(uiLayoutHash), std::ios::binary);
+    output.write(reinterpret_cast<const char*>(vData.data()), static_cast<std::streamsize>(vData.size()));
+}
+
+bool cpp_conv::MapLoadJob::WaitForModels(const std::stop_token& stopToken)
+{
+    std::unique_lock lock{m_ModelsMutex};
+    return m_ModelsLoaded.wait(lock, stopToken, [this] { return m_bModelsLoaded; });
+}
+
+void cpp_conv::MapLoadJob::SetStage(const Stage stage)
+{
+    m_Stage.store(stage, std::memory_order_release);
+}
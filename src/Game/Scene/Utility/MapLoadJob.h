@@ -0,0 +1,91 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <thread>
+
+#include "EntityConstruction.h"
+#include "EntityLookupGrid.h"
+#include "Map.h"
+#include "SaveGame.h"
+#include "AtlasResource/AssetPtr.h"
+#include "AtlasResource/ResourceLoader.h"
+#include "AtlasScene/ECS/Components/EcsManager.h"
+
+namespace cpp_conv
+{
+    // The simulation state of a freshly loaded map or save, for a GameScene to take over.
+    struct PreparedGameState
+    {
+        atlas::scene::EcsManager m_Ecs;
+        std::unique_ptr<EntityLookupGrid> m_pLookupGrid;
+        uint64_t m_uiTick = 0;
+    };
+
+    // Loads a map or a save game and builds its simulation state on a worker thread, so that the caller can keep
+    // rendering. The only step that runs on the main thread is loading the entities' models, which Update performs
+    // when the worker reaches it.
+    class MapLoadJob
+    {
+    public:
+        enum class Stage
+        {
+            LoadingMap,
+            LoadingModels,
+            ConstructingEntities,
+            DeterminingConveyorState,
+            FormingSequences,
+            RestoringSimulation,
+            Complete,
+            Failed
+        };
+
+        explicit MapLoadJob(atlas::resource::BundleRegistryId mapId);
+        explicit MapLoadJob(std::filesystem::path savePath);
+        MapLoadJob(const MapLoadJob&) = delete;
+        MapLoadJob& operator=(const MapLoadJob&) = delete;
+
+        // Runs the main thread's share of the load. Call once per frame.
+        void Update();
+
+        [[nodiscard]] Stage GetStage() const { return m_Stage.load(std::memory_order_acquire); }
+        // The fraction of stages finished, from 0 to 1.
+        [[nodiscard]] float GetProgress() const;
+        [[nodiscard]] static const char* GetStageName(Stage stage);
+
+        // Hands over the state once the job is complete. Returns null before then, and after it has been taken.
+        std::shared_ptr<PreparedGameState> TakeState();
+
+    private:
+        void Run(const std::stop_token& stopToken);
+        bool LoadSaveGame();
+        // Applies a previously determined topology of the layout, if it is usable, in place of determining it again.
+        static bool ApplyTopology(PreparedGameState& state, std::span<const uint8_t> data, uint64_t uiLayoutHash);
+        static void WriteTopologyCache(atlas::scene::EcsManager& ecs, uint64_t uiLayoutHash);
+        bool WaitForModels(const std::stop_token& stopToken);
+        void SetStage(Stage stage);
+
+        atlas::resource::BundleRegistryId m_MapId;
+        // Set when loading a save game rather than a map.
+        std::filesystem::path m_SavePath;
+        std::atomic<Stage> m_Stage{Stage::LoadingMap};
+
+        atlas::resource::AssetPtr<resources::Map> m_pMap;
+        std::optional<save_game::SaveGame> m_SaveGame;
+        // Kept until the job is destroyed on the main thread, so that no model is released on the worker.
+        entity_construction::MapModels m_Models;
+        std::shared_ptr<PreparedGameState> m_pState;
+
+        std::mutex m_ModelsMutex;
+        std::condition_variable_any m_ModelsLoaded;
+        bool m_bModelsLoaded = false;
+
+        // Declared last so that it is stopped and joined before anything the worker uses is destroyed.
+        std::jthread m_Worker;
+    };
+}
@@ -0,0 +1,984 @@
+#include "SaveGame.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <format>
+#include <string_view>
+
+#include "BinaryMap.h"
+#include "ConveyorComponent.h"
+#include "DirectionComponent.h"
+#include "EntityLookupGrid.h"
+#include "FactoryComponent.h"
+#include "ItemInputStaging.h"
+#include "ItemRegistry.h"
+#include "PositionHelper.h"
+#include "SequenceComponent.h"
+#include "SequenceFormationSystem.h"
+#include "StorageComponent.h"
+#include "Topology.h"
+#include "WorldEntityInformationComponent.h"
+#include "AtlasGame/Scene/Components/PositionComponent.h"
+#include "AtlasScene/ECS/Components/EcsManager.h"
+
+namespace
+{
+    using namespace cpp_conv::components;
+    using namespace cpp_conv::save_game;
+    using atlas::game::scene::components::PositionComponent;
+    using atlas::scene::EcsManager;
+    using atlas::scene::EntityId;
+    using cpp_conv::ItemIndex;
+    using Entry = SimulationSnapshot::Entry;
+
+    class RecordWriter
+    {
+    public:
+        RecordWriter(std::vector<uint8_t>& vData, ItemPalette& palette)
+            : m_vData{vData}
+            , m_Palette{palette}
+        {
+        }
+
+        template <typename TValue>
+        void Write(const TValue& value)
+        {
+            const size_t uiOffset = m_vData.size();
+            m_vData.resize(uiOffset + sizeof(TValue));
+            std::memcpy(m_vData.data() + uiOffset, &value, sizeof(TValue));
+        }
+
+        void WritePosition(const Eigen::Vector3i& position)
+        {
+            Write(position.x());
+            Write(position.y());
+            Write(position.z());
+        }
+
+        void WriteItem(const ItemIndex item) { Write(m_Palette.GetIndex(item)); }
+
+        // Writes the next uiCount of the given entries, advancing rIndex past them.
+        void WriteEntries(const std::vector<Entry>& vEntries, size_t& rIndex, const uint16_t uiCount)
+        {
+            Write(uiCount);
+            for (uint16_t i = 0; i < uiCount; ++i)
+            {
+                const Entry& entry = vEntries[rIndex++];
+                WriteItem(entry.m_Item);
+                Write(entry.m_uiCount);
+            }
+        }
+
+    private:
+        std::vector<uint8_t>& m_vData;
+        ItemPalette& m_Palette;
+    };
+
+    // Reads fields until the first one that runs past the data, after which every read returns a default value and
+    // HasFailed reports it. Callers check once per record rather than per field.
+    class RecordReader
+    {
+    public:
+        RecordReader(const std::span<const uint8_t> data, const std::span<const ItemIndex> palette)
+            : m_Data{data}
+            , m_Palette{palette}
+        {
+        }
+
+        template <typename TValue>
+        TValue Read()
+        {
+            TValue value{};
+            if (m_bFailed || sizeof(TValue) > m_Data.size() - m_uiOffset)
+            {
+                m_bFailed = true;
+                return value;
+            }
+
+            std::memcpy(&value, m_Data.data() + m_uiOffset, sizeof(TValue));
+            m_uiOffset += sizeof(TValue);
+            return value;
+        }
+
+        Eigen::Vector3i ReadPosition()
+        {
+            const auto iX = Read<int32_t>();
+            const auto iY = Read<int32_t>();
+            const auto iZ = Read<int32_t>();
+            return {iX, iY, iZ};
+        }
+
+        ItemIndex ReadItem()
+        {
+            const auto uiIndex = Read<uint16_t>();
+            if (uiIndex == c_uiNoItem)
+            {
+                return ItemIndex::Empty();
+            }
+
+            if (uiIndex >= m_Palette.size())
+            {
+                m_bFailed = true;
+                return ItemIndex::Empty();
+            }
+
+            return m_Palette[uiIndex];
+        }
+
+        [[nodiscard]] bool HasFailed() const { return m_bFailed; }
+        [[nodiscard]] bool IsAtEnd() const { return m_uiOffset == m_Data.size(); }
+
+    private:
+        std::span<const uint8_t> m_Data;
+        std::span<const ItemIndex> m_Palette;
+        size_t m_uiOffset = 0;
+        bool m_bFailed = false;
+    };
+
+    uint16_t captureContainer(const cpp_conv::GeneralItemContainer& container, std::vector<Entry>& vOutEntries)
+    {
+        for (const ItemIndex item : container.GetStoredItems())
+        {
+            vOutEntries.push_back({item, container.GetItemCount(item)});
+        }
+
+        return static_cast<uint16_t>(container.GetStoredItems().size());
+    }
+
+    uint16_t captureStaged(const ItemInputStaging& staging, std::vector<Entry>& vOutEntries)
+    {
+        uint16_t uiCount = 0;
+        staging.ForEachPending([&](const ItemInputStaging::Entry& entry)
+        {
+            vOutEntries.push_back({entry.m_Item, entry.m_uiCount});
+            uiCount++;
+        });
+
+        return uiCount;
+    }
+
+    cpp_conv::resources::BinaryMapEntity captureLayoutEntity(EcsManager& ecs, const EntityId entity)
+    {
+        const auto& [information, position, direction] = ecs.GetComponents<
+            WorldEntityInformationComponent, PositionComponent, DirectionComponent>(entity);
+
+        cpp_conv::resources::BinaryMapEntity row{};
+        row.m_Kind = information.m_EntityKind;
+        row.m_Position = position.m_Position;
+        row.m_Size = {1, 1, 1};
+        row.m_uiDirection = static_cast<uint8_t>(direction.m_Direction);
+
+        if (ecs.DoesEntityHaveComponent<FactoryComponent>(entity))
+        {
+            const auto& factory = ecs.GetComponent<FactoryComponent>(entity);
+            row.m_uiDefinition = factory.m_Definition.m_uiItemId;
+            row.m_Size = factory.m_Size;
+        }
+        else if (ecs.DoesEntityHaveComponent<StorageComponent>(entity))
+        {
+            const auto& storage = ecs.GetComponent<StorageComponent>(entity);
+            row.m_uiCapacity = storage.m_ItemContainer.GetMaxCapacity();
+            row.m_uiStackSize = storage.m_ItemContainer.GetMaxStackSize();
+        }
+
+        return row;
+    }
+
+    // Sequences are captured from their tail conveyor, which is the only one a load can find them by.
+    void captureSequence(EcsManager& ecs, const EntityId entity, SimulationSnapshot& outSnapshot)
+    {
+        const auto& [position, conveyor] = ecs.GetComponents<PositionComponent, ConveyorComponent>(entity);
+        if (conveyor.m_Sequence.IsInvalid() ||
+            conveyor.m_SequenceIndex != 0 ||
+            !ecs.DoesEntityHaveComponent<SequenceComponent>(conveyor.m_Sequence))
+        {
+            return;
+        }
+
+        const auto& sequence = ecs.GetComponent<SequenceComponent>(conveyor.m_Sequence);
+        SimulationSnapshot::Sequence& captured = outSnapshot.m_vSequences.emplace_back();
+        captured.m_TailPosition = position.m_Position;
+        captured.m_uiCurrentTick = sequence.m_CurrentTick;
+        captured.m_uiLength = sequence.m_Length;
+        captured.m_uiFirstItem = static_cast<uint32_t>(outSnapshot.m_vSequenceItems.size());
+        for (size_t uiChannel = 0; uiChannel < sequence.m_RealizedStates.size(); ++uiChannel)
+        {
+            const SequenceComponent::RealizedState& state = sequence.m_RealizedStates[uiChannel];
+            captured.m_Lanes[uiChannel] = state.m_Lanes;
+            for (uint32_t i = 0; i < state.m_Items.GetSize(); ++i)
+            {
+                outSnapshot.m_vSequenceItems.push_back(state.m_Items.Peek(static_cast<int>(i)).m_Item);
+            }
+        }
+    }
+
+    void captureConveyor(EcsManager& ecs, const EntityId entity, SimulationSnapshot& outSnapshot)
+    {
+        const auto& [position, conveyor] = ecs.GetComponents<PositionComponent, ConveyorComponent>(entity);
+        SimulationSnapshot::Conveyor& captured = outSnapshot.m_vConveyors.emplace_back();
+        captured.m_Position = position.m_Position;
+        captured.m_uiCurrentTick = conveyor.m_CurrentTick;
+        for (size_t uiChannel = 0; uiChannel < conveyor.m_Channels.size(); ++uiChannel)
+        {
+            const ConveyorComponent::Channel& channel = conveyor.m_Channels[uiChannel];
+            captured.m_LaneLengths[uiChannel] = static_cast<uint8_t>(channel.m_LaneLength);
+            for (size_t uiSlot = 0; uiSlot < channel.m_pSlots.size(); ++uiSlot)
+            {
+                captured.m_Slots[uiChannel][uiSlot] = channel.m_pSlots[uiSlot].m_Item.m_Item;
+            }
+        }
+    }
+
+    void captureFactory(EcsManager& ecs, const EntityId entity, SimulationSnapshot& outSnapshot)
+    {
+        const auto& [position, factory, staging] = ecs.GetComponents<
+            PositionComponent, FactoryComponent, ItemInputStaging>(entity);
+        SimulationSnapshot::Factory& captured = outSnapshot.m_vFactories.emplace_back();
+        captured.m_Position = position.m_Position;
+        captured.m_uiProductionCompleteTick = factory.m_uiProductionCompleteTick;
+        captured.m_uiLastUpdateTick = factory.m_uiLastUpdateTick;
+        captured.m_bIsDemandSatisfied = factory.m_bIsDemandSatisfied;
+        captured.m_uiFirstEntry = static_cast<uint32_t>(outSnapshot.m_vEntries.size());
+        captured.m_uiInputCount = captureContainer(factory.m_InputItems, outSnapshot.m_vEntries);
+        captured.m_uiOutputCount = captureContainer(factory.m_OutputItems, outSnapshot.m_vEntries);
+        captured.m_uiStagedCount = captureStaged(staging, outSnapshot.m_vEntries);
+    }
+
+    void captureStorage(EcsManager& ecs, const EntityId entity, SimulationSnapshot& outSnapshot)
+    {
+        const auto& [position, storage, staging] = ecs.GetComponents<
+            PositionComponent, StorageComponent, ItemInputStaging>(entity);
+        SimulationSnapshot::Storage& captured = outSnapshot.m_vStorages.emplace_back();
+        captured.m_Position = position.m_Position;
+        captured.m_uiFirstEntry = static_cast<uint32_t>(outSnapshot.m_vEntries.size());
+        captured.m_uiStoredCount = captureContainer(storage.m_ItemContainer, outSnapshot.m_vEntries);
+        captured.m_uiStagedCount = captureStaged(staging, outSnapshot.m_vEntries);
+    }
+
+    // Items on a lane are stored in lane order, so neighbouring items of the same kind collapse into one run.
+    void writeLanes(
+        RecordWriter& writer,
+        const uint64_t uiLanes,
+        const std::span<const ItemIndex> items,
+        std::vector<std::pair<ItemIndex, uint8_t>>& vRuns)
+    {
+        vRuns.clear();
+        for (const ItemIndex item : items)
+        {
+            if (vRuns.empty() || !(vRuns.back().first == item))
+            {
+                vRuns.emplace_back(item, 0);
+            }
+
+            vRuns.back().second++;
+        }
+
+        writer.Write(uiLanes);
+        writer.Write(static_cast<uint8_t>(vRuns.size()));
+        for (const auto& [item, uiCount] : vRuns)
+        {
+            writer.WriteItem(item);
+            writer.Write(uiCount);
+        }
+    }
+
+    template <typename TGetKey>
+    std::map<BlockKey, RecordBlock> encodeBlocks(
+        const SimulationSnapshot& snapshot,
+        ItemPalette& palette,
+        TGetKey&& getKey)
+    {
+        std::map<BlockKey, RecordBlock> blocks;
+        std::vector<std::pair<ItemIndex, uint8_t>> vRuns;
+
+        for (const SimulationSnapshot::Sequence& sequence : snapshot.m_vSequences)
+        {
+            size_t uiItem = sequence.m_uiFirstItem;
+            RecordBlock& block = blocks[getKey(sequence.m_TailPosition)];
+            RecordWriter writer{block.m_vRecords, palette};
+            writer.WritePosition(sequence.m_TailPosition);
+            writer.Write(sequence.m_uiLength);
+            writer.Write(sequence.m_uiCurrentTick);
+            for (const uint64_t uiLanes : sequence.m_Lanes)
+            {
+                const auto uiCount = static_cast<size_t>(std::popcount(uiLanes));
+                writeLanes(writer, uiLanes, std::span{snapshot.m_vSequenceItems}.subspan(uiItem, uiCount), vRuns);
+                uiItem += uiCount;
+            }
+
+            block.m_uiSequenceCount++;
+        }
+
+        for (const SimulationSnapshot::Conveyor& conveyor : snapshot.m_vConveyors)
+        {
+            RecordBlock& block = blocks[getKey(conveyor.m_Position)];
+            RecordWriter writer{block.m_vRecords, palette};
+            writer.WritePosition(conveyor.m_Position);
+            writer.Write(conveyor.m_uiCurrentTick);
+            for (size_t uiChannel = 0; uiChannel < conveyor.m_Slots.size(); ++uiChannel)
+            {
+                writer.Write(conveyor.m_LaneLengths[uiChannel]);
+                for (uint8_t uiSlot = 0; uiSlot < conveyor.m_LaneLengths[uiChannel]; ++uiSlot)
+                {
+                    writer.WriteItem(conveyor.m_Slots[uiChannel][uiSlot]);
+                }
+            }
+
+            block.m_uiConveyorCount++;
+        }
+
+        for (const SimulationSnapshot::Factory& factory : snapshot.m_vFactories)
+        {
+            size_t uiEntry = factory.m_uiFirstEntry;
+            RecordBlock& block = blocks[getKey(factory.m_Position)];
+            RecordWriter writer{block.m_vRecords, palette};
+            writer.WritePosition(factory.m_Position);
+            writer.Write(factory.m_uiProductionCompleteTick);
+            writer.Write(factory.m_uiLastUpdateTick);
+            writer.Write(static_cast<uint8_t>(factory.m_bIsDemandSatisfied));
+            writer.WriteEntries(snapshot.m_vEntries, uiEntry, factory.m_uiInputCount);
+            writer.WriteEntries(snapshot.m_vEntries, uiEntry, factory.m_uiOutputCount);
+            writer.WriteEntries(snapshot.m_vEntries, uiEntry, factory.m_uiStagedCount);
+
+            block.m_uiFactoryCount++;
+        }
+
+        for (const SimulationSnapshot::Storage& storage : snapshot.m_vStorages)
+        {
+            size_t uiEntry = storage.m_uiFirstEntry;
+            RecordBlock& block = blocks[getKey(storage.m_Position)];
+            RecordWriter writer{block.m_vRecords, palette};
+            writer.WritePosition(storage.m_Position);
+            writer.WriteEntries(snapshot.m_vEntries, uiEntry, storage.m_uiStoredCount);
+            writer.WriteEntries(snapshot.m_vEntries, uiEntry, storage.m_uiStagedCount);
+
+            block.m_uiStorageCount++;
+        }
+
+        return blocks;
+    }
+
+    // Reads an entry list onto the end of vOutEntries and returns how many were kept. Items that no longer exist are
+    // dropped.
+    uint16_t readEntries(RecordReader& reader, std::vector<Entry>& vOutEntries)
+    {
+        uint16_t uiKept = 0;
+        const auto uiCount = reader.Read<uint16_t>();
+        for (uint16_t i = 0; i < uiCount && !reader.HasFailed(); ++i)
+        {
+            const ItemIndex item = reader.ReadItem();
+            const auto uiItemCount = reader.Read<uint32_t>();
+            if (!reader.HasFailed() && item.IsValid() && uiItemCount != 0)
+            {
+                vOutEntries.push_back({item, uiItemCount});
+                uiKept++;
+            }
+        }
+
+        return uiKept;
+    }
+
+    bool readLanes(
+        RecordReader& reader,
+        const uint8_t uiLength,
+        uint64_t& rOutLanes,
+        std::vector<ItemIndex>& vOutItems)
+    {
+        const auto uiLanes = reader.Read<uint64_t>();
+        const auto uiRunCount = reader.Read<uint8_t>();
+        const uint32_t uiLaneCount = uiLength * 2U;
+        if (reader.HasFailed() || (uiLaneCount < 64 && (uiLanes >> uiLaneCount) != 0))
+        {
+            return false;
+        }
+
+        // Each item takes the lowest lane not yet filled. Lanes whose item no longer exists are left empty.
+        rOutLanes = 0;
+        uint64_t uiUnfilledLanes = uiLanes;
+        for (uint8_t uiRun = 0; uiRun < uiRunCount; ++uiRun)
+        {
+            const ItemIndex item = reader.ReadItem();
+            const auto uiCount = reader.Read<uint8_t>();
+            for (uint8_t i = 0; i < uiCount; ++i)
+            {
+                if (uiUnfilledLanes == 0)
+                {
+                    return false;
+                }
+
+                const uint64_t uiLane = uiUnfilledLanes & (~uiUnfilledLanes + 1);
+                uiUnfilledLanes &= ~uiLane;
+                if (item.IsValid())
+                {
+                    rOutLanes |= uiLane;
+                    vOutItems.push_back(item);
+                }
+            }
+        }
+
+        return !reader.HasFailed() && uiUnfilledLanes == 0;
+    }
+
+    // The next uiCount of a snapshot's entries, advancing rIndex past them.
+    std::span<const Entry> takeEntries(const std::vector<Entry>& vEntries, size_t& rIndex, const uint16_t uiCount)
+    {
+        const std::span<const Entry> entries = std::span{vEntries}.subspan(rIndex, uiCount);
+        rIndex += uiCount;
+        return entries;
+    }
+
+    void restoreContainer(const std::span<const Entry> entries, cpp_conv::GeneralItemContainer& container)
+    {
+        for (const Entry& entry : entries)
+        {
+            const uint32_t uiStored = std::min(entry.m_uiCount, container.GetInsertableCount(entry.m_Item));
+            if (uiStored != 0)
+            {
+                container.TryInsert(entry.m_Item, uiStored);
+            }
+        }
+    }
+
+    void restoreStaged(const std::span<const Entry> entries, ItemInputStaging& staging)
+    {
+        for (const Entry& entry : entries)
+        {
+            staging.HoldBack({entry.m_Item, entry.m_uiCount});
+        }
+    }
+
+    // The conveyors of a sequence, found by walking forward from its tail.
+    bool traceSequence(
+        EcsManager& ecs,
+        const cpp_conv::EntityLookupGrid& grid,
+        Eigen::Vector3i position,
+        const uint8_t uiLength,
+        std::vector<EntityId>& vOutConveyors)
+    {
+        vOutConveyors.clear();
+        for (uint8_t i = 0; i < uiLength; ++i)
+        {
+            const EntityId entity = grid.GetEntity(position);
+            if (entity.IsInvalid() || !ecs.DoesEntityHaveComponents<DirectionComponent, ConveyorComponent>(entity))
+            {
+                return false;
+            }
+
+            const auto& [direction, conveyor] = ecs.GetComponents<DirectionComponent, ConveyorComponent>(entity);
+            if (conveyor.m_bIsCorner || conveyor.m_Sequence.IsValid())
+            {
+                return false;
+            }
+
+            vOutConveyors.push_back(entity);
+            position = cpp_conv::position_helper::getForwardPosition(position, direction.m_Direction);
+        }
+
+        return true;
+    }
+
+    template <typename... TComponents>
+    EntityId getEntityWith(EcsManager& ecs, const cpp_conv::EntityLookupGrid& grid, const Eigen::Vector3i& position)
+    {
+        const EntityId entity = grid.GetEntity(position);
+        if (entity.IsInvalid() || !ecs.DoesEntityHaveComponents<TComponents...>(entity))
+        {
+            return EntityId::Invalid();
+        }
+
+        return entity;
+    }
+}
+
+uint16_t cpp_conv::save_game::ItemPalette::GetIndex(const ItemIndex item)
+{
+    if (item.IsEmpty())
+    {
+        return c_uiNoItem;
+    }
+
+    if (item.m_uiIndex >= m_vPaletteIndices.size())
+    {
+        m_vPaletteIndices.resize(item.m_uiIndex + 1, c_uiNoItem);
+    }
+
+    uint16_t& rIndex = m_vPaletteIndices[item.m_uiIndex];
+    if (rIndex == c_uiNoItem)
+    {
+        rIndex = static_cast<uint16_t>(m_vItemIds.size());
+        m_vItemIds.push_back(resources::getItemId(item).m_uiItemId);
+        m_vItems.push_back(item);
+    }
+
+    return rIndex;
+}
+
+void cpp_conv::save_game::clearSnapshot(SimulationSnapshot& outSnapshot)
+{
+    outSnapshot.m_uiTick = 0;
+    outSnapshot.m_bHasLayout = false;
+    outSnapshot.m_vLayout.clear();
+    outSnapshot.m_Topology.m_vConveyors.clear();
+    outSnapshot.m_vSequences.clear();
+    outSnapshot.m_vSequenceItems.clear();
+    outSnapshot.m_vConveyors.clear();
+    outSnapshot.m_vFactories.clear();
+    outSnapshot.m_vStorages.clear();
+    outSnapshot.m_vEntries.clear();
+}
+
+void cpp_conv::save_game::captureSimulation(
+    atlas::scene::EcsManager& ecs,
+    const uint64_t uiTick,
+    const bool bIncludeLayout,
+    SimulationSnapshot& outSnapshot)
+{
+    clearSnapshot(outSnapshot);
+    outSnapshot.m_uiTick = uiTick;
+    outSnapshot.m_bHasLayout = bIncludeLayout;
+
+    if (bIncludeLayout)
+    {
+        for (const EntityId entity : ecs.GetEntitiesWithComponents<
+                 WorldEntityInformationComponent, PositionComponent, DirectionComponent>())
+        {
+            outSnapshot.m_vLayout.push_back(captureLayoutEntity(ecs, entity));
+        }
+    }
+
+    for (const EntityId entity : ecs.GetEntitiesWithComponents<PositionComponent, ConveyorComponent>())
+    {
+        if (bIncludeLayout)
+        {
+            outSnapshot.m_Topology.m_vConveyors.push_back(topology::captureConveyorState(ecs, entity));
+        }
+
+        captureSequence(ecs, entity, outSnapshot);
+    }
+
+    for (const EntityId entity : ecs.GetEntitiesWithComponents<
+             PositionComponent, ConveyorComponent, IndividuallyProcessableConveyorComponent>())
+    {
+        captureConveyor(ecs, entity, outSnapshot);
+    }
+
+    for (const EntityId entity : ecs.GetEntitiesWithComponents<PositionComponent, FactoryComponent, ItemInputStaging>())
+    {
+        captureFactory(ecs, entity, outSnapshot);
+    }
+
+    for (const EntityId entity : ecs.GetEntitiesWithComponents<PositionComponent, StorageComponent, ItemInputStaging>())
+    {
+        captureStorage(ecs, entity, outSnapshot);
+    }
+}
+
+void cpp_conv::save_game::captureEntities(
+    atlas::scene::EcsManager& ecs,
+    const std::span<const atlas::scene::EntityId> entities,
+    SimulationSnapshot& outSnapshot)
+{
+    outSnapshot.m_bHasLayout = true;
+    for (const EntityId entity : entities)
+    {
+        if (!ecs.DoesEntityHaveComponents<WorldEntityInformationComponent, PositionComponent, DirectionComponent>(entity))
+        {
+            continue;
+        }
+
+        outSnapshot.m_vLayout.push_back(captureLayoutEntity(ecs, entity));
+        if (ecs.DoesEntityHaveComponent<ConveyorComponent>(entity))
+        {
+            outSnapshot.m_Topology.m_vConveyors.push_back(topology::captureConveyorState(ecs, entity));
+            if (ecs.DoesEntityHaveComponent<IndividuallyProcessableConveyorComponent>(entity))
+            {
+                captureConveyor(ecs, entity, outSnapshot);
+            }
+            else
+            {
+                captureSequence(ecs, entity, outSnapshot);
+            }
+        }
+        else if (ecs.DoesEntityHaveComponents<FactoryComponent, ItemInputStaging>(entity))
+        {
+            captureFactory(ecs, entity, outSnapshot);
+        }
+        else if (ecs.DoesEntityHaveComponents<StorageComponent, ItemInputStaging>(entity))
+        {
+            captureStorage(ecs, entity, outSnapshot);
+        }
+    }
+}
+
+std::vector<cpp_conv::ItemIndex> cpp_conv::save_game::readItemPalette(const std::span<const uint8_t> data)
+{
+    std::vector<ItemIndex> vPalette;
+    vPalette.reserve(data.size() / sizeof(uint64_t));
+    for (size_t uiOffset = 0; uiOffset + sizeof(uint64_t) <= data.size(); uiOffset += sizeof(uint64_t))
+    {
+        uint64_t uiItemId;
+        std::memcpy(&uiItemId, data.data() + uiOffset, sizeof(uint64_t));
+        vPalette.push_back(resources::getItemIndex({uiItemId}));
+    }
+
+    return vPalette;
+}
+
+std::map<cpp_conv::save_game::BlockKey, cpp_conv::save_game::RecordBlock> cpp_conv::save_game::encodeRecordBlocks(
+    const SimulationSnapshot& snapshot,
+    ItemPalette& palette)
+{
+    return encodeBlocks(snapshot, palette, [](const Eigen::Vector3i& position)
+    {
+        return BlockKey{
+            position.x() >> EntityLookupGrid::c_iChunkShift,
+            position.z() >> EntityLookupGrid::c_iChunkShift,
+            position.y()};
+    });
+}
+
+std::vector<uint8_t> cpp_conv::save_game::writeSaveGame(const SimulationSnapshot& snapshot)
+{
+    ItemPalette palette;
+    std::map<BlockKey, RecordBlock> blocks = encodeBlocks(snapshot, palette, [](const Eigen::Vector3i&)
+    {
+        return BlockKey{};
+    });
+    const RecordBlock records = blocks.empty() ? RecordBlock{} : std::move(blocks.begin()->second);
+
+    const std::vector<uint8_t> vMapData = resources::writeBinaryMap(snapshot.m_vLayout);
+    const std::vector<uint8_t> vTopologyData = topology::encodeTopology(
+        snapshot.m_Topology,
+        topology::hashLayout(vMapData));
+
+    FileHeader header{};
+    header.m_Magic = c_Magic;
+    header.m_uiVersion = c_uiVersion;
+    header.m_uiTick = snapshot.m_uiTick;
+    header.m_uiMapSize = vMapData.size();
+    header.m_uiTopologySize = vTopologyData.size();
+    header.m_uiItemCount = static_cast<uint32_t>(palette.GetItemIds().size());
+    header.m_uiSequenceCount = records.m_uiSequenceCount;
+    header.m_uiConveyorCount = records.m_uiConveyorCount;
+    header.m_uiFactoryCount = records.m_uiFactoryCount;
+    header.m_uiStorageCount = records.m_uiStorageCount;
+
+    const std::vector<uint64_t>& vItemIds = palette.GetItemIds();
+    const size_t uiPaletteSize = vItemIds.size() * sizeof(uint64_t);
+    std::vector<uint8_t> vData(
+        sizeof(FileHeader) + uiPaletteSize + vMapData.size() + vTopologyData.size() + records.m_vRecords.size());
+    uint8_t* pWrite = vData.data();
+    std::memcpy(pWrite, &header, sizeof(FileHeader));
+    pWrite += sizeof(FileHeader);
+    std::memcpy(pWrite, vItemIds.data(), uiPaletteSize);
+    pWrite += uiPaletteSize;
+    std::memcpy(pWrite, vMapData.data(), vMapData.size());
+    pWrite += vMapData.size();
+    std::memcpy(pWrite, vTopologyData.data(), vTopologyData.size());
+    pWrite += vTopologyData.size();
+    std::memcpy(pWrite, records.m_vRecords.data(), records.m_vRecords.size());
+    return vData;
+}
+
+std::vector<uint8_t> cpp_conv::save_game::writeSaveGame(atlas::scene::EcsManager& ecs, const uint64_t uiTick)
+{
+    SimulationSnapshot snapshot;
+    captureSimulation(ecs, uiTick, true, snapshot);
+    return writeSaveGame(snapshot);
+}
+
+bool cpp_conv::save_game::isSaveGame(const std::span<const uint8_t> data)
+{
+    return data.size() >= c_Magic.size() && std::memcmp(data.data(), c_Magic.data(), c_Magic.size()) == 0;
+}
+
+std::optional<cpp_conv::save_game::SaveGame> cpp_conv::save_game::readSaveGame(
+    const std::span<const uint8_t> data,
+    std::string* pErrors)
+{
+    const auto fail = [pErrors](const std::string_view reason) -> std::optional<SaveGame>
+    {
+        if (pErrors)
+        {
+            *pErrors += std::format("Invalid save game: {}\n", reason);
+        }
+
+        return {};
+    };
+
+    if (!isSaveGame(data) || data.size() < sizeof(FileHeader))
+    {
+        return fail("bad header");
+    }
+
+    FileHeader header;
+    std::memcpy(&header, data.data(), sizeof(FileHeader));
+    if (header.m_uiVersion != c_uiVersion)
+    {
+        return fail(std::format("unsupported version {}", header.m_uiVersion));
+    }
+
+    std::span<const uint8_t> remaining = data.subspan(sizeof(FileHeader));
+    const uint64_t uiPaletteSize = uint64_t{header.m_uiItemCount} * sizeof(uint64_t);
+    if (uiPaletteSize > remaining.size() ||
+        header.m_uiMapSize > remaining.size() - uiPaletteSize ||
+        header.m_uiTopologySize > remaining.size() - uiPaletteSize - header.m_uiMapSize)
+    {
+        return fail("truncated");
+    }
+
+    SaveGame save;
+    save.m_uiTick = header.m_uiTick;
+    save.m_vItemPalette = readItemPalette(remaining.first(uiPaletteSize));
+
+    remaining = remaining.subspan(uiPaletteSize);
+    save.m_vMapData.assign(remaining.begin(), remaining.begin() + static_cast<ptrdiff_t>(header.m_uiMapSize));
+    remaining = remaining.subspan(header.m_uiMapSize);
+    save.m_vTopologyData.assign(remaining.begin(), remaining.begin() + static_cast<ptrdiff_t>(header.m_uiTopologySize));
+    remaining = remaining.subspan(header.m_uiTopologySize);
+
+    RecordBlock& block = save.m_vBlocks.emplace_back();
+    block.m_uiSequenceCount = header.m_uiSequenceCount;
+    block.m_uiConveyorCount = header.m_uiConveyorCount;
+    block.m_uiFactoryCount = header.m_uiFactoryCount;
+    block.m_uiStorageCount = header.m_uiStorageCount;
+    block.m_vRecords.assign(remaining.begin(), remaining.end());
+    return save;
+}
+
+bool cpp_conv::save_game::decodeRecordBlocks(
+    const std::span<const RecordBlock> blocks,
+    const std::span<const ItemIndex> palette,
+    SimulationSnapshot& outSnapshot,
+    std::string* pErrors)
+{
+    const auto fail = [pErrors](const std::string_view reason)
+    {
+        if (pErrors)
+        {
+            *pErrors += std::format("Invalid save game: {}\n", reason);
+        }
+
+        return false;
+    };
+
+    for (const RecordBlock& block : blocks)
+    {
+        RecordReader reader{block.m_vRecords, palette};
+        for (uint32_t i = 0; i < block.m_uiSequenceCount; ++i)
+        {
+            SimulationSnapshot::Sequence& sequence = outSnapshot.m_vSequences.emplace_back();
+            sequence.m_TailPosition = reader.ReadPosition();
+            sequence.m_uiLength = reader.Read<uint8_t>();
+            sequence.m_uiCurrentTick = reader.Read<uint32_t>();
+            sequence.m_uiFirstItem = static_cast<uint32_t>(outSnapshot.m_vSequenceItems.size());
+            if (reader.HasFailed() ||
+                sequence.m_uiLength == 0 ||
+                sequence.m_uiLength > SequenceFormationSystem::c_MaxSequenceLength)
+            {
+                return fail("bad sequence record");
+            }
+
+            for (uint64_t& rLanes : sequence.m_Lanes)
+            {
+                if (!readLanes(reader, sequence.m_uiLength, rLanes, outSnapshot.m_vSequenceItems))
+                {
+                    return fail("bad sequence lanes");
+                }
+            }
+        }
+
+        for (uint32_t i = 0; i < block.m_uiConveyorCount; ++i)
+        {
+            SimulationSnapshot::Conveyor& conveyor = outSnapshot.m_vConveyors.emplace_back();
+            conveyor.m_Position = reader.ReadPosition();
+            conveyor.m_uiCurrentTick = reader.Read<uint32_t>();
+            for (size_t uiChannel = 0; uiChannel < conveyor.m_Slots.size(); ++uiChannel)
+            {
+                const auto uiLaneLength = reader.Read<uint8_t>();
+                if (uiLaneLength > conveyor.m_Slots[uiChannel].size())
+                {
+                    return fail("bad conveyor record");
+                }
+
+                conveyor.m_LaneLengths[uiChannel] = uiLaneLength;
+                for (uint8_t uiSlot = 0; uiSlot < uiLaneLength; ++uiSlot)
+                {
+                    conveyor.m_Slots[uiChannel][uiSlot] = reader.ReadItem();
+                }
+            }
+        }
+
+        for (uint32_t i = 0; i < block.m_uiFactoryCount; ++i)
+        {
+            SimulationSnapshot::Factory& factory = outSnapshot.m_vFactories.emplace_back();
+            factory.m_Position = reader.ReadPosition();
+            factory.m_uiProductionCompleteTick = reader.Read<uint64_t>();
+            factory.m_uiLastUpdateTick = reader.Read<uint64_t>();
+            factory.m_bIsDemandSatisfied = reader.Read<uint8_t>() != 0;
+            factory.m_uiFirstEntry = static_cast<uint32_t>(outSnapshot.m_vEntries.size());
+            factory.m_uiInputCount = readEntries(reader, outSnapshot.m_vEntries);
+            factory.m_uiOutputCount = readEntries(reader, outSnapshot.m_vEntries);
+            factory.m_uiStagedCount = readEntries(reader, outSnapshot.m_vEntries);
+        }
+
+        for (uint32_t i = 0; i < block.m_uiStorageCount; ++i)
+        {
+            SimulationSnapshot::Storage& storage = outSnapshot.m_vStorages.emplace_back();
+            storage.m_Position = reader.ReadPosition();
+            storage.m_uiFirstEntry = static_cast<uint32_t>(outSnapshot.m_vEntries.size());
+            storage.m_uiStoredCount = readEntries(reader, outSnapshot.m_vEntries);
+            storage.m_uiStagedCount = readEntries(reader, outSnapshot.m_vEntries);
+        }
+
+        if (reader.HasFailed() || !reader.IsAtEnd())
+        {
+            return fail("bad records");
+        }
+    }
+
+    return true;
+}
+
+bool cpp_conv::save_game::restoreSimulationState(
+    const SaveGame& save,
+    atlas::scene::EcsManager& ecs,
+    const EntityLookupGrid& grid,
+    std::string* pErrors)
+{
+    SimulationSnapshot snapshot;
+    snapshot.m_uiTick = save.m_uiTick;
+    return decodeRecordBlocks(save.m_vBlocks, save.m_vItemPalette, snapshot, pErrors) &&
+        restoreSimulationState(snapshot, ecs, grid, pErrors);
+}
+
+bool cpp_conv::save_game::restoreSimulationState(
+    const SimulationSnapshot& snapshot,
+    atlas::scene::EcsManager& ecs,
+    const EntityLookupGrid& grid,
+    std::string* pErrors)
+{
+    const auto fail = [pErrors](const std::string_view reason)
+    {
+        if (pErrors)
+        {
+            *pErrors += std::format("Invalid save game: {}\n", reason);
+        }
+
+        return false;
+    };
+
+    // All sequences must exist before the conveyors that are not part of one can be told apart.
+    std::vector<EntityId> vConveyors;
+    for (const SimulationSnapshot::Sequence& sequence : snapshot.m_vSequences)
+    {
+        if (!traceSequence(ecs, grid, sequence.m_TailPosition, sequence.m_uiLength, vConveyors))
+        {
+            return fail("sequence does not match the layout");
+        }
+
+        const EntityId sequenceId = SequenceFormationSystem::CreateSequence(ecs, vConveyors);
+        auto& component = ecs.GetComponent<SequenceComponent>(sequenceId);
+        component.m_CurrentTick = sequence.m_uiCurrentTick;
+
+        size_t uiItem = sequence.m_uiFirstItem;
+        for (size_t uiChannel = 0; uiChannel < component.m_RealizedStates.size(); ++uiChannel)
+        {
+            SequenceComponent::RealizedState& state = component.m_RealizedStates[uiChannel];
+            state.m_Lanes |= sequence.m_Lanes[uiChannel];
+            for (int i = 0; i < std::popcount(sequence.m_Lanes[uiChannel]); ++i)
+            {
+                state.m_Items.Push({snapshot.m_vSequenceItems[uiItem++]});
+            }
+        }
+    }
+
+    // Straight conveyors saved as standalone, whose sequences were cut short, are formed into sequences once restored.
+    std::vector<EntityId> vUnsequenced;
+    for (const SimulationSnapshot::Conveyor& saved : snapshot.m_vConveyors)
+    {
+        const EntityId entity = getEntityWith<ConveyorComponent>(ecs, grid, saved.m_Position);
+        if (entity.IsInvalid())
+        {
+            return fail("conveyor does not match the layout");
+        }
+
+        if (!ecs.DoesEntityHaveComponent<IndividuallyProcessableConveyorComponent>(entity))
+        {
+            const auto& straight = ecs.GetComponent<ConveyorComponent>(entity);
+            if (straight.m_bIsCorner || straight.m_Sequence.IsValid())
+            {
+                return fail("conveyor does not match the layout");
+            }
+
+            ecs.AddComponent<IndividuallyProcessableConveyorComponent>(entity);
+            vUnsequenced.push_back(entity);
+        }
+
+        auto& conveyor = ecs.GetComponent<ConveyorComponent>(entity);
+        conveyor.m_CurrentTick = saved.m_uiCurrentTick;
+        for (size_t uiChannel = 0; uiChannel < conveyor.m_Channels.size(); ++uiChannel)
+        {
+            ConveyorComponent::Channel& channel = conveyor.m_Channels[uiChannel];
+            if (saved.m_LaneLengths[uiChannel] != channel.m_LaneLength)
+            {
+                return fail("conveyor lanes do not match the layout");
+            }
+
+            for (int iSlot = 0; iSlot < channel.m_LaneLength; ++iSlot)
+            {
+                channel.m_pSlots[iSlot].m_Item.m_Item = saved.m_Slots[uiChannel][iSlot];
+            }
+        }
+    }
+
+    for (const SimulationSnapshot::Factory& saved : snapshot.m_vFactories)
+    {
+        const EntityId entity = getEntityWith<FactoryComponent, ItemInputStaging>(ecs, grid, saved.m_Position);
+        if (entity.IsInvalid())
+        {
+            return fail("factory does not match the layout");
+        }
+
+        auto [factory, staging] = ecs.GetComponents<FactoryComponent, ItemInputStaging>(entity);
+        factory.m_uiProductionCompleteTick = saved.m_uiProductionCompleteTick;
+        factory.m_uiLastUpdateTick = saved.m_uiLastUpdateTick;
+        factory.m_bIsDemandSatisfied = saved.m_bIsDemandSatisfied;
+
+        size_t uiEntry = saved.m_uiFirstEntry;
+        restoreContainer(takeEntries(snapshot.m_vEntries, uiEntry, saved.m_uiInputCount), factory.m_InputItems);
+        restoreContainer(takeEntries(snapshot.m_vEntries, uiEntry, saved.m_uiOutputCount), factory.m_OutputItems);
+        restoreStaged(takeEntries(snapshot.m_vEntries, uiEntry, saved.m_uiStagedCount), staging);
+    }
+
+    for (const SimulationSnapshot::Storage& saved : snapshot.m_vStorages)
+    {
+        const EntityId entity = getEntityWith<StorageComponent, ItemInputStaging>(ecs, grid, saved.m_Position);
+        if (entity.IsInvalid())
+        {
+            return fail("storage does not match the layout");
+        }
+
+        auto [storage, staging] = ecs.GetComponents<StorageComponent, ItemInputStaging>(entity);
+        size_t uiEntry = saved.m_uiFirstEntry;
+        restoreContainer(takeEntries(snapshot.m_vEntries, uiEntry, saved.m_uiStoredCount), storage.m_ItemContainer);
+        restoreStaged(takeEntries(snapshot.m_vEntries, uiEntry, saved.m_uiStagedCount), staging);
+    }
+
+    SequenceFormationSystem::FormSequences(ecs, grid, vUnsequenced);
+
+    // Anything that is neither standalone nor sequenced would never be processed.
+    for (const EntityId entity : ecs.GetEntitiesWithComponents<ConveyorComponent>())
+    {
+        const auto& conveyor = ecs.GetComponent<ConveyorComponent>(entity);
+        if (!conveyor.m_bIsCorner &&
+            conveyor.m_Sequence.IsInvalid() &&
+            !ecs.DoesEntityHaveComponent<IndividuallyProcessableConveyorComponent>(entity))
+        {
+            return fail("conveyor missing from the sequences");
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,197 @@
+#pragma once
+#include <array>
+#include <compare>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "BinaryMap.h"
+#include "ConveyorComponent.h"
+#include "DataId.h"
+#include "AtlasScene/ECS/Entity.h"
+#include "SaveGameFormat.h"
+#include "Topology.h"
+
+namespace atlas::scene
+{
+    class EcsManager;
+}
+
+namespace cpp_conv
+{
+    class EntityLookupGrid;
+}
+
+namespace cpp_conv::save_game
+{
+    // The simulation state a save holds, copied out of the ECS into flat buffers. Capturing does no encoding, and no
+    // allocation once the buffers have grown, so it is cheap enough to run between two ticks while the encoding is left
+    // to another thread.
+    struct SimulationSnapshot
+    {
+        struct Sequence
+        {
+            Eigen::Vector3i m_TailPosition;
+            uint32_t m_uiCurrentTick;
+            uint8_t m_uiLength;
+            std::array<uint64_t, components::c_conveyorChannels> m_Lanes;
+            // Each channel's items, one per set lane, from here on in m_vSequenceItems.
+            uint32_t m_uiFirstItem;
+        };
+
+        struct Conveyor
+        {
+            Eigen::Vector3i m_Position;
+            uint32_t m_uiCurrentTick;
+            std::array<uint8_t, components::c_conveyorChannels> m_LaneLengths;
+            std::array<std::array<ItemIndex, components::c_conveyorChannelSlots + 1>, components::c_conveyorChannels> m_Slots;
+        };
+
+        // Container and staged contents follow from m_uiFirstEntry in m_vEntries, in the order the counts are listed.
+        struct Factory
+        {
+            Eigen::Vector3i m_Position;
+            uint64_t m_uiProductionCompleteTick;
+            uint64_t m_uiLastUpdateTick;
+            bool m_bIsDemandSatisfied;
+            uint32_t m_uiFirstEntry;
+            uint16_t m_uiInputCount;
+            uint16_t m_uiOutputCount;
+            uint16_t m_uiStagedCount;
+        };
+
+        struct Storage
+        {
+            Eigen::Vector3i m_Position;
+            uint32_t m_uiFirstEntry;
+            uint16_t m_uiStoredCount;
+            uint16_t m_uiStagedCount;
+        };
+
+        struct Entry
+        {
+            ItemIndex m_Item;
+            uint32_t m_uiCount;
+        };
+
+        uint64_t m_uiTick = 0;
+        bool m_bHasLayout = false;
+        std::vector<resources::BinaryMapEntity> m_vLayout;
+        // The corner state of the layout's conveyors, captured with it. Sequences are rebuilt from their records.
+        topology::Topology m_Topology;
+        std::vector<Sequence> m_vSequences;
+        std::vector<ItemIndex> m_vSequenceItems;
+        std::vector<Conveyor> m_vConveyors;
+        std::vector<Factory> m_vFactories;
+        std::vector<Storage> m_vStorages;
+        std::vector<Entry> m_vEntries;
+    };
+
+    // Hands out palette indices in the order items are first written. Indices never change, so records encoded with
+    // the same palette can be written out at different times.
+    class ItemPalette
+    {
+    public:
+        uint16_t GetIndex(ItemIndex item);
+        [[nodiscard]] const std::vector<uint64_t>& GetItemIds() const { return m_vItemIds; }
+        // The palette as this session's items, for reading back records encoded with it in the same session.
+        [[nodiscard]] const std::vector<ItemIndex>& GetItems() const { return m_vItems; }
+
+    private:
+        std::vector<uint16_t> m_vPaletteIndices;
+        std::vector<uint64_t> m_vItemIds;
+        std::vector<ItemIndex> m_vItems;
+    };
+
+    // Identifies the grid chunk a block of records belongs to.
+    struct BlockKey
+    {
+        int32_t m_iChunkX;
+        int32_t m_iChunkZ;
+        int32_t m_iFloor;
+
+        auto operator<=>(const BlockKey&) const = default;
+    };
+
+    // Records in the save format, ordered sequences, conveyors, factories and then storages.
+    struct RecordBlock
+    {
+        uint32_t m_uiSequenceCount = 0;
+        uint32_t m_uiConveyorCount = 0;
+        uint32_t m_uiFactoryCount = 0;
+        uint32_t m_uiStorageCount = 0;
+        std::vector<uint8_t> m_vRecords;
+    };
+
+    // A save split into its layout, which loads like any binary map, and the simulation state that is restored on
+    // top of it once constructed.
+    struct SaveGame
+    {
+        uint64_t m_uiTick;
+        std::vector<uint8_t> m_vMapData;
+        // An encoded topology::Topology of m_vMapData, empty if none was saved.
+        std::vector<uint8_t> m_vTopologyData;
+        // Palette index to the item it names in this session. Items that no longer exist map to an empty ItemIndex.
+        std::vector<ItemIndex> m_vItemPalette;
+        std::vector<RecordBlock> m_vBlocks;
+    };
+
+    // Empties a snapshot, keeping its buffers for the next capture.
+    void clearSnapshot(SimulationSnapshot& outSnapshot);
+
+    // Must be called between ticks, while nothing else touches the ECS. The snapshot's buffers are reused. The layout
+    // is only captured when asked for, as it does not change while the simulation runs.
+    void captureSimulation(
+        atlas::scene::EcsManager& ecs,
+        uint64_t uiTick,
+        bool bIncludeLayout,
+        SimulationSnapshot& outSnapshot);
+
+    // Appends the state of the given entities, with their layout, to a snapshot. Sequences are captured through their
+    // tail conveyor, so a sequence is included only if its tail is one of the entities.
+    void captureEntities(
+        atlas::scene::EcsManager& ecs,
+        std::span<const atlas::scene::EntityId> entities,
+        SimulationSnapshot& outSnapshot);
+
+    // Maps a written palette of ItemIds back onto this session's items.
+    std::vector<ItemIndex> readItemPalette(std::span<const uint8_t> data);
+
+    // Encodes a snapshot's records in one block per grid chunk. Sequences belong to the chunk of their tail.
+    std::map<BlockKey, RecordBlock> encodeRecordBlocks(const SimulationSnapshot& snapshot, ItemPalette& palette);
+
+    // A complete save file. The snapshot must include the layout.
+    std::vector<uint8_t> writeSaveGame(const SimulationSnapshot& snapshot);
+    std::vector<uint8_t> writeSaveGame(atlas::scene::EcsManager& ecs, uint64_t uiTick);
+
+    [[nodiscard]] bool isSaveGame(std::span<const uint8_t> data);
+    std::optional<SaveGame> readSaveGame(std::span<const uint8_t> data, std::string* pErrors);
+
+    // Decodes record blocks onto the end of a snapshot's records. Items that no longer exist are dropped. The layout
+    // is left as it is.
+    bool decodeRecordBlocks(
+        std::span<const RecordBlock> blocks,
+        std::span<const ItemIndex> palette,
+        SimulationSnapshot& outSnapshot,
+        std::string* pErrors);
+
+    // Restores sequences, conveyor slots, factories and storage onto entities constructed from the save's layout. The
+    // conveyors' state must already have been determined, or applied from m_vTopologyData; sequences are rebuilt from the save rather than formed.
+    // Straight conveyors that were saved outside of any sequence, e.g. next to a frozen region, are formed into new
+    // sequences along with their items.
+    bool restoreSimulationState(
+        const SaveGame& save,
+        atlas::scene::EcsManager& ecs,
+        const EntityLookupGrid& grid,
+        std::string* pErrors);
+
+    // As above, from a snapshot's records. The layout and topology in the snapshot are not used.
+    bool restoreSimulationState(
+        const SimulationSnapshot& snapshot,
+        atlas::scene::EcsManager& ecs,
+        const EntityLookupGrid& grid,
+        std::string* pErrors);
+}
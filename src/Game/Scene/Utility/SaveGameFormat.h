@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace cpp_conv::save_game
+{
+    // On-disk layout of a save game. Everything is little endian.
+    //
+    //   FileHeader
+    //   uint64_t[m_uiItemCount]   the item palette, as ItemIds
+    //   uint8_t[m_uiMapSize]      the layout, as a binary map
+    //   uint8_t[m_uiTopologySize] the corner state of its conveyors, in the topology format (see TopologyFormat.h)
+    //   records                   m_uiSequenceCount sequences, then m_uiConveyorCount standalone conveyors, then
+    //                             m_uiFactoryCount factories, then m_uiStorageCount storages
+    //
+    // Records are packed with no padding and are read field by field. Like the binary map's item records, they refer
+    // to entities by position, as entity ids do not survive a reload. Items are written as palette indices, where
+    // c_uiNoItem is an empty slot and n is the palette's nth ItemId.
+    //
+    //   position      int32_t x, y, z
+    //   item          uint16_t palette index
+    //   container     uint16_t entry count, then per entry: item, uint32_t count
+    //   staged        uint16_t entry count, then per entry: item, uint32_t count, in drain order
+    //
+    //   sequence      position of its tail conveyor, uint8_t length, uint32_t current tick, then per channel:
+    //                 uint64_t lane mask, uint8_t run count, then per run: item, uint8_t count. The runs list the items
+    //                 of the set lanes in lane order, and the rest of the sequence is found by walking forward from the
+    //                 tail.
+    //   conveyor      position, uint32_t current tick, then per channel: uint8_t lane length, item per slot. Straight
+    //                 conveyors whose sequence was cut at a frozen chunk are saved this way too, and are formed into
+    //                 sequences again on load.
+    //   factory       position, uint64_t production complete tick, uint64_t last update tick, uint8_t demand
+    //                 satisfied, input container, output container, staged
+    //   storage       position, container, staged
+
+    inline constexpr std::array<char, 4> c_Magic = {'C', 'P', 'S', 'V'};
+    inline constexpr uint32_t c_uiVersion = 2;
+    inline constexpr uint16_t c_uiNoItem = 0xFFFF;
+
+    struct FileHeader
+    {
+        std::array<char, 4> m_Magic;
+        uint32_t m_uiVersion;
+        uint64_t m_uiTick;
+        uint64_t m_uiMapSize;
+        uint64_t m_uiTopologySize;
+        uint32_t m_uiItemCount;
+        uint32_t m_uiSequenceCount;
+        uint32_t m_uiConveyorCount;
+        uint32_t m_uiFactoryCount;
+        uint32_t m_uiStorageCount;
+        uint32_t m_uiPadding;
+    };
+
+    // On-disk layout of the autosave journal. Autosaves only append what changed since the previous one, so the file is
+    // a sequence of entries, each starting with a JournalEntryHeader:
+    //
+    //   JournalHeader
+    //   Layout entry    the layout, as a binary map
+    //   Topology entry  the corner state of its conveyors, written straight after the layout it was derived from
+    //   Block entry     BlockHeader, then the records of one grid chunk in the save game's record encoding
+    //   Commit entry    CommitHeader, then uint64_t[m_uiItemCount] ItemIds and uint64_t[m_uiBlockCount] block offsets
+    //
+    // A commit names the layout, its topology and the latest block of every chunk by their entries' offsets from the
+    // start of the file, along with the palette that all of its blocks are encoded with. Only the last complete commit
+    // counts, so a write torn by a crash leaves the previous autosave intact. Once the superseded entries outgrow the
+    // live ones, the journal is written afresh.
+
+    inline constexpr std::array<char, 4> c_JournalMagic = {'C', 'P', 'A', 'J'};
+    inline constexpr uint32_t c_uiJournalVersion = 2;
+
+    enum class JournalEntryType : uint32_t
+    {
+        Layout,
+        Block,
+        Commit,
+        Topology
+    };
+
+    struct JournalHeader
+    {
+        std::array<char, 4> m_Magic;
+        uint32_t m_uiVersion;
+    };
+
+    struct JournalEntryHeader
+    {
+        JournalEntryType m_Type;
+        uint32_t m_uiPadding;
+        // Size of what follows this header.
+        uint64_t m_uiSize;
+    };
+
+    struct BlockHeader
+    {
+        int32_t m_iChunkX;
+        int32_t m_iChunkZ;
+        int32_t m_iFloor;
+        uint32_t m_uiSequenceCount;
+        uint32_t m_uiConveyorCount;
+        uint32_t m_uiFactoryCount;
+        uint32_t m_uiStorageCount;
+        uint32_t m_uiPadding;
+    };
+
+    struct CommitHeader
+    {
+        uint64_t m_uiTick;
+        uint64_t m_uiLayoutOffset;
+        uint64_t m_uiTopologyOffset;
+        uint32_t m_uiItemCount;
+        uint32_t m_uiBlockCount;
+    };
+}
@@ -0,0 +1,327 @@
+#include "Topology.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <format>
+#include <string_view>
+#include <tuple>
+
+#include "ConveyorComponent.h"
+#include "ConveyorStateDeterminationSystem.h"
+#include "DirectionComponent.h"
+#include "EntityLookupGrid.h"
+#include "Hashing.h"
+#include "PositionHelper.h"
+#include "SequenceFormationSystem.h"
+#include "TopologyFormat.h"
+#include "AtlasGame/Scene/Components/PositionComponent.h"
+#include "AtlasScene/ECS/Components/EcsManager.h"
+
+namespace
+{
+    using namespace cpp_conv::components;
+    using namespace cpp_conv::topology;
+    using atlas::game::scene::components::PositionComponent;
+    using atlas::scene::EcsManager;
+    using atlas::scene::EntityId;
+
+    template <typename TValue>
+    void append(std::vector<uint8_t>& vData, const TValue& value)
+    {
+        const size_t uiOffset = vData.size();
+        vData.resize(uiOffset + sizeof(TValue));
+        std::memcpy(vData.data() + uiOffset, &value, sizeof(TValue));
+    }
+
+    template <typename TValue>
+    TValue readAt(const std::span<const uint8_t> data, const size_t uiOffset)
+    {
+        TValue value;
+        std::memcpy(&value, data.data() + uiOffset, sizeof(TValue));
+        return value;
+    }
+
+    // Identifies the build and the limits a topology is derived with, so that one derived differently is not applied.
+    // Changes to how the systems derive it that these do not capture still need c_uiVersion bumped.
+    uint64_t getDerivationStamp()
+    {
+        using cpp_conv::hashing::fnv1aValue;
+        uint64_t uiStamp = fnv1aValue(c_uiVersion, cpp_conv::hashing::getBuildStamp());
+        uiStamp = fnv1aValue(cpp_conv::SequenceFormationSystem::c_MaxSequenceLength, uiStamp);
+        return fnv1aValue(c_conveyorChannels, uiStamp);
+    }
+}
+
+uint64_t cpp_conv::topology::hashLayout(const std::span<const uint8_t> mapData)
+{
+    return hashing::fnv1a(mapData, getDerivationStamp());
+}
+
+cpp_conv::topology::ConveyorState cpp_conv::topology::captureConveyorState(
+    atlas::scene::EcsManager& ecs,
+    const atlas::scene::EntityId entity)
+{
+    const auto& [position, conveyor] = ecs.GetComponents<PositionComponent, ConveyorComponent>(entity);
+    return {
+        position.m_Position,
+        conveyor.m_bIsCorner,
+        conveyor.m_bIsClockwise,
+        conveyor.m_InnerMostChannel,
+        conveyor.m_CornerDirection};
+}
+
+cpp_conv::topology::Topology cpp_conv::topology::captureTopology(
+    atlas::scene::EcsManager& ecs,
+    const bool bIncludeSequences)
+{
+    std::vector<EntityId> vConveyors = ecs.GetEntitiesWithComponents<PositionComponent, ConveyorComponent>();
+
+    // Each sequence's conveyors are brought together, tail to head, ahead of the conveyors outside of any sequence.
+    if (bIncludeSequences)
+    {
+        std::ranges::sort(vConveyors, [&ecs](const EntityId lhs, const EntityId rhs)
+        {
+            const auto& lhsConveyor = ecs.GetComponent<ConveyorComponent>(lhs);
+            const auto& rhsConveyor = ecs.GetComponent<ConveyorComponent>(rhs);
+            return std::tuple{lhsConveyor.m_Sequence.IsInvalid(), lhsConveyor.m_Sequence, lhsConveyor.m_SequenceIndex} <
+                std::tuple{rhsConveyor.m_Sequence.IsInvalid(), rhsConveyor.m_Sequence, rhsConveyor.m_SequenceIndex};
+        });
+    }
+
+    Topology topology;
+    topology.m_vConveyors.reserve(vConveyors.size());
+    for (const EntityId entity : vConveyors)
+    {
+        topology.m_vConveyors.push_back(captureConveyorState(ecs, entity));
+        if (!bIncludeSequences)
+        {
+            continue;
+        }
+
+        const auto& conveyor = ecs.GetComponent<ConveyorComponent>(entity);
+        if (conveyor.m_Sequence.IsValid() && conveyor.m_SequenceIndex == 0)
+        {
+            topology.m_vSequences.push_back({static_cast<uint32_t>(topology.m_vConveyors.size() - 1), 0});
+        }
+
+        if (conveyor.m_Sequence.IsValid() && !topology.m_vSequences.empty())
+        {
+            topology.m_vSequences.back().m_uiLength++;
+        }
+    }
+
+    return topology;
+}
+
+std::vector<uint8_t> cpp_conv::topology::encodeTopology(const Topology& topology, const uint64_t uiLayoutHash)
+{
+    TopologyHeader header{};
+    header.m_Magic = c_Magic;
+    header.m_uiVersion = c_uiVersion;
+    header.m_uiLayoutHash = uiLayoutHash;
+    header.m_uiConveyorCount = static_cast<uint32_t>(topology.m_vConveyors.size());
+    header.m_uiSequenceCount = static_cast<uint32_t>(topology.m_vSequences.size());
+
+    std::vector<uint8_t> vData;
+    vData.reserve(
+        sizeof(TopologyHeader) +
+        topology.m_vConveyors.size() * sizeof(ConveyorRecord) +
+        topology.m_vSequences.size() * sizeof(SequenceRecord));
+    append(vData, header);
+
+    for (const ConveyorState& state : topology.m_vConveyors)
+    {
+        ConveyorRecord record{};
+        record.m_iPositionX = state.m_Position.x();
+        record.m_iPositionY = state.m_Position.y();
+        record.m_iPositionZ = state.m_Position.z();
+        record.m_uiFlags = static_cast<uint8_t>(
+            (state.m_bIsCorner ? ConveyorFlags::Corner : 0) |
+            (state.m_bIsClockwise ? ConveyorFlags::Clockwise : 0));
+        record.m_iInnerMostChannel = static_cast<int8_t>(state.m_InnerMostChannel);
+        record.m_uiCornerDirection = static_cast<uint8_t>(state.m_CornerDirection);
+        append(vData, record);
+    }
+
+    for (const SequenceSpan& sequence : topology.m_vSequences)
+    {
+        append(vData, SequenceRecord{sequence.m_uiFirstConveyor, sequence.m_uiLength});
+    }
+
+    return vData;
+}
+
+std::optional<cpp_conv::topology::Topology> cpp_conv::topology::decodeTopology(
+    const std::span<const uint8_t> data,
+    const uint64_t uiLayoutHash,
+    std::string* pErrors)
+{
+    const auto fail = [pErrors](const std::string_view reason) -> std::optional<Topology>
+    {
+        if (pErrors)
+        {
+            *pErrors += std::format("Unusable conveyor topology: {}\n", reason);
+        }
+
+        return {};
+    };
+
+    if (data.size() < sizeof(TopologyHeader))
+    {
+        return fail("missing header");
+    }
+
+    const auto header = readAt<TopologyHeader>(data, 0);
+    if (header.m_Magic != c_Magic || header.m_uiVersion != c_uiVersion)
+    {
+        return fail("unsupported format");
+    }
+
+    if (header.m_uiLayoutHash != uiLayoutHash)
+    {
+        return fail("derived from a different layout");
+    }
+
+    const uint64_t uiExpectedSize =
+        sizeof(TopologyHeader) +
+        uint64_t{header.m_uiConveyorCount} * sizeof(ConveyorRecord) +
+        uint64_t{header.m_uiSequenceCount} * sizeof(SequenceRecord);
+    if (data.size() != uiExpectedSize)
+    {
+        return fail("truncated");
+    }
+
+    Topology topology;
+    topology.m_vConveyors.reserve(header.m_uiConveyorCount);
+    size_t uiOffset = sizeof(TopologyHeader);
+    for (uint32_t i = 0; i < header.m_uiConveyorCount; ++i, uiOffset += sizeof(ConveyorRecord))
+    {
+        const auto record = readAt<ConveyorRecord>(data, uiOffset);
+        if (record.m_iInnerMostChannel < -1 ||
+            record.m_iInnerMostChannel >= c_conveyorChannels ||
+            !std::has_single_bit(record.m_uiCornerDirection) ||
+            record.m_uiCornerDirection > static_cast<uint8_t>(Direction::Right))
+        {
+            return fail("bad conveyor record");
+        }
+
+        topology.m_vConveyors.push_back({
+            {record.m_iPositionX, record.m_iPositionY, record.m_iPositionZ},
+            (record.m_uiFlags & ConveyorFlags::Corner) != 0,
+            (record.m_uiFlags & ConveyorFlags::Clockwise) != 0,
+            record.m_iInnerMostChannel,
+            static_cast<Direction>(record.m_uiCornerDirection)});
+    }
+
+    topology.m_vSequences.reserve(header.m_uiSequenceCount);
+    for (uint32_t i = 0; i < header.m_uiSequenceCount; ++i, uiOffset += sizeof(SequenceRecord))
+    {
+        const auto record = readAt<SequenceRecord>(data, uiOffset);
+        if (record.m_uiLength == 0 ||
+            record.m_uiLength > cpp_conv::SequenceFormationSystem::c_MaxSequenceLength ||
+            record.m_uiFirstConveyor > header.m_uiConveyorCount ||
+            record.m_uiLength > header.m_uiConveyorCount - record.m_uiFirstConveyor)
+        {
+            return fail("bad sequence record");
+        }
+
+        topology.m_vSequences.push_back({record.m_uiFirstConveyor, record.m_uiLength});
+    }
+
+    return topology;
+}
+
+bool cpp_conv::topology::applyTopology(
+    const Topology& topology,
+    atlas::scene::EcsManager& ecs,
+    const EntityLookupGrid& grid,
+    std::string* pErrors)
+{
+    const auto fail = [pErrors](const std::string_view reason)
+    {
+        if (pErrors)
+        {
+            *pErrors += std::format("Conveyor topology does not match the layout: {}\n", reason);
+        }
+
+        return false;
+    };
+
+    // Everything is looked up before anything is written, so that a mismatch leaves the conveyors as they were.
+    std::vector<EntityId> vConveyors;
+    vConveyors.reserve(topology.m_vConveyors.size());
+    for (const ConveyorState& state : topology.m_vConveyors)
+    {
+        const EntityId entity = grid.GetEntity(state.m_Position);
+        if (entity.IsInvalid() ||
+            !ecs.DoesEntityHaveComponents<PositionComponent, ConveyorComponent>(entity) ||
+            ecs.GetComponent<PositionComponent>(entity).m_Position != state.m_Position ||
+            ecs.GetComponent<ConveyorComponent>(entity).m_Sequence.IsValid())
+        {
+            return fail("no conveyor at a recorded position");
+        }
+
+        vConveyors.push_back(entity);
+    }
+
+    std::vector<EntityId> vSorted = vConveyors;
+    std::ranges::sort(vSorted);
+    if (std::ranges::adjacent_find(vSorted) != vSorted.end())
+    {
+        return fail("a conveyor is recorded twice");
+    }
+
+    // Each conveyor of a sequence must feed straight into the next, as SequenceFormationSystem would have found them.
+    const auto isForwardLink = [&ecs](const EntityId from, const EntityId to)
+    {
+        if (!ecs.DoesEntityHaveComponents<DirectionComponent>(from) || !ecs.DoesEntityHaveComponents<DirectionComponent>(to))
+        {
+            return false;
+        }
+
+        const Direction direction = ecs.GetComponent<DirectionComponent>(from).m_Direction;
+        return ecs.GetComponent<DirectionComponent>(to).m_Direction == direction &&
+            cpp_conv::position_helper::getForwardPosition(ecs.GetComponent<PositionComponent>(from).m_Position, direction) ==
+            ecs.GetComponent<PositionComponent>(to).m_Position;
+    };
+
+    std::vector<bool> vIsSequenced(vConveyors.size(), false);
+    for (const SequenceSpan& sequence : topology.m_vSequences)
+    {
+        for (uint32_t i = sequence.m_uiFirstConveyor; i < sequence.m_uiFirstConveyor + sequence.m_uiLength; ++i)
+        {
+            if (topology.m_vConveyors[i].m_bIsCorner || vIsSequenced[i])
+            {
+                return fail("bad sequence");
+            }
+
+            if (i > sequence.m_uiFirstConveyor && !isForwardLink(vConveyors[i - 1], vConveyors[i]))
+            {
+                return fail("a sequence is not a straight run of conveyors");
+            }
+
+            vIsSequenced[i] = true;
+        }
+    }
+
+    for (size_t i = 0; i < vConveyors.size(); ++i)
+    {
+        const ConveyorState& state = topology.m_vConveyors[i];
+        auto& conveyor = ecs.GetComponent<ConveyorComponent>(vConveyors[i]);
+        conveyor.m_bIsCorner = state.m_bIsCorner;
+        conveyor.m_bIsClockwise = state.m_bIsClockwise;
+        conveyor.m_InnerMostChannel = state.m_InnerMostChannel;
+        conveyor.m_CornerDirection = state.m_CornerDirection;
+        ConveyorStateDeterminationSystem::ApplyCornerState(ecs, vConveyors[i]);
+    }
+
+    for (const SequenceSpan& sequence : topology.m_vSequences)
+    {
+        SequenceFormationSystem::CreateSequence(
+            ecs,
+            std::span{vConveyors}.subspan(sequence.m_uiFirstConveyor, sequence.m_uiLength));
+    }
+
+    return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "Direction.h"
+#include "AtlasScene/ECS/Entity.h"
+#include "Eigen/Core"
+
+namespace atlas::scene
+{
+    class EcsManager;
+}
+
+namespace cpp_conv
+{
+    class EntityLookupGrid;
+}
+
+namespace cpp_conv::topology
+{
+    // The conveyor state that ConveyorStateDeterminationSystem and SequenceFormationSystem derive from a layout, kept so
+    // that a load can apply it directly instead of searching the neighbourhood of every conveyor again.
+    struct ConveyorState
+    {
+        Eigen::Vector3i m_Position;
+        bool m_bIsCorner;
+        bool m_bIsClockwise;
+        int m_InnerMostChannel;
+        Direction m_CornerDirection;
+    };
+
+    // A run of m_vConveyors, ordered tail to head.
+    struct SequenceSpan
+    {
+        uint32_t m_uiFirstConveyor;
+        uint32_t m_uiLength;
+    };
+
+    struct Topology
+    {
+        std::vector<ConveyorState> m_vConveyors;
+        std::vector<SequenceSpan> m_vSequences;
+    };
+
+    // Identifies the layout a topology was derived from, and the build that derived it.
+    [[nodiscard]] uint64_t hashLayout(std::span<const uint8_t> mapData);
+
+    [[nodiscard]] ConveyorState captureConveyorState(atlas::scene::EcsManager& ecs, atlas::scene::EntityId entity);
+
+    // The state of every conveyor, and with bIncludeSequences the sequences they form. Must be called between ticks.
+    Topology captureTopology(atlas::scene::EcsManager& ecs, bool bIncludeSequences);
+
+    std::vector<uint8_t> encodeTopology(const Topology& topology, uint64_t uiLayoutHash);
+    // Fails if the data is malformed or was derived from another layout.
+    std::optional<Topology> decodeTopology(std::span<const uint8_t> data, uint64_t uiLayoutHash, std::string* pErrors);
+
+    // Applies the recorded corner state to freshly constructed conveyors and creates the recorded sequences, which start
+    // out empty. Nothing is changed if any record does not match a conveyor that is not yet in a sequence. Conveyors
+    // without a record are left alone, so callers that need every conveyor covered must check the count.
+    bool applyTopology(
+        const Topology& topology,
+        atlas::scene::EcsManager& ecs,
+        const EntityLookupGrid& grid,
+        std::string* pErrors);
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace cpp_conv::topology
+{
+    // On-disk layout of a conveyor topology. Everything is little endian.
+    //
+    //   TopologyHeader
+    //   ConveyorRecord[m_uiConveyorCount]
+    //   SequenceRecord[m_uiSequenceCount]
+    //
+    // The topology is derived from a layout, and m_uiLayoutHash is the hash of that layout's binary map, seeded with the
+    // build and the limits it was derived with. It is only used while the hash still matches. Sequences name a run of conveyor records, ordered tail to head.
+
+    inline constexpr std::array<char, 4> c_Magic = {'C', 'P', 'T', 'P'};
+    inline constexpr uint32_t c_uiVersion = 1;
+
+    enum ConveyorFlags : uint8_t
+    {
+        Corner = 1 << 0,
+        Clockwise = 1 << 1,
+    };
+
+    struct TopologyHeader
+    {
+        std::array<char, 4> m_Magic;
+        uint32_t m_uiVersion;
+        uint64_t m_uiLayoutHash;
+        uint32_t m_uiConveyorCount;
+        uint32_t m_uiSequenceCount;
+    };
+
+    struct ConveyorRecord
+    {
+        int32_t m_iPositionX;
+        int32_t m_iPositionY;
+        int32_t m_iPositionZ;
+        uint8_t m_uiFlags;
+        // -1 when the conveyor is not fed from the side.
+        int8_t m_iInnerMostChannel;
+        uint8_t m_uiCornerDirection;
+        uint8_t m_uiPadding;
+    };
+
+    struct SequenceRecord
+    {
+        uint32_t m_uiFirstConveyor;
+        uint32_t m_uiLength;
+    };
+
+    static_assert(sizeof(TopologyHeader) == 24);
+    static_assert(sizeof(ConveyorRecord) == 16);
+    static_assert(sizeof(SequenceRecord) == 8);
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 #include "bgfx/bgfx.h"
@@ -22,4 +23,39 @@ namespace cpp_conv::constants
         constexpr int c_clipCasterGeometry      = 1 << 2;
         constexpr int c_shadowCaster            = 1 << 3;
     }
+
+    namespace autosave
+    {
+        constexpr const char* c_szPath = "autosave.cpaj";
+        // The simulation ticks once per update, so this is about five minutes at 60 frames a second.
+        constexpr uint64_t c_uiIntervalTicks = 60 * 60 * 5;
+    }
+
+    namespace save_game
+    {
+        // Written by the debug UI's save button, and loaded again with --load-save.
+        constexpr const char* c_szPath = "quicksave.cpsv";
+    }
+
+    namespace definition_cache
+    {
+        constexpr const char* c_szPath = "cache/definitions.cpdc";
+    }
+
+    namespace topology_cache
+    {
+        // Holds the conveyor topology of each map layout that has been loaded, named by the layout's hash.
+        constexpr const char* c_szDirectory = "cache/topology";
+    }
+
+    namespace streaming
+    {
+        // In grid chunks from the nearest camera focus. Chunks between the two distances stay as they are.
+        constexpr int32_t c_iThawDistance = 3;
+        constexpr int32_t c_iFreezeDistance = 5;
+        constexpr uint64_t c_uiUpdateIntervalTicks = 30;
+        constexpr size_t c_uiMaxTransitionsPerUpdate = 4;
+        // Frozen chunks are paged out to files in here, each deleted once nothing reads from it any more.
+        constexpr const char* c_szPageDirectory = "cache/pages";
+    }
 }
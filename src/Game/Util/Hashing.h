@@ -0,0 +1,55 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+namespace cpp_conv::hashing
+{
+    inline constexpr uint64_t c_uiFnvOffsetBasis = 0xcbf29ce484222325;
+    inline constexpr uint64_t c_uiFnvPrime = 1099511628211;
+
+    // 64-bit FNV-1a. Pass the result of one call as the seed of the next to hash several pieces as one.
+    constexpr uint64_t fnv1a(const std::span<const uint8_t> data, uint64_t uiHash = c_uiFnvOffsetBasis)
+    {
+        for (const uint8_t uiByte : data)
+        {
+            uiHash ^= uiByte;
+            uiHash *= c_uiFnvPrime;
+        }
+
+        return uiHash;
+    }
+
+    constexpr uint64_t fnv1a(const std::string_view str, uint64_t uiHash = c_uiFnvOffsetBasis)
+    {
+        for (const char c : str)
+        {
+            uiHash ^= static_cast<uint8_t>(c);
+            uiHash *= c_uiFnvPrime;
+        }
+
+        return uiHash;
+    }
+
+    // Hashes the value's bytes as they are in memory.
+    template <typename TValue>
+    uint64_t fnv1aValue(const TValue& value, const uint64_t uiHash = c_uiFnvOffsetBasis)
+    {
+        static_assert(std::is_trivially_copyable_v<TValue>);
+        return fnv1a({reinterpret_cast<const uint8_t*>(&value), sizeof(TValue)}, uiHash);
+    }
+
+    // Identifies the compiler and target, for caches of data whose layout or derivation they decide.
+    inline uint64_t getBuildStamp()
+    {
+#if defined(_MSC_FULL_VER)
+        uint64_t uiStamp = fnv1aValue(_MSC_FULL_VER);
+#else
+        uint64_t uiStamp = fnv1a(__VERSION__);
+#endif
+        uiStamp = fnv1aValue(sizeof(void*), uiStamp);
+        return fnv1aValue(std::endian::native, uiStamp);
+    }
+}
@@ -0,0 +1,137 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cpp_conv
+{
+    // Hierarchical timer wheel. Each level has 2^SlotBits slots, and level N slots span 2^(SlotBits * N) ticks. A timer
+    // is filed at the level of the highest digit in which its due tick differs from the current tick, and cascades down
+    // a level each time the wheel rolls over into its slot. Timers beyond the top level wait in an overflow list.
+    // Scheduling is O(1) and advancing is O(due timers); slot storage is reused so steady-state operation does not
+    // allocate.
+    //
+    // Timers cannot be cancelled. Owners should record the tick they expect to be woken at and ignore stale entries.
+    template <typename T, uint32_t SlotBits = 6, uint32_t Levels = 4>
+    class TimerWheel
+    {
+    public:
+        struct Timer
+        {
+            uint64_t m_uiTick;
+            T m_Value;
+        };
+
+        [[nodiscard]] uint64_t GetCurrentTick() const { return m_uiCurrentTick; }
+
+        // Drops every timer and restarts the wheel at the given tick, e.g. when resuming a saved game.
+        void Reset(const uint64_t uiTick)
+        {
+            for (auto& level : m_Levels)
+            {
+                for (std::vector<Timer>& rSlot : level)
+                {
+                    rSlot.clear();
+                }
+            }
+
+            m_Overflow.clear();
+            m_uiCurrentTick = uiTick;
+        }
+
+        // Timers due at or before the current tick will fire on the next Advance.
+        void Schedule(uint64_t uiTick, const T& value)
+        {
+            if (uiTick <= m_uiCurrentTick)
+            {
+                uiTick = m_uiCurrentTick + 1;
+            }
+
+            File({uiTick, value});
+        }
+
+        // Moves the wheel forward a single tick, invoking callback(const Timer&) for every timer due on it. The callback
+        // may schedule new timers.
+        template <typename TCallback>
+        void Advance(TCallback&& callback)
+        {
+            ++m_uiCurrentTick;
+
+            for (int32_t iLevel = Levels - 1; iLevel > 0; --iLevel)
+            {
+                const uint64_t uiLowerMask = (1ULL << (SlotBits * iLevel)) - 1;
+                if ((m_uiCurrentTick & uiLowerMask) == 0)
+                {
+                    Cascade(m_Levels[iLevel][GetSlot(m_uiCurrentTick, iLevel)]);
+                }
+            }
+
+            if ((m_uiCurrentTick & c_uiHorizonMask) == 0)
+            {
+                Cascade(m_Overflow);
+            }
+
+            std::vector<Timer>& rDue = m_Levels[0][GetSlot(m_uiCurrentTick, 0)];
+
+            // Indexing rather than iterating, as the callback may file into other slots.
+            for (size_t i = 0; i < rDue.size(); ++i)
+            {
+                assert(rDue[i].m_uiTick == m_uiCurrentTick);
+                callback(rDue[i]);
+            }
+
+            rDue.clear();
+        }
+
+    private:
+        static constexpr uint32_t c_uiSlotCount = 1U << SlotBits;
+        static constexpr uint64_t c_uiSlotMask = c_uiSlotCount - 1;
+        static constexpr uint64_t c_uiHorizonMask = (1ULL << (SlotBits * Levels)) - 1;
+
+        static uint64_t GetSlot(const uint64_t uiTick, const uint32_t uiLevel)
+        {
+            return (uiTick >> (SlotBits * uiLevel)) & c_uiSlotMask;
+        }
+
+        void File(const Timer& timer)
+        {
+            assert(timer.m_uiTick > m_uiCurrentTick);
+
+            const uint32_t uiHighestDifferingBit = std::bit_width(timer.m_uiTick ^ m_uiCurrentTick) - 1;
+            const uint32_t uiLevel = uiHighestDifferingBit / SlotBits;
+            if (uiLevel >= Levels)
+            {
+                m_Overflow.push_back(timer);
+                return;
+            }
+
+            m_Levels[uiLevel][GetSlot(timer.m_uiTick, uiLevel)].push_back(timer);
+        }
+
+        void Cascade(std::vector<Timer>& rTimers)
+        {
+            m_CascadeScratch.swap(rTimers);
+            for (const Timer& timer : m_CascadeScratch)
+            {
+                if (timer.m_uiTick == m_uiCurrentTick)
+                {
+                    m_Levels[0][GetSlot(m_uiCurrentTick, 0)].push_back(timer);
+                }
+                else
+                {
+                    File(timer);
+                }
+            }
+
+            m_CascadeScratch.clear();
+        }
+
+        uint64_t m_uiCurrentTick = 0;
+        std::array<std::array<std::vector<Timer>, c_uiSlotCount>, Levels> m_Levels;
+        std::vector<Timer> m_Overflow;
+        std::vector<Timer> m_CascadeScratch;
+    };
+}